@@ -0,0 +1,981 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "Benchmark.h"
+#include "BlockCompressor.h"
+#include "Camera.h"
+#include "ColorConversion.h"
+#include "Utils.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "TangentGenerator.h"
+#include "TextureStreamer.h"
+#include "Meshlets.h"
+#include "MeshCodec.h"
+#include "MeshCleanup.h"
+#include "MipGenerator.h"
+#include "PixelConversion.h"
+#include "PositionStream.h"
+#include "VertexPacking.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Runs the function a few times and returns the fastest run in milliseconds
+	template<typename Function>
+	double MeasureBest(Function&& function, uint32_t numRuns = 5)
+	{
+		double best{ DBL_MAX };
+		for (uint32_t run = 0; run < numRuns; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			function();
+			const auto end = std::chrono::high_resolution_clock::now();
+
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+void Benchmark::Run(const std::string& objFile)
+{
+	ParseOBJ(objFile);
+	Tangents(objFile);
+	Cleanup(objFile);
+	MeshCache(objFile);
+	VertexCache(objFile);
+	Overdraw(objFile);
+	VertexFetch(objFile);
+	VertexPacking(objFile);
+	Meshlets(objFile);
+	PositionStream(objFile);
+	Simplify(objFile);
+	MeshCodec(objFile);
+
+	MipChain("Resources/vehicle_diffuse.png", TextureUsage::Color);
+	MipChain("Resources/vehicle_normal.png", TextureUsage::Normal);
+	BlockCompression("Resources/vehicle_diffuse.png", TextureUsage::Color);
+	BlockCompression("Resources/vehicle_normal.png", TextureUsage::Normal);
+	BlockCompression("Resources/vehicle_specular.png", TextureUsage::Data);
+	BlockCompression("Resources/vehicle_gloss.png", TextureUsage::Data);
+	TextureStreaming(8 * 1024 * 1024);
+	ColorConversion();
+	PixelConversion();
+}
+
+void Benchmark::ParseOBJ(const std::string& objFile)
+{
+	std::cout << "--- ParseOBJ: " << objFile << " ---\n";
+
+	std::ifstream file(objFile, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		std::cout << "File not found\n";
+		return;
+	}
+	const double fileSizeMB = static_cast<double>(file.tellg()) / (1024.0 * 1024.0);
+
+	//Serial parse is the reference every thread count has to match exactly
+	std::vector<Vertex_PosTex> referenceVertices{};
+	std::vector<uint32_t> referenceIndices{};
+	Utils::ParseOBJ(objFile, referenceVertices, referenceIndices, true, 1);
+	std::cout << referenceVertices.size() << " vertices, " << referenceIndices.size() / 3 << " triangles, " << fileSizeMB << " MB\n";
+
+	std::vector<uint32_t> threadCounts{};
+	const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32_t numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	const std::streamsize precision = std::cout.precision();
+	double serialTime{};
+	for (uint32_t numThreads : threadCounts)
+	{
+		std::vector<Vertex_PosTex> vertices{};
+		std::vector<uint32_t> indices{};
+		const double time = MeasureBest([&]() { Utils::ParseOBJ(objFile, vertices, indices, true, numThreads); });
+		if (numThreads == 1)
+			serialTime = time;
+
+		const bool isIdentical = vertices.size() == referenceVertices.size() && indices == referenceIndices
+			&& memcmp(vertices.data(), referenceVertices.data(), vertices.size() * sizeof(Vertex_PosTex)) == 0;
+
+		std::cout << std::setw(3) << numThreads << " threads: " << std::fixed << std::setprecision(2)
+			<< std::setw(8) << time << " ms, " << std::setw(8) << fileSizeMB / (time / 1000.0) << " MB/s, x"
+			<< serialTime / time << (isIdentical ? "" : "  OUTPUT DIFFERS") << '\n';
+		std::cout.unsetf(std::ios::fixed);
+		std::cout.precision(precision);
+	}
+}
+
+void Benchmark::Tangents(const std::string& objFile)
+{
+	std::cout << "--- Tangents: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> referenceVertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objFile, referenceVertices, indices))
+		return;
+
+	//Serial run is the reference every thread count has to match exactly
+	TangentGenerator::Generate(referenceVertices, indices, 1);
+	const size_t numMirrored = std::count_if(referenceVertices.begin(), referenceVertices.end(), [](const Vertex_PosTex& vertex) { return vertex.tangent.w < 0.f; });
+	std::cout << referenceVertices.size() << " vertices, " << numMirrored << " with mirrored uvs\n";
+
+	std::vector<uint32_t> threadCounts{};
+	const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32_t numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	const std::streamsize precision = std::cout.precision();
+	double serialTime{};
+	for (uint32_t numThreads : threadCounts)
+	{
+		std::vector<Vertex_PosTex> vertices = referenceVertices;
+		const double time = MeasureBest([&]() { TangentGenerator::Generate(vertices, indices, numThreads); });
+		if (numThreads == 1)
+			serialTime = time;
+
+		const bool isIdentical = memcmp(vertices.data(), referenceVertices.data(), vertices.size() * sizeof(Vertex_PosTex)) == 0;
+
+		std::cout << std::setw(3) << numThreads << " threads: " << std::fixed << std::setprecision(3)
+			<< std::setw(8) << time << " ms, x" << serialTime / time << (isIdentical ? "" : "  OUTPUT DIFFERS") << '\n';
+		std::cout.unsetf(std::ios::fixed);
+		std::cout.precision(precision);
+	}
+}
+
+void Benchmark::Cleanup(const std::string& objFile)
+{
+	std::cout << "--- Cleanup: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> parsedVertices{};
+	std::vector<uint32_t> parsedIndices{};
+	if (!Utils::ParseOBJ(objFile, parsedVertices, parsedIndices))
+		return;
+
+	//0 only merges exact copies, the default tolerance is 1e-5
+	for (float tolerance : { 0.f, 1e-5f, 1e-4f })
+	{
+		std::vector<Vertex_PosTex> vertices{};
+		std::vector<uint32_t> indices{};
+		MeshCleanup::Statistics statistics{};
+		const double time = MeasureBest([&]()
+			{
+				vertices = parsedVertices;
+				indices = parsedIndices;
+				statistics = MeshCleanup::Clean(vertices, indices, tolerance);
+			}, 3);
+
+		std::cout << "Tolerance " << tolerance << ": " << parsedVertices.size() << " -> " << vertices.size() << " vertices, "
+			<< parsedIndices.size() / 3 << " -> " << indices.size() / 3 << " triangles (welded " << statistics.numWeldedPositions
+			<< ", merged " << statistics.numMergedVertices << ", degenerate " << statistics.numDegenerateTriangles
+			<< ", duplicate " << statistics.numDuplicateTriangles << ") in " << time << " ms\n";
+	}
+}
+
+void Benchmark::MeshCache(const std::string& objFile)
+{
+	std::cout << "--- MeshCache: " << objFile << " ---\n";
+
+	//Make sure an up to date cache exists before timing the reload
+	{
+		const dae::MeshCache mesh{ objFile };
+		if (!mesh.IsValid())
+			return;
+	}
+
+	const double parseTime = MeasureBest([&]()
+		{
+			std::vector<Vertex_PosTex> vertices{};
+			std::vector<uint32_t> indices{};
+			Utils::ParseOBJ(objFile, vertices, indices);
+		});
+
+	bool isFromCache{};
+	const double cacheTime = MeasureBest([&]()
+		{
+			const dae::MeshCache mesh{ objFile };
+			isFromCache = mesh.IsFromCache();
+		});
+
+	std::cout << "Parse: " << parseTime << " ms, cache load: " << cacheTime << " ms"
+		<< (isFromCache ? "" : " (cache could not be used)") << '\n';
+
+	std::error_code error{};
+	std::cout << "Source: " << std::filesystem::file_size(objFile, error) / 1024 << " KB, cache: "
+		<< std::filesystem::file_size(dae::MeshCache::GetCachePath(objFile), error) / 1024 << " KB\n";
+}
+
+void Benchmark::VertexCache(const std::string& objFile)
+{
+	std::cout << "--- VertexCache: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> vertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objFile, vertices, indices))
+		return;
+
+	std::vector<uint32_t> optimized{};
+	const double time = MeasureBest([&]()
+		{
+			optimized = indices;
+			MeshOptimizer::OptimizeVertexCache(optimized, vertices.size());
+		});
+
+	//Real hardware ranges from small FIFOs to large batched caches
+	for (uint32_t cacheSize : { 16u, 32u })
+	{
+		const MeshOptimizer::VertexCacheStatistics before = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size(), cacheSize);
+		const MeshOptimizer::VertexCacheStatistics after = MeshOptimizer::AnalyzeVertexCache(optimized, vertices.size(), cacheSize);
+
+		std::cout << "FIFO " << cacheSize << ": ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << '\n';
+	}
+	std::cout << "Optimization took " << time << " ms\n";
+}
+
+void Benchmark::Overdraw(const std::string& objFile)
+{
+	std::cout << "--- Overdraw: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> vertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objFile, vertices, indices))
+		return;
+
+	MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+	const MeshOptimizer::OverdrawStatistics before = MeshOptimizer::AnalyzeOverdraw(indices, vertices);
+	const float acmrBefore = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()).acmr;
+	std::cout << "Vertex cache order: overdraw " << before.overdraw << ", ACMR " << acmrBefore << '\n';
+
+	//Higher thresholds give smaller clusters, trading vertex cache efficiency for a better sort
+	for (float threshold : { 1.01f, 1.05f, 1.2f })
+	{
+		std::vector<uint32_t> sorted = indices;
+		const double time = MeasureBest([&]()
+			{
+				sorted = indices;
+				MeshOptimizer::OptimizeOverdraw(sorted, vertices, threshold);
+			});
+
+		const MeshOptimizer::OverdrawStatistics after = MeshOptimizer::AnalyzeOverdraw(sorted, vertices);
+		std::cout << "Threshold " << threshold << ": overdraw " << after.overdraw << ", ACMR "
+			<< MeshOptimizer::AnalyzeVertexCache(sorted, vertices.size()).acmr << ", " << time << " ms\n";
+	}
+}
+
+void Benchmark::VertexFetch(const std::string& objFile)
+{
+	std::cout << "--- VertexFetch: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> vertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objFile, vertices, indices))
+		return;
+
+	MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+	MeshOptimizer::OptimizeOverdraw(indices, vertices);
+	const MeshOptimizer::VertexFetchStatistics before = MeshOptimizer::AnalyzeVertexFetch(indices, vertices.size(), sizeof(Vertex_PosTex));
+
+	const double time = MeasureBest([&]()
+		{
+			std::vector<Vertex_PosTex> remappedVertices = vertices;
+			std::vector<uint32_t> remappedIndices = indices;
+			MeshOptimizer::OptimizeVertexFetch(remappedVertices, remappedIndices);
+		});
+
+	MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+	const MeshOptimizer::VertexFetchStatistics after = MeshOptimizer::AnalyzeVertexFetch(indices, vertices.size(), sizeof(Vertex_PosTex));
+
+	std::cout << "Parse order: " << before.linesFetched << " lines, " << before.bytesFetched / 1024 << " KB, overfetch " << before.overfetch << '\n';
+	std::cout << "First use order: " << after.linesFetched << " lines, " << after.bytesFetched / 1024 << " KB, overfetch " << after.overfetch << '\n';
+	std::cout << "Remap took " << time << " ms\n";
+}
+
+void Benchmark::VertexPacking(const std::string& objFile)
+{
+	std::cout << "--- VertexPacking: " << objFile << " ---\n";
+
+	const dae::MeshCache mesh{ objFile };
+	if (!mesh.IsValid())
+		return;
+
+	const Vector3& boundsMin = mesh.GetBoundsMin();
+	const Vector3& boundsMax = mesh.GetBoundsMax();
+	const std::vector<uint32_t> indices(mesh.GetIndices(), mesh.GetIndices() + mesh.GetNumIndices());
+
+	std::vector<Vertex_PosTexPacked> packed{};
+	const double time = MeasureBest([&]()
+		{
+			dae::VertexPacking::PackVertices(mesh.GetVertices(), mesh.GetNumVertices(), boundsMin, boundsMax, packed);
+		});
+
+	const dae::VertexPacking::PackingError error = dae::VertexPacking::MeasureError(mesh.GetVertices(), packed.data(), mesh.GetNumVertices(), boundsMin, boundsMax);
+	const dae::VertexPacking::PackingError bound = dae::VertexPacking::GetErrorBound(boundsMin, boundsMax);
+
+	const MeshOptimizer::VertexFetchStatistics floatFetch = MeshOptimizer::AnalyzeVertexFetch(indices, mesh.GetNumVertices(), sizeof(Vertex_PosTex));
+	const MeshOptimizer::VertexFetchStatistics packedFetch = MeshOptimizer::AnalyzeVertexFetch(indices, mesh.GetNumVertices(), sizeof(Vertex_PosTexPacked));
+
+	std::cout << "Float: " << sizeof(Vertex_PosTex) << " bytes/vertex, " << sizeof(Vertex_PosTex) * mesh.GetNumVertices() / 1024 << " KB, "
+		<< floatFetch.bytesFetched / 1024 << " KB fetched\n";
+	std::cout << "Packed: " << sizeof(Vertex_PosTexPacked) << " bytes/vertex, " << sizeof(Vertex_PosTexPacked) * mesh.GetNumVertices() / 1024 << " KB, "
+		<< packedFetch.bytesFetched / 1024 << " KB fetched\n";
+	std::cout << "Max error: position " << error.position << " (bound " << bound.position << "), normal " << error.normalDegrees
+		<< " deg, tangent " << error.tangentDegrees << " deg (bound " << bound.normalDegrees << "), uv " << error.uv << " (bound " << bound.uv << ")\n";
+	std::cout << (error.position <= bound.position && error.normalDegrees <= bound.normalDegrees && error.tangentDegrees <= bound.tangentDegrees && error.uv <= bound.uv
+		? "Within bounds\n" : "OUT OF BOUNDS\n");
+	std::cout << "Packing took " << time << " ms\n";
+}
+
+void Benchmark::Meshlets(const std::string& objFile)
+{
+	std::cout << "--- Meshlets: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> vertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objFile, vertices, indices))
+		return;
+
+	MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+	MeshOptimizer::OptimizeOverdraw(indices, vertices);
+
+	std::vector<Meshlet> meshlets{};
+	const double buildTime = MeasureBest([&]()
+		{
+			std::vector<uint32_t> sortedIndices = indices;
+			dae::Meshlets::Build(sortedIndices, vertices, meshlets);
+		});
+	dae::Meshlets::Build(indices, vertices, meshlets);
+
+	uint32_t numWithoutCone{};
+	for (const Meshlet& meshlet : meshlets)
+	{
+		numWithoutCone += meshlet.coneCutoff >= 1.f;
+	}
+
+	std::cout << meshlets.size() << " meshlets, " << float(indices.size() / 3) / meshlets.size() << " triangles and "
+		<< float(std::accumulate(meshlets.begin(), meshlets.end(), 0u, [](uint32_t sum, const Meshlet& meshlet) { return sum + meshlet.numVertices; })) / meshlets.size()
+		<< " vertices on average, " << numWithoutCone << " without a usable cone, built in " << buildTime << " ms\n";
+
+	//Same camera as the scenes, the mesh turns in front of it like the rotating vehicle does
+	constexpr uint32_t numSteps{ 36 };
+	for (const float distance : { 50.f, 15.f })
+	{
+		const Camera camera{ { 0.f, 0.f, -distance }, 45.f, 640.f / 480.f };
+
+		dae::Meshlets::CullStatistics total{};
+		std::vector<DrawRange> drawRanges{};
+		double cullTime{};
+		for (uint32_t step = 0; step < numSteps; ++step)
+		{
+			const float angle = step * (2.f * PI / numSteps);
+			const Matrix world = Matrix::CreateRotation(0.5f * sinf(angle), angle, 0.f);
+
+			dae::Meshlets::CullStatistics statistics{};
+			cullTime += MeasureBest([&]()
+				{
+					statistics = dae::Meshlets::Cull(meshlets, world, camera.GetViewMatrix(), camera.GetProjectionMatrix(), true, drawRanges);
+				});
+
+			total.numMeshlets += statistics.numMeshlets;
+			total.numFrustumCulled += statistics.numFrustumCulled;
+			total.numBackfaceCulled += statistics.numBackfaceCulled;
+			total.numTriangles += statistics.numTriangles;
+			total.numTrianglesDrawn += statistics.numTrianglesDrawn;
+			total.numDrawRanges += statistics.numDrawRanges;
+		}
+
+		std::cout << "Distance " << distance << ": " << 100.f * total.numFrustumCulled / total.numMeshlets << "% frustum culled, "
+			<< 100.f * total.numBackfaceCulled / total.numMeshlets << "% back face culled, "
+			<< 100.f * (total.numTriangles - total.numTrianglesDrawn) / total.numTriangles << "% of the triangles skipped, "
+			<< float(total.numDrawRanges) / numSteps << " draws, " << cullTime / numSteps << " ms per cull\n";
+	}
+}
+
+void Benchmark::PositionStream(const std::string& objFile)
+{
+	std::cout << "--- PositionStream: " << objFile << " ---\n";
+
+	const dae::MeshCache mesh{ objFile, true, true };
+	if (!mesh.IsValid())
+		return;
+
+	std::vector<Vector3> positions{};
+	std::vector<uint32_t> positionIndices{};
+	const double extractTime = MeasureBest([&]()
+		{
+			dae::PositionStream::Extract(mesh.GetVertices(), mesh.GetNumVertices(), mesh.GetIndices(), mesh.GetNumIndices(), positions, positionIndices);
+		});
+
+	std::cout << mesh.GetNumVertices() << " vertices, " << mesh.GetNumPositions() << " positions, "
+		<< sizeof(Vertex_PosTex) * mesh.GetNumVertices() / 1024 << " KB -> " << sizeof(Vector3) * mesh.GetNumPositions() / 1024 << " KB, extracted in " << extractTime << " ms\n";
+
+	//Bounds of the whole mesh, from every vertex against every position
+	Vector3 vertexMin{}, vertexMax{}, positionMin{}, positionMax{};
+	const double vertexBoundsTime = MeasureBest([&]()
+		{
+			vertexMin = vertexMax = mesh.GetVertices()[0].position;
+			for (uint32_t index = 0; index < mesh.GetNumVertices(); ++index)
+			{
+				const Vector3& position = mesh.GetVertices()[index].position;
+				vertexMin = Vector3{ std::min(vertexMin.x, position.x), std::min(vertexMin.y, position.y), std::min(vertexMin.z, position.z) };
+				vertexMax = Vector3{ std::max(vertexMax.x, position.x), std::max(vertexMax.y, position.y), std::max(vertexMax.z, position.z) };
+			}
+		}, 20);
+	const double positionBoundsTime = MeasureBest([&]()
+		{
+			dae::PositionStream::ComputeBounds(mesh.GetPositions(), mesh.GetNumPositions(), positionMin, positionMax);
+		}, 20);
+
+	//Meshlet spheres and cones read through either index buffer must come out the same
+	std::vector<Meshlet> vertexMeshlets(mesh.GetMeshlets(), mesh.GetMeshlets() + mesh.GetNumMeshlets());
+	std::vector<Meshlet> positionMeshlets(vertexMeshlets);
+	const double vertexMeshletTime = MeasureBest([&]()
+		{
+			for (Meshlet& meshlet : vertexMeshlets)
+			{
+				dae::Meshlets::ComputeBounds(meshlet, mesh.GetIndices(), mesh.GetVertices());
+			}
+		});
+	const double positionMeshletTime = MeasureBest([&]()
+		{
+			for (Meshlet& meshlet : positionMeshlets)
+			{
+				dae::Meshlets::ComputeBounds(meshlet, mesh.GetPositionIndices(), mesh.GetPositions());
+			}
+		});
+
+	const bool isIdentical = memcmp(&vertexMin, &positionMin, sizeof(Vector3)) == 0 && memcmp(&vertexMax, &positionMax, sizeof(Vector3)) == 0
+		&& memcmp(vertexMeshlets.data(), positionMeshlets.data(), vertexMeshlets.size() * sizeof(Meshlet)) == 0;
+
+	std::cout << "Bounds: " << vertexBoundsTime << " ms from the vertices, " << positionBoundsTime << " ms from the positions\n";
+	std::cout << "Meshlet bounds: " << vertexMeshletTime << " ms from the vertices, " << positionMeshletTime << " ms from the positions\n";
+	std::cout << (isIdentical ? "Identical results\n" : "RESULTS DIFFER\n");
+}
+
+void Benchmark::Simplify(const std::string& objFile)
+{
+	std::cout << "--- Simplify: " << objFile << " ---\n";
+
+	std::vector<Vertex_PosTex> vertices{};
+	std::vector<uint32_t> indices{};
+	if (!Utils::ParseOBJ(objFile, vertices, indices))
+		return;
+
+	MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+
+	std::vector<LevelOfDetail> lods{};
+	const double time = MeasureBest([&]()
+		{
+			std::vector<uint32_t> chain = indices;
+			MeshSimplifier::BuildLODChain(chain, vertices, lods);
+		}, 1);
+	MeshSimplifier::BuildLODChain(indices, vertices, lods);
+
+	//Same projection as the scenes, the distance from which each level stays within a pixel
+	const float projectionScale = 1.f / tanf(45.f * TO_RADIANS * 0.5f);
+	constexpr float screenHeight{ 480.f };
+
+	for (size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		std::vector<bool> isUsed(vertices.size(), false);
+		for (uint32_t i = lods[lod].indexOffset; i < lods[lod].indexOffset + lods[lod].numIndices; ++i)
+		{
+			isUsed[indices[i]] = true;
+		}
+
+		std::cout << "LOD " << lod << ": " << lods[lod].numIndices / 3 << " triangles (" << 100.f * lods[lod].numIndices / lods[0].numIndices << "%), "
+			<< std::count(isUsed.begin(), isUsed.end(), true) << " vertices, error " << lods[lod].error
+			<< ", from distance " << lods[lod].error * projectionScale * screenHeight * 0.5f << '\n';
+	}
+	std::cout << "Index buffer grows from " << lods[0].numIndices * sizeof(uint32_t) / 1024 << " KB to " << indices.size() * sizeof(uint32_t) / 1024
+		<< " KB, building the chain took " << time << " ms\n";
+}
+
+void Benchmark::MeshCodec(const std::string& objFile)
+{
+	std::cout << "--- MeshCodec: " << objFile << " ---\n";
+
+	const dae::MeshCache mesh{ objFile };
+	if (!mesh.IsValid())
+		return;
+
+	std::vector<Vertex_PosTexPacked> packed{};
+	dae::VertexPacking::PackVertices(mesh.GetVertices(), mesh.GetNumVertices(), mesh.GetBoundsMin(), mesh.GetBoundsMax(), packed);
+
+	//The parse order shows how much of the index ratio comes from the first use order the cache is stored in
+	std::vector<Vertex_PosTex> parsedVertices{};
+	std::vector<uint32_t> parsedIndices{};
+	Utils::ParseOBJ(objFile, parsedVertices, parsedIndices);
+
+	//Decoding is timed on one core with every kernel the processor has, AVX2 runs the SSSE3 ones
+	const char* instructionSetNames[]{ "SSE2", "SSSE3" };
+	const uint32_t numInstructionSets = std::min(static_cast<uint32_t>(dae::PixelConversion::GetInstructionSet()), 1u) + 1;
+
+	const std::streamsize precision = std::cout.precision();
+	const auto report = [&](const char* name, size_t rawSize, size_t encodedSize, double encodeTime)
+		{
+			std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(8) << rawSize / 1024.0 << " KB -> " << std::setw(8) << encodedSize / 1024.0 << " KB, x" << double(rawSize) / encodedSize
+				<< ", encode " << std::setprecision(3) << encodeTime << " ms\n";
+			std::cout.unsetf(std::ios::fixed);
+			std::cout.precision(precision);
+		};
+	const auto reportDecode = [&](uint32_t instructionSet, size_t rawSize, double decodeTime, bool isIdentical)
+		{
+			std::cout << std::setw(16) << "" << "decode " << std::left << std::setw(6) << instructionSetNames[instructionSet] << std::right
+				<< std::fixed << std::setprecision(3) << std::setw(8) << decodeTime << " ms, "
+				<< std::setprecision(2) << rawSize / (decodeTime / 1000.0) / (1024.0 * 1024.0 * 1024.0) << " GB/s"
+				<< (isIdentical ? "" : "  ROUND TRIP DIFFERS") << '\n';
+			std::cout.unsetf(std::ios::fixed);
+			std::cout.precision(precision);
+		};
+
+	const auto measureIndices = [&](const char* name, const uint32_t* pIndices, size_t numIndices)
+		{
+			std::vector<uint8_t> encoded{};
+			const double encodeTime = MeasureBest([&]() { dae::MeshCodec::EncodeIndexBuffer(pIndices, numIndices, encoded); });
+			report(name, numIndices * sizeof(uint32_t), encoded.size(), encodeTime);
+			std::cout << std::setw(16) << "" << encoded.size() * 8.0 / (numIndices / 3) << " bits per triangle\n";
+
+			std::vector<uint32_t> decoded(numIndices);
+			for (uint32_t instructionSet = 0; instructionSet < numInstructionSets; ++instructionSet)
+			{
+				bool isValid{};
+				const double decodeTime = MeasureBest([&]()
+					{
+						isValid = dae::MeshCodec::DecodeIndexBuffer(decoded.data(), numIndices, encoded.data(), encoded.size(), static_cast<dae::PixelConversion::InstructionSet>(instructionSet));
+					}, 20);
+				reportDecode(instructionSet, numIndices * sizeof(uint32_t), decodeTime, isValid && std::equal(decoded.begin(), decoded.end(), pIndices));
+			}
+		};
+
+	const auto measureVertices = [&](const char* name, const void* pVertices, size_t numVertices, size_t vertexSize)
+		{
+			std::vector<uint8_t> encoded{};
+			const double encodeTime = MeasureBest([&]() { dae::MeshCodec::EncodeVertexBuffer(pVertices, numVertices, vertexSize, encoded); });
+			report(name, numVertices * vertexSize, encoded.size(), encodeTime);
+
+			std::vector<uint8_t> decoded(numVertices * vertexSize);
+			for (uint32_t instructionSet = 0; instructionSet < numInstructionSets; ++instructionSet)
+			{
+				bool isValid{};
+				const double decodeTime = MeasureBest([&]()
+					{
+						isValid = dae::MeshCodec::DecodeVertexBuffer(decoded.data(), numVertices, vertexSize, encoded.data(), encoded.size(), static_cast<dae::PixelConversion::InstructionSet>(instructionSet));
+					}, 20);
+				reportDecode(instructionSet, decoded.size(), decodeTime, isValid && memcmp(decoded.data(), pVertices, decoded.size()) == 0);
+			}
+		};
+
+	measureIndices("Indices (parse)", parsedIndices.data(), parsedIndices.size());
+	measureIndices("Indices", mesh.GetIndices(), mesh.GetNumIndices());
+	measureVertices("Vertices", mesh.GetVertices(), mesh.GetNumVertices(), sizeof(Vertex_PosTex));
+	measureVertices("Packed vertices", packed.data(), packed.size(), sizeof(Vertex_PosTexPacked));
+}
+
+void Benchmark::MipChain(const std::string& imageFile, TextureUsage usage)
+{
+	std::cout << "--- MipChain: " << imageFile << " ---\n";
+
+	SDL_Surface* pLoaded = IMG_Load(imageFile.c_str());
+	if (!pLoaded)
+	{
+		std::cout << "File not found\n";
+		return;
+	}
+	SDL_Surface* pSurface = SDL_ConvertSurfaceFormat(pLoaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(pLoaded);
+
+	const uint8_t* pPixels = static_cast<const uint8_t*>(pSurface->pixels);
+	const uint32_t width = pSurface->w;
+	const uint32_t height = pSurface->h;
+	const uint32_t rowPitch = pSurface->pitch;
+	std::cout << width << "x" << height << ", " << MipGenerator::GetNumLevels(width, height) << " levels\n";
+
+	std::vector<uint32_t> threadCounts{};
+	const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	for (uint32_t numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+	{
+		threadCounts.push_back(numThreads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	const std::streamsize precision = std::cout.precision();
+	for (MipGenerator::Filter filter : { MipGenerator::Filter::Box, MipGenerator::Filter::Kaiser })
+	{
+		//Serial run is the reference every thread count has to match exactly
+		TextureData reference{};
+		MipGenerator::Generate(pPixels, width, height, rowPitch, usage, filter, reference, 1);
+		std::cout << (filter == MipGenerator::Filter::Box ? "Box" : "Kaiser") << ": " << reference.data.size() / 1024
+			<< " KB for the chain, " << reference.GetLevelSize(0) / 1024 << " KB for level 0\n";
+
+		double serialTime{};
+		for (uint32_t numThreads : threadCounts)
+		{
+			TextureData texture{};
+			const double time = MeasureBest([&]() { MipGenerator::Generate(pPixels, width, height, rowPitch, usage, filter, texture, numThreads); });
+			if (numThreads == 1)
+				serialTime = time;
+
+			std::cout << std::setw(3) << numThreads << " threads: " << std::fixed << std::setprecision(2)
+				<< std::setw(8) << time << " ms, " << std::setw(8) << width * height / (time * 1000.0) << " Mtexels/s, x"
+				<< serialTime / time << (texture.data == reference.data ? "" : "  OUTPUT DIFFERS") << '\n';
+			std::cout.unsetf(std::ios::fixed);
+			std::cout.precision(precision);
+		}
+	}
+
+	SDL_FreeSurface(pSurface);
+}
+
+void Benchmark::BlockCompression(const std::string& imageFile, TextureUsage usage)
+{
+	std::cout << "--- BlockCompression: " << imageFile << " ---\n";
+
+	SDL_Surface* pLoaded = IMG_Load(imageFile.c_str());
+	if (!pLoaded)
+	{
+		std::cout << "File not found\n";
+		return;
+	}
+	SDL_Surface* pSurface = SDL_ConvertSurfaceFormat(pLoaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(pLoaded);
+
+	//The whole chain gets compressed, like the cooked texture would be
+	TextureData texture{};
+	MipGenerator::Generate(static_cast<const uint8_t*>(pSurface->pixels), pSurface->w, pSurface->h, pSurface->pitch, usage, MipGenerator::Filter::Kaiser, texture);
+	SDL_FreeSurface(pSurface);
+
+	const std::streamsize precision = std::cout.precision();
+	for (BlockCompressor::Quality quality : { BlockCompressor::Quality::Fast, BlockCompressor::Quality::High })
+	{
+		const TextureFormat format = BlockCompressor::ChooseFormat(texture, usage, quality);
+
+		//Serial run is the reference every thread count has to match exactly
+		TextureData reference{};
+		const double serialTime = MeasureBest([&]() { BlockCompressor::Compress(texture, format, quality, reference, 1); }, 1);
+		const double psnr = BlockCompressor::ComputePSNR(texture, reference);
+
+		std::cout << (quality == BlockCompressor::Quality::Fast ? "Fast" : "High") << ": " << GetFormatName(format) << ", "
+			<< texture.data.size() / 1024 << " KB -> " << reference.data.size() / 1024 << " KB, x" << std::fixed << std::setprecision(2)
+			<< double(texture.data.size()) / reference.data.size() << ", PSNR " << psnr << " dB, " << serialTime << " ms\n";
+
+		const uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		if (maxThreads > 1)
+		{
+			TextureData compressed{};
+			const double time = MeasureBest([&]() { BlockCompressor::Compress(texture, format, quality, compressed, maxThreads); }, 1);
+			std::cout << std::setw(3) << maxThreads << " threads: " << std::setw(8) << time << " ms, x" << serialTime / time
+				<< (compressed.data == reference.data ? "" : "  OUTPUT DIFFERS") << '\n';
+		}
+		std::cout.unsetf(std::ios::fixed);
+		std::cout.precision(precision);
+	}
+}
+
+void Benchmark::TextureStreaming(size_t budget)
+{
+	std::cout << "--- TextureStreaming: " << budget / 1024 << " KB budget ---\n";
+
+	//A corridor of props with a cooked vehicle's maps each, the camera flies along it without any GPU involved
+	struct Prop
+	{
+		float z{};
+		float radius{};
+		uint32_t textures[3]{};
+	};
+	constexpr uint32_t numProps{ 16 };
+	constexpr float spacing{ 25.f };
+	constexpr uint32_t numFrames{ 600 };
+	constexpr float screenHeight{ 720.f };
+	constexpr float farPlane{ 100.f };
+	const float projectionScale = 1.f / std::tan(45.f * TO_RADIANS * 0.5f);
+
+	const auto run = [&](size_t streamerBudget, bool isPrinted)
+		{
+			TextureStreamer streamer{ streamerBudget };
+			std::vector<Prop> props(numProps);
+			for (uint32_t prop = 0; prop < numProps; ++prop)
+			{
+				props[prop].z = prop * spacing;
+				props[prop].radius = prop % 3 == 0 ? 8.f : 4.f;
+				props[prop].textures[0] = streamer.AddTexture(TextureFormat::BC1, 1024, 1024, 11);
+				props[prop].textures[1] = streamer.AddTexture(TextureFormat::BC5, 1024, 1024, 11);
+				props[prop].textures[2] = streamer.AddTexture(TextureFormat::BC3, 1024, 1024, 11);
+			}
+			const size_t tailSize = streamer.GetResidentSize();
+
+			std::vector<TextureStreamer::Change> changes{};
+			std::vector<const Prop*> visibleProps{};
+			size_t maxResidentSize{};
+			uint64_t missingLevels{};
+			double updateTime{};
+			for (uint32_t frame = 0; frame < numFrames; ++frame)
+			{
+				//Fly forward at a constant speed, only the props in front of the camera and closer than the far plane ask for their textures
+				const float cameraZ = -20.f + frame * (numProps * spacing / numFrames);
+				visibleProps.clear();
+				for (const Prop& prop : props)
+				{
+					const float distance = prop.z - cameraZ;
+					if (distance < -prop.radius || distance > farPlane)
+						continue;
+
+					visibleProps.push_back(&prop);
+					const float screenSize = TextureStreamer::GetScreenSize(prop.radius, distance - prop.radius, projectionScale, screenHeight);
+					for (uint32_t texture : prop.textures)
+					{
+						streamer.RequestTexture(texture, screenSize);
+					}
+				}
+
+				const auto start = std::chrono::high_resolution_clock::now();
+				streamer.Update(changes);
+				updateTime += std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+
+				//Levels the requests asked for that weren't resident yet, the cost of streaming in coarse first and of the budget
+				for (const Prop* pProp : visibleProps)
+				{
+					for (uint32_t texture : pProp->textures)
+					{
+						missingLevels += streamer.GetFirstLevel(texture) - std::min(streamer.GetFirstLevel(texture), streamer.GetWantedLevel(texture));
+					}
+				}
+				maxResidentSize = std::max(maxResidentSize, streamer.GetResidentSize());
+
+				if (isPrinted && frame % 100 == 99)
+				{
+					const TextureStreamer::Statistics& statistics = streamer.GetStatistics();
+					std::cout << "frame " << std::setw(3) << frame + 1 << ", camera at " << std::setw(5) << static_cast<int>(cameraZ) << ": "
+						<< std::setw(6) << streamer.GetResidentSize() / 1024 << " KB resident, " << std::setw(4) << statistics.numPromotions
+						<< " promotions, " << std::setw(4) << statistics.numEvictions << " evictions, " << std::setw(4) << statistics.numDenied << " denied\n";
+				}
+			}
+
+			const std::streamsize precision = std::cout.precision();
+			std::cout << (streamerBudget == SIZE_MAX ? "Unlimited" : "Budget") << ": peak " << maxResidentSize / 1024 << " KB (" << tailSize / 1024
+				<< " KB of mip tails), " << missingLevels << " missing levels over the frames, " << std::fixed << std::setprecision(2)
+				<< updateTime / numFrames << " us per update" << (maxResidentSize > std::max(streamerBudget, tailSize) ? "  OVER BUDGET" : "") << '\n';
+			std::cout.unsetf(std::ios::fixed);
+			std::cout.precision(precision);
+		};
+
+	std::cout << numProps << " props with a BC1, BC5 and BC3 texture of 1024x1024 each, " << numFrames << " frames\n";
+	run(budget, true);
+	run(SIZE_MAX, false);
+}
+
+void Benchmark::ColorConversion()
+{
+	std::cout << "--- ColorConversion ---\n";
+
+	//Every byte, every linear value from a bit below 0 to a bit above 1 and colors up to 8 times white
+	constexpr size_t count{ 1 << 22 };
+	std::vector<uint8_t> bytes(count);
+	std::vector<float> values(count);
+	std::vector<ColorRGB> colors(count / 3);
+	for (size_t i = 0; i < count; ++i)
+	{
+		bytes[i] = static_cast<uint8_t>(i * 7919);
+		values[i] = static_cast<float>(i) / count * 1.02f - 0.01f;
+	}
+	for (size_t i = 0; i < colors.size(); ++i)
+	{
+		colors[i] = ColorRGB{ static_cast<float>(i % 1024) / 128.f, static_cast<float>(i % 999) / 125.f, static_cast<float>(i % 97) / 12.f };
+	}
+
+	//The curves as the textbook writes them, one powf per value
+	const auto naiveToLinear = [](float srgb) { return srgb <= 0.04045f ? srgb / 12.92f : powf((srgb + 0.055f) / 1.055f, 2.4f); };
+	const auto naiveToSRGB = [](float linear)
+		{
+			linear = std::clamp(linear, 0.f, 1.f);
+			const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.f / 2.4f) - 0.055f;
+			return static_cast<uint8_t>(srgb * 255.f + 0.5f);
+		};
+
+	const std::streamsize precision = std::cout.precision();
+	const auto print = [&](const char* name, double naiveTime, double time, const std::string& accuracy)
+		{
+			std::cout << name << std::fixed << std::setprecision(2) << "scalar " << std::setw(7) << naiveTime << " ms, kernel " << std::setw(6) << time
+				<< " ms (" << std::setw(7) << count / (time * 1000.0) << " M values/s), x" << naiveTime / time << ", " << accuracy << '\n';
+			std::cout.unsetf(std::ios::fixed);
+			std::cout.precision(precision);
+		};
+
+	{
+		std::vector<float> naive(count), decoded(count);
+		const double naiveTime = MeasureBest([&]()
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					naive[i] = naiveToLinear(bytes[i] / 255.f);
+				}
+			});
+		const double time = MeasureBest([&]() { dae::ColorConversion::DecodeSRGB8(bytes.data(), decoded.data(), count); });
+
+		float maxError{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			maxError = std::max(maxError, std::abs(naive[i] - decoded[i]));
+		}
+		print("Decode:   ", naiveTime, time, "largest difference " + std::to_string(maxError));
+	}
+
+	{
+		std::vector<uint8_t> naive(count), encoded(count);
+		const double naiveTime = MeasureBest([&]()
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					naive[i] = naiveToSRGB(values[i]);
+				}
+			});
+		const double time = MeasureBest([&]() { dae::ColorConversion::EncodeSRGB8(values.data(), encoded.data(), count); });
+
+		//The float curve rounds a few values near the middle of two bytes the other way than the double precision one the kernel matches
+		size_t numDifferent{};
+		for (size_t i = 0; i < count; ++i)
+		{
+			numDifferent += naive[i] != encoded[i];
+		}
+		print("Encode:   ", naiveTime, time, std::to_string(numDifferent) + " bytes differ by rounding");
+	}
+
+	for (dae::ColorConversion::ToneMapper toneMapper : { dae::ColorConversion::ToneMapper::Reinhard, dae::ColorConversion::ToneMapper::ACES })
+	{
+		const bool isReinhard = toneMapper == dae::ColorConversion::ToneMapper::Reinhard;
+		const auto naiveToneMap = [&](float value)
+			{
+				value = std::max(value * 1.5f, 0.f);
+				return isReinhard ? value / (value + 1.f) : std::min(value * (value * 2.51f + 0.03f) / (value * (value * 2.43f + 0.59f) + 0.14f), 1.f);
+			};
+
+		std::vector<ColorRGB> naive{}, mapped{};
+		const double naiveTime = MeasureBest([&]()
+			{
+				naive = colors;
+				for (ColorRGB& color : naive)
+				{
+					color = ColorRGB{ naiveToneMap(color.r), naiveToneMap(color.g), naiveToneMap(color.b) };
+				}
+			});
+		const double time = MeasureBest([&]()
+			{
+				mapped = colors;
+				dae::ColorConversion::ToneMap(mapped.data(), mapped.size(), toneMapper, 1.5f);
+			});
+
+		float maxError{};
+		for (size_t i = 0; i < colors.size(); ++i)
+		{
+			maxError = std::max({ maxError, std::abs(naive[i].r - mapped[i].r), std::abs(naive[i].g - mapped[i].g), std::abs(naive[i].b - mapped[i].b) });
+		}
+		print(isReinhard ? "Reinhard: " : "ACES:     ", naiveTime, time, "largest difference " + std::to_string(maxError) + ", copy included");
+	}
+}
+
+void Benchmark::PixelConversion()
+{
+	std::cout << "--- PixelConversion ---\n";
+
+	//The layouts images load in, filled with noise so no kernel gets lucky
+	constexpr int size{ 2048 };
+	struct Source
+	{
+		const char* name;
+		uint32_t format;
+		bool isGray;
+	};
+	const Source sources[]
+	{
+		{ "RGB24:   ", SDL_PIXELFORMAT_RGB24, false },
+		{ "BGR24:   ", SDL_PIXELFORMAT_BGR24, false },
+		{ "BGRA32:  ", SDL_PIXELFORMAT_BGRA32, false },
+		{ "Gray8:   ", SDL_PIXELFORMAT_INDEX8, true },
+		{ "Palette8:", SDL_PIXELFORMAT_INDEX8, false }
+	};
+	const char* instructionSetNames[]{ "scalar", "SSSE3", "AVX2" };
+
+	const std::streamsize precision = std::cout.precision();
+	for (const Source& source : sources)
+	{
+		SDL_Surface* pSurface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, source.format);
+		if (!pSurface)
+		{
+			std::cout << source.name << " " << SDL_GetError() << '\n';
+			continue;
+		}
+
+		uint32_t random{ 12345 };
+		uint8_t* pPixels = static_cast<uint8_t*>(pSurface->pixels);
+		for (size_t byte = 0; byte < size_t(pSurface->pitch) * size; ++byte)
+		{
+			random = random * 1664525u + 1013904223u;
+			pPixels[byte] = static_cast<uint8_t>(random >> 24);
+		}
+		if (pSurface->format->palette)
+		{
+			SDL_Color colors[256]{};
+			for (int index = 0; index < 256; ++index)
+			{
+				const uint8_t value = static_cast<uint8_t>(index);
+				colors[index] = source.isGray ? SDL_Color{ value, value, value, 255 } : SDL_Color{ value, static_cast<uint8_t>(value * 7), static_cast<uint8_t>(255 - value), 255 };
+			}
+			SDL_SetPaletteColors(pSurface->format->palette, colors, 0, 256);
+		}
+
+		//SDL's conversion is the reference every kernel has to match
+		std::vector<uint8_t> reference(size_t(size) * size * 4);
+		const double sdlTime = MeasureBest([&]()
+			{
+				SDL_Surface* pConverted = SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0);
+				for (int y = 0; y < size; ++y)
+				{
+					memcpy(reference.data() + size_t(y) * size * 4, static_cast<const uint8_t*>(pConverted->pixels) + size_t(y) * pConverted->pitch, size_t(size) * 4);
+				}
+				SDL_FreeSurface(pConverted);
+			});
+		std::cout << source.name << " SDL " << std::fixed << std::setprecision(2) << std::setw(7) << sdlTime << " ms, copy included\n";
+
+		//Single threaded, so the numbers compare the kernels and not the thread count
+		std::vector<uint8_t> converted(reference.size());
+		for (uint32_t instructionSet = 0; instructionSet <= static_cast<uint32_t>(dae::PixelConversion::GetInstructionSet()); ++instructionSet)
+		{
+			const double time = MeasureBest([&]()
+				{
+					dae::PixelConversion::ConvertSurface(pSurface, converted.data(), 1, static_cast<dae::PixelConversion::InstructionSet>(instructionSet));
+				});
+			std::cout << "          " << std::setw(6) << instructionSetNames[instructionSet] << std::setw(7) << time << " ms ("
+				<< std::setw(7) << size * size / (time * 1000.0) << " Mpixels/s), x" << sdlTime / time
+				<< (converted == reference ? "" : "  OUTPUT DIFFERS") << '\n';
+		}
+		std::cout.unsetf(std::ios::fixed);
+		std::cout.precision(precision);
+
+		SDL_FreeSurface(pSurface);
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+
+namespace dae
+{
+	//CPU-only measurements of the asset pipeline, started with "--benchmark [file.obj]"
+	namespace Benchmark
+	{
+		void Run(const std::string& objFile);
+
+		void ParseOBJ(const std::string& objFile);
+		void Tangents(const std::string& objFile);
+		void Cleanup(const std::string& objFile);
+		void MeshCache(const std::string& objFile);
+		void VertexCache(const std::string& objFile);
+		void Overdraw(const std::string& objFile);
+		void VertexFetch(const std::string& objFile);
+		void VertexPacking(const std::string& objFile);
+		void Meshlets(const std::string& objFile);
+		void PositionStream(const std::string& objFile);
+		void Simplify(const std::string& objFile);
+		void MeshCodec(const std::string& objFile);
+
+		void MipChain(const std::string& imageFile, TextureUsage usage);
+		void BlockCompression(const std::string& imageFile, TextureUsage usage);
+		void TextureStreaming(size_t budget);
+		void ColorConversion();
+		void PixelConversion();
+	}
+}
@@ -0,0 +1,880 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "BlockCompressor.h"
+#include "Parallel.h"
+#include <limits>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t NumTexels{ 16 };
+
+	//4x4 texels, rgba
+	struct Block
+	{
+		uint8_t texels[NumTexels][4];
+	};
+
+	//Texels past the edge of a level repeat its last row or column
+	void ReadBlock(const TextureData& texture, size_t level, uint32_t blockX, uint32_t blockY, Block& block)
+	{
+		const TextureData::Level& info = texture.levels[level];
+		const uint8_t* pData = texture.GetLevelData(level);
+		const uint32_t rowPitch = texture.GetRowPitch(level);
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			const uint32_t sourceY = std::min(blockY * 4 + y, info.height - 1);
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				const uint32_t sourceX = std::min(blockX * 4 + x, info.width - 1);
+				memcpy(block.texels[y * 4 + x], pData + sourceY * rowPitch + sourceX * 4, 4);
+			}
+		}
+	}
+
+	void WriteBlock(TextureData& texture, size_t level, uint32_t blockX, uint32_t blockY, const Block& block)
+	{
+		const TextureData::Level& info = texture.levels[level];
+		uint8_t* pData = texture.data.data() + info.offset;
+		const uint32_t rowPitch = texture.GetRowPitch(level);
+		for (uint32_t y = 0; y < 4 && blockY * 4 + y < info.height; ++y)
+		{
+			for (uint32_t x = 0; x < 4 && blockX * 4 + x < info.width; ++x)
+			{
+				memcpy(pData + (blockY * 4 + y) * rowPitch + (blockX * 4 + x) * 4, block.texels[y * 4 + x], 4);
+			}
+		}
+	}
+
+	//The line through the mean along the direction the texels spread the most
+	//Power iteration on the covariance, started from the longest side of the bounding box
+	void FitLine(const float points[NumTexels][4], int numChannels, float mean[4], float axis[4])
+	{
+		float boundsMin[4]{ FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+		float boundsMax[4]{ -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (int channel = 0; channel < numChannels; ++channel)
+		{
+			mean[channel] = 0.f;
+			for (uint32_t texel = 0; texel < NumTexels; ++texel)
+			{
+				mean[channel] += points[texel][channel];
+				boundsMin[channel] = std::min(boundsMin[channel], points[texel][channel]);
+				boundsMax[channel] = std::max(boundsMax[channel], points[texel][channel]);
+			}
+			mean[channel] /= float(NumTexels);
+			axis[channel] = boundsMax[channel] - boundsMin[channel];
+		}
+
+		float covariance[4][4]{};
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			for (int row = 0; row < numChannels; ++row)
+			{
+				for (int column = 0; column < numChannels; ++column)
+				{
+					covariance[row][column] += (points[texel][row] - mean[row]) * (points[texel][column] - mean[column]);
+				}
+			}
+		}
+
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4]{};
+			float sqrLength{};
+			for (int row = 0; row < numChannels; ++row)
+			{
+				for (int column = 0; column < numChannels; ++column)
+				{
+					next[row] += covariance[row][column] * axis[column];
+				}
+				sqrLength += next[row] * next[row];
+			}
+
+			//All texels the same, any axis will do
+			if (sqrLength <= FLT_MIN)
+				break;
+
+			const float inverseLength = 1.f / sqrtf(sqrLength);
+			for (int channel = 0; channel < numChannels; ++channel)
+			{
+				axis[channel] = next[channel] * inverseLength;
+			}
+		}
+	}
+
+	//The ends of the fitted line where the texels project onto it, clamped to the byte range
+	void FitEndpoints(const float points[NumTexels][4], int numChannels, float endpoints[2][4])
+	{
+		float mean[4]{};
+		float axis[4]{};
+		FitLine(points, numChannels, mean, axis);
+
+		float minProjection{ FLT_MAX };
+		float maxProjection{ -FLT_MAX };
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			float projection{};
+			for (int channel = 0; channel < numChannels; ++channel)
+			{
+				projection += (points[texel][channel] - mean[channel]) * axis[channel];
+			}
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		for (int channel = 0; channel < numChannels; ++channel)
+		{
+			endpoints[0][channel] = std::clamp(mean[channel] + axis[channel] * maxProjection, 0.f, 255.f);
+			endpoints[1][channel] = std::clamp(mean[channel] + axis[channel] * minProjection, 0.f, 255.f);
+		}
+	}
+
+	//Endpoints that minimize the squared error for fixed indices, weight is how much of endpoint 1 every texel takes
+	//Returns false if every texel picked the same weight, the system has no single solution then
+	bool SolveEndpoints(const float points[NumTexels][4], int numChannels, const float weights[NumTexels], float endpoints[2][4])
+	{
+		float aa{}, ab{}, bb{};
+		float ax[4]{}, bx[4]{};
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			const float b = weights[texel];
+			const float a = 1.f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int channel = 0; channel < numChannels; ++channel)
+			{
+				ax[channel] += a * points[texel][channel];
+				bx[channel] += b * points[texel][channel];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) < 1e-6f)
+			return false;
+
+		const float inverse = 1.f / determinant;
+		for (int channel = 0; channel < numChannels; ++channel)
+		{
+			endpoints[0][channel] = std::clamp((bb * ax[channel] - ab * bx[channel]) * inverse, 0.f, 255.f);
+			endpoints[1][channel] = std::clamp((aa * bx[channel] - ab * ax[channel]) * inverse, 0.f, 255.f);
+		}
+		return true;
+	}
+
+	void ToPoints(const Block& block, float points[NumTexels][4])
+	{
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				points[texel][channel] = float(block.texels[texel][channel]);
+			}
+		}
+	}
+
+	//---------------------------
+	// BC1
+	//---------------------------
+	uint16_t To565(const float color[4])
+	{
+		const uint32_t r = uint32_t(color[0] * 31.f / 255.f + 0.5f);
+		const uint32_t g = uint32_t(color[1] * 63.f / 255.f + 0.5f);
+		const uint32_t b = uint32_t(color[2] * 31.f / 255.f + 0.5f);
+		return uint16_t(r << 11 | g << 5 | b);
+	}
+
+	void From565(uint16_t value, int color[3])
+	{
+		const int r = value >> 11;
+		const int g = (value >> 5) & 63;
+		const int b = value & 31;
+		color[0] = r << 3 | r >> 2;
+		color[1] = g << 2 | g >> 4;
+		color[2] = b << 3 | b >> 2;
+	}
+
+	//Always the 4 color mode, the 3 color mode with transparent black is never written
+	void GetBC1Palette(uint16_t color0, uint16_t color1, int palette[4][3])
+	{
+		From565(color0, palette[0]);
+		From565(color1, palette[1]);
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			palette[2][channel] = (2 * palette[0][channel] + palette[1][channel] + 1) / 3;
+			palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel] + 1) / 3;
+		}
+	}
+
+	//Nearest palette entry for every texel, returns the squared error
+	uint32_t FindBC1Indices(const Block& block, uint16_t color0, uint16_t color1, uint8_t indices[NumTexels])
+	{
+		int palette[4][3]{};
+		GetBC1Palette(color0, color1, palette);
+
+		uint32_t error{};
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			uint32_t best{ UINT32_MAX };
+			for (uint8_t entry = 0; entry < 4; ++entry)
+			{
+				uint32_t distance{};
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					const int difference = int(block.texels[texel][channel]) - palette[entry][channel];
+					distance += uint32_t(difference * difference);
+				}
+				if (distance < best)
+				{
+					best = distance;
+					indices[texel] = entry;
+				}
+			}
+			error += best;
+		}
+		return error;
+	}
+
+	struct BC1Fit
+	{
+		uint16_t color0{};
+		uint16_t color1{};
+		uint8_t indices[NumTexels]{};
+		uint32_t error{ UINT32_MAX };
+	};
+
+	//The 4 color mode needs color0 > color1, equal endpoints decode the same in either mode
+	void TryBC1Endpoints(const Block& block, const float endpoints[2][4], BC1Fit& best)
+	{
+		BC1Fit fit{};
+		fit.color0 = To565(endpoints[0]);
+		fit.color1 = To565(endpoints[1]);
+		if (fit.color0 < fit.color1)
+			std::swap(fit.color0, fit.color1);
+
+		fit.error = FindBC1Indices(block, fit.color0, fit.color1, fit.indices);
+		if (fit.color0 == fit.color1)
+			std::fill(std::begin(fit.indices), std::end(fit.indices), uint8_t(0));
+
+		if (fit.error < best.error)
+			best = fit;
+	}
+
+	void EncodeBC1(const Block& block, BlockCompressor::Quality quality, uint8_t* pOutput)
+	{
+		float points[NumTexels][4]{};
+		ToPoints(block, points);
+
+		float endpoints[2][4]{};
+		FitEndpoints(points, 3, endpoints);
+
+		BC1Fit best{};
+		TryBC1Endpoints(block, endpoints, best);
+
+		//Refit the endpoints to the texels that picked each palette entry
+		if (quality == BlockCompressor::Quality::High)
+		{
+			constexpr float Weights[4]{ 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+			for (int iteration = 0; iteration < 2 && best.error > 0; ++iteration)
+			{
+				float weights[NumTexels]{};
+				for (uint32_t texel = 0; texel < NumTexels; ++texel)
+				{
+					weights[texel] = Weights[best.indices[texel]];
+				}
+				if (!SolveEndpoints(points, 3, weights, endpoints))
+					break;
+
+				TryBC1Endpoints(block, endpoints, best);
+			}
+		}
+
+		uint32_t indexBits{};
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			indexBits |= uint32_t(best.indices[texel]) << (texel * 2);
+		}
+		memcpy(pOutput, &best.color0, 2);
+		memcpy(pOutput + 2, &best.color1, 2);
+		memcpy(pOutput + 4, &indexBits, 4);
+	}
+
+	void DecodeBC1(const uint8_t* pInput, Block& block)
+	{
+		uint16_t color0{}, color1{};
+		uint32_t indexBits{};
+		memcpy(&color0, pInput, 2);
+		memcpy(&color1, pInput + 2, 2);
+		memcpy(&indexBits, pInput + 4, 4);
+
+		int palette[4][3]{};
+		GetBC1Palette(color0, color1, palette);
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			const uint32_t index = (indexBits >> (texel * 2)) & 3;
+			for (int channel = 0; channel < 3; ++channel)
+			{
+				block.texels[texel][channel] = uint8_t(palette[index][channel]);
+			}
+		}
+	}
+
+	//---------------------------
+	// BC4
+	//---------------------------
+	//8 interpolated values when red0 > red1, otherwise 6 and the extremes 0 and 255
+	void GetBC4Palette(uint8_t red0, uint8_t red1, int palette[8])
+	{
+		palette[0] = red0;
+		palette[1] = red1;
+		if (red0 > red1)
+		{
+			for (int entry = 2; entry < 8; ++entry)
+			{
+				palette[entry] = ((8 - entry) * red0 + (entry - 1) * red1 + 3) / 7;
+			}
+			return;
+		}
+
+		for (int entry = 2; entry < 6; ++entry)
+		{
+			palette[entry] = ((6 - entry) * red0 + (entry - 1) * red1 + 2) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	struct BC4Fit
+	{
+		uint8_t red0{};
+		uint8_t red1{};
+		uint64_t indexBits{};
+		uint32_t error{ UINT32_MAX };
+	};
+
+	void TryBC4Endpoints(const uint8_t values[NumTexels], uint8_t red0, uint8_t red1, BC4Fit& best)
+	{
+		int palette[8]{};
+		GetBC4Palette(red0, red1, palette);
+
+		BC4Fit fit{ red0, red1, 0, 0 };
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			uint32_t bestDistance{ UINT32_MAX };
+			uint64_t bestEntry{};
+			for (uint64_t entry = 0; entry < 8; ++entry)
+			{
+				const int difference = int(values[texel]) - palette[entry];
+				const uint32_t distance = uint32_t(difference * difference);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestEntry = entry;
+				}
+			}
+			fit.indexBits |= bestEntry << (texel * 3);
+			fit.error += bestDistance;
+		}
+
+		if (fit.error < best.error)
+			best = fit;
+	}
+
+	void EncodeBC4(const uint8_t values[NumTexels], BlockCompressor::Quality quality, uint8_t* pOutput)
+	{
+		const auto [pMin, pMax] = std::minmax_element(values, values + NumTexels);
+		const uint8_t minValue = *pMin;
+		const uint8_t maxValue = *pMax;
+
+		BC4Fit best{};
+		TryBC4Endpoints(values, maxValue, minValue, best);
+
+		if (quality == BlockCompressor::Quality::High && best.error > 0)
+		{
+			//Pulling the ends in a little often lands the interpolated values closer to the texels
+			for (int inset0 = 0; inset0 <= 3; ++inset0)
+			{
+				for (int inset1 = 0; inset1 <= 3; ++inset1)
+				{
+					const int red0 = maxValue - inset0;
+					const int red1 = minValue + inset1;
+					if (red0 > red1)
+						TryBC4Endpoints(values, uint8_t(red0), uint8_t(red1), best);
+				}
+			}
+
+			//Blocks that touch 0 or 255 can leave those to the explicit extremes and spread the 6 values over the rest
+			uint8_t innerMin{ 255 };
+			uint8_t innerMax{ 0 };
+			for (uint32_t texel = 0; texel < NumTexels; ++texel)
+			{
+				if (values[texel] == 0 || values[texel] == 255)
+					continue;
+
+				innerMin = std::min(innerMin, values[texel]);
+				innerMax = std::max(innerMax, values[texel]);
+			}
+			if (innerMin <= innerMax)
+				TryBC4Endpoints(values, innerMin, innerMax, best);
+		}
+
+		pOutput[0] = best.red0;
+		pOutput[1] = best.red1;
+		for (int byte = 0; byte < 6; ++byte)
+		{
+			pOutput[2 + byte] = uint8_t(best.indexBits >> (byte * 8));
+		}
+	}
+
+	void DecodeBC4(const uint8_t* pInput, Block& block, int channel)
+	{
+		int palette[8]{};
+		GetBC4Palette(pInput[0], pInput[1], palette);
+
+		uint64_t indexBits{};
+		for (int byte = 0; byte < 6; ++byte)
+		{
+			indexBits |= uint64_t(pInput[2 + byte]) << (byte * 8);
+		}
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			block.texels[texel][channel] = uint8_t(palette[(indexBits >> (texel * 3)) & 7]);
+		}
+	}
+
+	void GetChannel(const Block& block, int channel, uint8_t values[NumTexels])
+	{
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			values[texel] = block.texels[texel][channel];
+		}
+	}
+
+	//---------------------------
+	// BC7
+	//---------------------------
+	//Mode 6: 7 bit rgba endpoints that share a low bit per endpoint, 4 bit indices
+	constexpr int BC7Weights[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Fit
+	{
+		int endpoints[2][4]{}; //8 bit values, the low bit of every channel of an endpoint is the same
+		uint8_t indices[NumTexels]{};
+		uint32_t error{ UINT32_MAX };
+	};
+
+	void GetBC7Palette(const int endpoints[2][4], int palette[16][4])
+	{
+		for (int entry = 0; entry < 16; ++entry)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				palette[entry][channel] = ((64 - BC7Weights[entry]) * endpoints[0][channel] + BC7Weights[entry] * endpoints[1][channel] + 32) >> 6;
+			}
+		}
+	}
+
+	void QuantizeBC7Endpoint(const float endpoint[4], int lowBit, int quantized[4])
+	{
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			const int value = std::clamp(int(floorf((endpoint[channel] - float(lowBit)) * 0.5f + 0.5f)), 0, 127);
+			quantized[channel] = value << 1 | lowBit;
+		}
+	}
+
+	//The low bit whose endpoint lands closest to the unquantized one
+	int ChooseBC7LowBit(const float endpoint[4])
+	{
+		float errors[2]{};
+		for (int lowBit = 0; lowBit < 2; ++lowBit)
+		{
+			int quantized[4]{};
+			QuantizeBC7Endpoint(endpoint, lowBit, quantized);
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				const float difference = endpoint[channel] - float(quantized[channel]);
+				errors[lowBit] += difference * difference;
+			}
+		}
+		return errors[1] < errors[0] ? 1 : 0;
+	}
+
+	void TryBC7Endpoints(const Block& block, const float endpoints[2][4], int lowBit0, int lowBit1, BC7Fit& best)
+	{
+		BC7Fit fit{};
+		QuantizeBC7Endpoint(endpoints[0], lowBit0, fit.endpoints[0]);
+		QuantizeBC7Endpoint(endpoints[1], lowBit1, fit.endpoints[1]);
+
+		int palette[16][4]{};
+		GetBC7Palette(fit.endpoints, palette);
+
+		fit.error = 0;
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			uint32_t bestDistance{ UINT32_MAX };
+			for (uint8_t entry = 0; entry < 16; ++entry)
+			{
+				uint32_t distance{};
+				for (int channel = 0; channel < 4; ++channel)
+				{
+					const int difference = int(block.texels[texel][channel]) - palette[entry][channel];
+					distance += uint32_t(difference * difference);
+				}
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					fit.indices[texel] = entry;
+				}
+			}
+			fit.error += bestDistance;
+		}
+
+		if (fit.error < best.error)
+			best = fit;
+	}
+
+	void TryBC7Endpoints(const Block& block, const float endpoints[2][4], BlockCompressor::Quality quality, BC7Fit& best)
+	{
+		if (quality == BlockCompressor::Quality::Fast)
+		{
+			TryBC7Endpoints(block, endpoints, ChooseBC7LowBit(endpoints[0]), ChooseBC7LowBit(endpoints[1]), best);
+			return;
+		}
+
+		for (int lowBits = 0; lowBits < 4; ++lowBits)
+		{
+			TryBC7Endpoints(block, endpoints, lowBits & 1, lowBits >> 1, best);
+		}
+	}
+
+	//Writes count bits of value at bit position and moves past them
+	void WriteBits(uint8_t* pOutput, uint32_t& position, uint32_t value, uint32_t count)
+	{
+		for (uint32_t bit = 0; bit < count; ++bit, ++position)
+		{
+			pOutput[position / 8] |= uint8_t(((value >> bit) & 1) << (position % 8));
+		}
+	}
+
+	uint32_t ReadBits(const uint8_t* pInput, uint32_t& position, uint32_t count)
+	{
+		uint32_t value{};
+		for (uint32_t bit = 0; bit < count; ++bit, ++position)
+		{
+			value |= uint32_t((pInput[position / 8] >> (position % 8)) & 1) << bit;
+		}
+		return value;
+	}
+
+	void EncodeBC7(const Block& block, BlockCompressor::Quality quality, uint8_t* pOutput)
+	{
+		float points[NumTexels][4]{};
+		ToPoints(block, points);
+
+		float endpoints[2][4]{};
+		FitEndpoints(points, 4, endpoints);
+
+		BC7Fit best{};
+		TryBC7Endpoints(block, endpoints, quality, best);
+
+		if (quality == BlockCompressor::Quality::High)
+		{
+			for (int iteration = 0; iteration < 2 && best.error > 0; ++iteration)
+			{
+				float weights[NumTexels]{};
+				for (uint32_t texel = 0; texel < NumTexels; ++texel)
+				{
+					weights[texel] = float(BC7Weights[best.indices[texel]]) / 64.f;
+				}
+				if (!SolveEndpoints(points, 4, weights, endpoints))
+					break;
+
+				TryBC7Endpoints(block, endpoints, quality, best);
+			}
+		}
+
+		//The first index has no high bit, so the endpoints are swapped when it would need one
+		if (best.indices[0] >= 8)
+		{
+			std::swap(best.endpoints[0], best.endpoints[1]);
+			for (uint8_t& index : best.indices)
+			{
+				index = uint8_t(15 - index);
+			}
+		}
+
+		memset(pOutput, 0, 16);
+		uint32_t position{};
+		WriteBits(pOutput, position, 1 << 6, 7);
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			WriteBits(pOutput, position, best.endpoints[0][channel] >> 1, 7);
+			WriteBits(pOutput, position, best.endpoints[1][channel] >> 1, 7);
+		}
+		WriteBits(pOutput, position, best.endpoints[0][0] & 1, 1);
+		WriteBits(pOutput, position, best.endpoints[1][0] & 1, 1);
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			WriteBits(pOutput, position, best.indices[texel], texel == 0 ? 3 : 4);
+		}
+	}
+
+	void DecodeBC7(const uint8_t* pInput, Block& block)
+	{
+		//Anything but mode 6 decodes to black
+		if ((pInput[0] & 0x7F) != 0x40)
+		{
+			memset(block.texels, 0, sizeof(block.texels));
+			return;
+		}
+
+		uint32_t position{ 7 };
+		int endpoints[2][4]{};
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = int(ReadBits(pInput, position, 7)) << 1;
+			endpoints[1][channel] = int(ReadBits(pInput, position, 7)) << 1;
+		}
+		const int lowBit0 = int(ReadBits(pInput, position, 1));
+		const int lowBit1 = int(ReadBits(pInput, position, 1));
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] |= lowBit0;
+			endpoints[1][channel] |= lowBit1;
+		}
+
+		int palette[16][4]{};
+		GetBC7Palette(endpoints, palette);
+		for (uint32_t texel = 0; texel < NumTexels; ++texel)
+		{
+			const uint32_t index = ReadBits(pInput, position, texel == 0 ? 3 : 4);
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				block.texels[texel][channel] = uint8_t(palette[index][channel]);
+			}
+		}
+	}
+
+	//---------------------------
+	// Formats
+	//---------------------------
+	void EncodeBlock(const Block& block, TextureFormat format, BlockCompressor::Quality quality, uint8_t* pOutput)
+	{
+		uint8_t values[NumTexels]{};
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			EncodeBC1(block, quality, pOutput);
+			break;
+		case TextureFormat::BC3:
+			GetChannel(block, 3, values);
+			EncodeBC4(values, quality, pOutput);
+			EncodeBC1(block, quality, pOutput + 8);
+			break;
+		case TextureFormat::BC4:
+			GetChannel(block, 0, values);
+			EncodeBC4(values, quality, pOutput);
+			break;
+		case TextureFormat::BC5:
+			GetChannel(block, 0, values);
+			EncodeBC4(values, quality, pOutput);
+			GetChannel(block, 1, values);
+			EncodeBC4(values, quality, pOutput + 8);
+			break;
+		case TextureFormat::BC7:
+			EncodeBC7(block, quality, pOutput);
+			break;
+		case TextureFormat::RGBA8:
+			break;
+		}
+	}
+
+	//Channels the format doesn't have are 0, alpha is 255, like the GPU returns them
+	void DecodeBlock(const uint8_t* pInput, TextureFormat format, Block& block)
+	{
+		for (uint8_t (&texel)[4] : block.texels)
+		{
+			texel[0] = texel[1] = texel[2] = 0;
+			texel[3] = 255;
+		}
+
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			DecodeBC1(pInput, block);
+			break;
+		case TextureFormat::BC3:
+			DecodeBC4(pInput, block, 3);
+			DecodeBC1(pInput + 8, block);
+			break;
+		case TextureFormat::BC4:
+			DecodeBC4(pInput, block, 0);
+			break;
+		case TextureFormat::BC5:
+			DecodeBC4(pInput, block, 0);
+			DecodeBC4(pInput + 8, block, 1);
+			break;
+		case TextureFormat::BC7:
+			DecodeBC7(pInput, block);
+			break;
+		case TextureFormat::RGBA8:
+			break;
+		}
+	}
+
+	uint32_t GetChannelMask(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			return 0b0111;
+		case TextureFormat::BC4:
+			return 0b0001;
+		case TextureFormat::BC5:
+			return 0b0011;
+		case TextureFormat::BC3:
+		case TextureFormat::BC7:
+		case TextureFormat::RGBA8:
+		default:
+			return 0b1111;
+		}
+	}
+
+	//Same levels in another format, with room for their data
+	void AllocateLevels(const TextureData& source, TextureFormat format, TextureData& destination)
+	{
+		destination.format = format;
+		destination.levels.clear();
+
+		size_t size{};
+		for (const TextureData::Level& level : source.levels)
+		{
+			destination.levels.push_back(TextureData::Level{ level.width, level.height, size });
+			size += GetLevelSize(format, level.width, level.height);
+		}
+		destination.data.assign(size, 0);
+	}
+
+	//Gray within this many steps still counts as a single channel, gloss maps exported as rgb are rarely exact
+	constexpr int MaxGrayDifference{ 4 };
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+TextureFormat BlockCompressor::ChooseFormat(const TextureData& texture, TextureUsage usage, Quality quality)
+{
+	if (usage == TextureUsage::Normal)
+		return TextureFormat::BC5;
+
+	bool isGray{ true };
+	bool isOpaque{ true };
+	const uint8_t* pTexels = texture.GetLevelData(0);
+	const size_t numTexels = size_t(texture.levels[0].width) * texture.levels[0].height;
+	for (size_t texel = 0; texel < numTexels && (isGray || isOpaque); ++texel)
+	{
+		const uint8_t* pTexel = pTexels + texel * 4;
+		isGray = isGray && abs(pTexel[0] - pTexel[1]) <= MaxGrayDifference && abs(pTexel[0] - pTexel[2]) <= MaxGrayDifference;
+		isOpaque = isOpaque && pTexel[3] == 255;
+	}
+
+	//Color maps sample all three channels, only data maps are read through red
+	if (usage == TextureUsage::Data && isGray && isOpaque)
+		return TextureFormat::BC4;
+	if (quality == Quality::High)
+		return TextureFormat::BC7;
+	return isOpaque ? TextureFormat::BC1 : TextureFormat::BC3;
+}
+
+void BlockCompressor::Compress(const TextureData& texture, TextureFormat format, Quality quality, TextureData& compressed, uint32_t numThreads)
+{
+	AllocateLevels(texture, format, compressed);
+
+	const uint32_t blockSize = GetBlockSize(format);
+	for (size_t level = 0; level < texture.levels.size(); ++level)
+	{
+		const uint32_t numBlocksX = (texture.levels[level].width + 3) / 4;
+		const uint32_t numBlocksY = (texture.levels[level].height + 3) / 4;
+		uint8_t* pOutput = compressed.data.data() + compressed.levels[level].offset;
+
+		ParallelFor(numBlocksY, [&](size_t begin, size_t end, uint32_t)
+			{
+				Block block{};
+				for (size_t blockY = begin; blockY < end; ++blockY)
+				{
+					for (uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+					{
+						ReadBlock(texture, level, blockX, uint32_t(blockY), block);
+						EncodeBlock(block, format, quality, pOutput + (blockY * numBlocksX + blockX) * blockSize);
+					}
+				}
+			}, numThreads);
+	}
+}
+
+void BlockCompressor::Decompress(const TextureData& compressed, TextureData& texture, uint32_t numThreads)
+{
+	AllocateLevels(compressed, TextureFormat::RGBA8, texture);
+
+	const uint32_t blockSize = GetBlockSize(compressed.format);
+	for (size_t level = 0; level < compressed.levels.size(); ++level)
+	{
+		const uint32_t numBlocksX = (compressed.levels[level].width + 3) / 4;
+		const uint32_t numBlocksY = (compressed.levels[level].height + 3) / 4;
+		const uint8_t* pInput = compressed.GetLevelData(level);
+
+		ParallelFor(numBlocksY, [&](size_t begin, size_t end, uint32_t)
+			{
+				Block block{};
+				for (size_t blockY = begin; blockY < end; ++blockY)
+				{
+					for (uint32_t blockX = 0; blockX < numBlocksX; ++blockX)
+					{
+						DecodeBlock(pInput + (blockY * numBlocksX + blockX) * blockSize, compressed.format, block);
+						WriteBlock(texture, level, blockX, uint32_t(blockY), block);
+					}
+				}
+			}, numThreads);
+	}
+}
+
+double BlockCompressor::ComputePSNR(const TextureData& original, const TextureData& compressed)
+{
+	TextureData decompressed{};
+	Decompress(compressed, decompressed);
+
+	const uint32_t channelMask = GetChannelMask(compressed.format);
+	double squaredError{};
+	size_t numValues{};
+	for (size_t level = 0; level < original.levels.size(); ++level)
+	{
+		const uint8_t* pOriginal = original.GetLevelData(level);
+		const uint8_t* pDecompressed = decompressed.GetLevelData(level);
+		const size_t numTexels = size_t(original.levels[level].width) * original.levels[level].height;
+		for (size_t texel = 0; texel < numTexels; ++texel)
+		{
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				if (!(channelMask & (1 << channel)))
+					continue;
+
+				const double difference = double(pOriginal[texel * 4 + channel]) - double(pDecompressed[texel * 4 + channel]);
+				squaredError += difference * difference;
+				++numValues;
+			}
+		}
+	}
+
+	if (squaredError == 0.0)
+		return std::numeric_limits<double>::infinity();
+	return 10.0 * log10(255.0 * 255.0 / (squaredError / double(numValues)));
+}
@@ -0,0 +1,32 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+
+namespace dae
+{
+	//CPU encoder for the BC formats the GPU samples directly, used to cook textures ahead of loading them
+	//Every block is fitted on its own: endpoints along the principal axis of its texels, then the nearest palette entry per texel
+	namespace BlockCompressor
+	{
+		enum class Quality
+		{
+			Fast,	//One fit per block
+			High	//Least squares refinement of the endpoints and a search over the encodings a format allows, a few times slower
+		};
+
+		//BC5 for normals, BC4 for data maps where only one channel carries information, BC1 or BC3 when fast and BC7 otherwise
+		//BC4 samples as (r, 0, 0, 1), so gray data maps are expected to be read through their red channel
+		TextureFormat ChooseFormat(const TextureData& texture, TextureUsage usage, Quality quality);
+
+		//Compresses every level of an RGBA8 texture, the blocks are split over the threads
+		//BC7 only writes mode 6, one rgba subset with 4 bit indices
+		void Compress(const TextureData& texture, TextureFormat format, Quality quality, TextureData& compressed, uint32_t numThreads = 0);
+
+		//Back to RGBA8, channels the format doesn't store come out as 0 and alpha as 255
+		//Only reads BC7 mode 6 blocks, the others come out black
+		void Decompress(const TextureData& compressed, TextureData& texture, uint32_t numThreads = 0);
+
+		//Peak signal to noise ratio in dB over every level, counting only the channels the compressed format stores
+		double ComputePSNR(const TextureData& original, const TextureData& compressed);
+	}
+}
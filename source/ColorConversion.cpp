@@ -0,0 +1,333 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "ColorConversion.h"
+#include <immintrin.h>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Linear values are clamped to [2^-13, 1), everything below encodes as 0 and the range splits into 13 exponents of 8 buckets each
+	constexpr uint32_t MinValueBits{ (127 - 13) << 23 };
+	constexpr uint32_t AlmostOneBits{ 0x3F7FFFFF };
+	constexpr uint32_t NumBuckets{ 104 };
+
+	float FromBits(uint32_t bits)
+	{
+		float value{};
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	double ToLinear(double srgb)
+	{
+		return srgb <= 0.04045 ? srgb / 12.92 : pow((srgb + 0.055) / 1.055, 2.4);
+	}
+
+	double ToSRGB(double linear)
+	{
+		return linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow(linear, 1.0 / 2.4) - 0.055;
+	}
+
+	struct Tables
+	{
+		float toLinear[256]{};
+
+		//A line per bucket over the next 8 bits of the mantissa, its bias / 512 in the high half and its slope in the low half, both 16.16 fixed point
+		//The curve is concave, so the chord of a bucket stays below it and the estimate is the right byte or the one below
+		uint32_t estimates[NumBuckets]{};
+
+		//The smallest float that rounds to each byte, the estimate moves up one when the value reaches the next threshold
+		float thresholds[257]{};
+
+		Tables()
+		{
+			for (uint32_t value = 0; value < 256; ++value)
+			{
+				toLinear[value] = static_cast<float>(ToLinear(value / 255.0));
+			}
+
+			for (uint32_t bucket = 0; bucket < NumBuckets; ++bucket)
+			{
+				const double begin = FromBits(MinValueBits + (bucket << 20));
+				const double end = FromBits(MinValueBits + ((bucket + 1) << 20));
+
+				//In bytes plus a half, so truncating rounds
+				const double first = ToSRGB(begin) * 255.0 + 0.5;
+				const double last = ToSRGB(end) * 255.0 + 0.5;
+				const uint32_t bias = static_cast<uint32_t>(std::max((first - 0.001) * 65536.0 / 512.0, 0.0));
+				const uint32_t slope = static_cast<uint32_t>((last - first) / 256.0 * 65536.0);
+				estimates[bucket] = bias << 16 | slope;
+			}
+
+			thresholds[0] = 0.f;
+			for (uint32_t value = 1; value < 256; ++value)
+			{
+				const double threshold = ToLinear((value - 0.5) / 255.0);
+				float rounded = static_cast<float>(threshold);
+				if (rounded < threshold)
+					rounded = std::nextafter(rounded, 2.f);
+				thresholds[value] = rounded;
+			}
+			thresholds[256] = FLT_MAX;
+		}
+	};
+
+	const Tables& GetTables()
+	{
+		static const Tables tables{};
+		return tables;
+	}
+
+	//Bytes of 4 linear values, as 32 bit integers
+	__m128i EncodeSRGB(__m128 linear, const Tables& tables)
+	{
+		const __m128 clamped = _mm_min_ps(_mm_max_ps(linear, _mm_castsi128_ps(_mm_set1_epi32(MinValueBits))), _mm_castsi128_ps(_mm_set1_epi32(AlmostOneBits)));
+		const __m128i bits = _mm_castps_si128(clamped);
+
+		alignas(16) uint32_t buckets[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(buckets), _mm_srli_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(MinValueBits)), 20));
+		const __m128i estimate = _mm_setr_epi32(tables.estimates[buckets[0]], tables.estimates[buckets[1]], tables.estimates[buckets[2]], tables.estimates[buckets[3]]);
+
+		//bias / 512 * 512 + slope * mantissa in one multiply-add of the 16 bit halves
+		const __m128i mantissa = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(bits, 12), _mm_set1_epi32(0xFF)), _mm_set1_epi32(512 << 16));
+		const __m128i bytes = _mm_srli_epi32(_mm_madd_epi16(estimate, mantissa), 16);
+
+		alignas(16) uint32_t values[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(values), bytes);
+		const __m128 next = _mm_setr_ps(tables.thresholds[values[0] + 1], tables.thresholds[values[1] + 1], tables.thresholds[values[2] + 1], tables.thresholds[values[3] + 1]);
+		return _mm_sub_epi32(bytes, _mm_castps_si128(_mm_cmpge_ps(clamped, next)));
+	}
+
+#if defined(__AVX2__)
+	__m256i EncodeSRGB(__m256 linear, const Tables& tables)
+	{
+		const __m256 clamped = _mm256_min_ps(_mm256_max_ps(linear, _mm256_castsi256_ps(_mm256_set1_epi32(MinValueBits))), _mm256_castsi256_ps(_mm256_set1_epi32(AlmostOneBits)));
+		const __m256i bits = _mm256_castps_si256(clamped);
+
+		const __m256i buckets = _mm256_srli_epi32(_mm256_sub_epi32(bits, _mm256_set1_epi32(MinValueBits)), 20);
+		const __m256i estimate = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tables.estimates), buckets, 4);
+
+		const __m256i mantissa = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(bits, 12), _mm256_set1_epi32(0xFF)), _mm256_set1_epi32(512 << 16));
+		const __m256i bytes = _mm256_srli_epi32(_mm256_madd_epi16(estimate, mantissa), 16);
+
+		const __m256 next = _mm256_i32gather_ps(tables.thresholds + 1, bytes, 4);
+		return _mm256_sub_epi32(bytes, _mm256_castps_si256(_mm256_cmp_ps(clamped, next, _CMP_GE_OQ)));
+	}
+#endif
+
+	__m128i EncodeLinear(__m128 value)
+	{
+		const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f));
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+	}
+
+	//16 values to 16 bytes, with isAlphaLinear every fourth one is encoded without the curve
+	void EncodeBlock(const float* pSource, uint8_t* pDestination, bool isAlphaLinear, const Tables& tables)
+	{
+		__m128i bytes[4];
+#if defined(__AVX2__)
+		for (int half = 0; half < 2; ++half)
+		{
+			const __m256i encoded = EncodeSRGB(_mm256_loadu_ps(pSource + half * 8), tables);
+			bytes[half * 2] = _mm256_castsi256_si128(encoded);
+			bytes[half * 2 + 1] = _mm256_extracti128_si256(encoded, 1);
+		}
+#else
+		for (int quarter = 0; quarter < 4; ++quarter)
+		{
+			bytes[quarter] = EncodeSRGB(_mm_loadu_ps(pSource + quarter * 4), tables);
+		}
+#endif
+
+		if (isAlphaLinear)
+		{
+			const __m128i alphaMask = _mm_setr_epi32(0, 0, 0, -1);
+			for (int quarter = 0; quarter < 4; ++quarter)
+			{
+				const __m128i alpha = EncodeLinear(_mm_loadu_ps(pSource + quarter * 4));
+				bytes[quarter] = _mm_or_si128(_mm_andnot_si128(alphaMask, bytes[quarter]), _mm_and_si128(alphaMask, alpha));
+			}
+		}
+
+		const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(bytes[0], bytes[1]), _mm_packs_epi32(bytes[2], bytes[3]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination), packed);
+	}
+
+	//Whole blocks straight from the source, the rest through a padded block so every value takes the same path
+	void Encode(const float* pSource, uint8_t* pDestination, size_t count, bool isAlphaLinear)
+	{
+		const Tables& tables = GetTables();
+
+		size_t i{};
+		for (; i + 16 <= count; i += 16)
+		{
+			EncodeBlock(pSource + i, pDestination + i, isAlphaLinear, tables);
+		}
+
+		if (i < count)
+		{
+			float source[16]{};
+			uint8_t destination[16]{};
+			std::copy(pSource + i, pSource + count, source);
+			EncodeBlock(source, destination, isAlphaLinear, tables);
+			std::copy(destination, destination + (count - i), pDestination + i);
+		}
+	}
+
+	//The operators work per channel, so the colors are processed as one array of floats
+	template<typename Vector, typename Operator>
+	void ToneMapFloats(float* pValues, size_t count, Operator&& toneMap)
+	{
+		constexpr size_t width = sizeof(Vector) / sizeof(float);
+
+		size_t i{};
+		for (; i + width <= count; i += width)
+		{
+			toneMap(pValues + i, pValues + i);
+		}
+
+		if (i < count)
+		{
+			float values[width]{};
+			std::copy(pValues + i, pValues + count, values);
+			toneMap(values, values);
+			std::copy(values, values + (count - i), pValues + i);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+float ColorConversion::SRGBToLinear(float srgb)
+{
+	return static_cast<float>(ToLinear(srgb));
+}
+
+float ColorConversion::LinearToSRGB(float linear)
+{
+	return static_cast<float>(ToSRGB(linear));
+}
+
+void ColorConversion::DecodeSRGB8(const uint8_t* pSource, float* pDestination, size_t count)
+{
+	const Tables& tables = GetTables();
+	for (size_t i = 0; i < count; ++i)
+	{
+		pDestination[i] = tables.toLinear[pSource[i]];
+	}
+}
+
+void ColorConversion::EncodeSRGB8(const float* pSource, uint8_t* pDestination, size_t count)
+{
+	Encode(pSource, pDestination, count, false);
+}
+
+void ColorConversion::DecodeRGBA8(const uint8_t* pSource, float* pDestination, size_t count)
+{
+	const Tables& tables = GetTables();
+	for (size_t texel = 0; texel < count; ++texel)
+	{
+		const uint8_t* pTexel = pSource + texel * 4;
+		float* pValues = pDestination + texel * 4;
+		pValues[0] = tables.toLinear[pTexel[0]];
+		pValues[1] = tables.toLinear[pTexel[1]];
+		pValues[2] = tables.toLinear[pTexel[2]];
+		pValues[3] = pTexel[3] * (1.f / 255.f);
+	}
+}
+
+void ColorConversion::EncodeRGBA8(const float* pSource, uint8_t* pDestination, size_t count)
+{
+	Encode(pSource, pDestination, count * 4, true);
+}
+
+void ColorConversion::DecodeRGBA8(const uint8_t* pSource, ColorRGB* pDestination, size_t count)
+{
+	const Tables& tables = GetTables();
+	for (size_t texel = 0; texel < count; ++texel)
+	{
+		const uint8_t* pTexel = pSource + texel * 4;
+		pDestination[texel] = ColorRGB{ tables.toLinear[pTexel[0]], tables.toLinear[pTexel[1]], tables.toLinear[pTexel[2]] };
+	}
+}
+
+void ColorConversion::EncodeRGBA8(const ColorRGB* pSource, uint8_t* pDestination, size_t count)
+{
+	//4 colors at a time, widened to rgba with an opaque alpha
+	float texels[16]{};
+	for (size_t first = 0; first < count; first += 4)
+	{
+		const size_t numColors = std::min<size_t>(count - first, 4);
+		for (size_t color = 0; color < numColors; ++color)
+		{
+			texels[color * 4 + 0] = pSource[first + color].r;
+			texels[color * 4 + 1] = pSource[first + color].g;
+			texels[color * 4 + 2] = pSource[first + color].b;
+			texels[color * 4 + 3] = 1.f;
+		}
+		Encode(texels, pDestination + first * 4, numColors * 4, true);
+	}
+}
+
+void ColorConversion::ToneMap(ColorRGB* pColors, size_t count, ToneMapper toneMapper, float exposure)
+{
+	static_assert(sizeof(ColorRGB) == sizeof(float) * 3, "ColorRGB is processed as an array of floats");
+	float* pValues = &pColors->r;
+	const size_t numValues = count * 3;
+
+#if defined(__AVX__)
+	using Vector = __m256;
+	const auto set = [](float value) { return _mm256_set1_ps(value); };
+	const auto load = [](const float* pSource) { return _mm256_loadu_ps(pSource); };
+	const auto store = [](float* pDestination, __m256 value) { _mm256_storeu_ps(pDestination, value); };
+	const auto add = [](__m256 a, __m256 b) { return _mm256_add_ps(a, b); };
+	const auto mul = [](__m256 a, __m256 b) { return _mm256_mul_ps(a, b); };
+	const auto div = [](__m256 a, __m256 b) { return _mm256_div_ps(a, b); };
+	const auto minimum = [](__m256 a, __m256 b) { return _mm256_min_ps(a, b); };
+	const auto maximum = [](__m256 a, __m256 b) { return _mm256_max_ps(a, b); };
+#else
+	using Vector = __m128;
+	const auto set = [](float value) { return _mm_set1_ps(value); };
+	const auto load = [](const float* pSource) { return _mm_loadu_ps(pSource); };
+	const auto store = [](float* pDestination, __m128 value) { _mm_storeu_ps(pDestination, value); };
+	const auto add = [](__m128 a, __m128 b) { return _mm_add_ps(a, b); };
+	const auto mul = [](__m128 a, __m128 b) { return _mm_mul_ps(a, b); };
+	const auto div = [](__m128 a, __m128 b) { return _mm_div_ps(a, b); };
+	const auto minimum = [](__m128 a, __m128 b) { return _mm_min_ps(a, b); };
+	const auto maximum = [](__m128 a, __m128 b) { return _mm_max_ps(a, b); };
+#endif
+
+	//Negative values are clamped first, they would flip the sign of the curves
+	const Vector scale = set(exposure);
+	const Vector zero = set(0.f);
+	const Vector one = set(1.f);
+	switch (toneMapper)
+	{
+	case ToneMapper::Reinhard:
+		ToneMapFloats<Vector>(pValues, numValues, [&](const float* pSource, float* pDestination)
+			{
+				const Vector value = maximum(mul(load(pSource), scale), zero);
+				store(pDestination, div(value, add(value, one)));
+			});
+		break;
+	case ToneMapper::ACES:
+	default:
+		ToneMapFloats<Vector>(pValues, numValues, [&](const float* pSource, float* pDestination)
+			{
+				const Vector value = maximum(mul(load(pSource), scale), zero);
+				const Vector numerator = mul(value, add(mul(value, set(2.51f)), set(0.03f)));
+				const Vector denominator = add(mul(value, add(mul(value, set(2.43f)), set(0.59f))), set(0.14f));
+				store(pDestination, minimum(div(numerator, denominator), one));
+			});
+		break;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+// Includes
+#include "ColorRGB.h"
+
+namespace dae
+{
+	//Batch conversions between 8 bit sRGB and linear floats, for the images processed on the CPU
+	//Decoding looks up a 256 entry table, encoding estimates the byte from the bits of the float and corrects it with one compare
+	//Both round exactly like the powf curve evaluated in double precision would
+	namespace ColorConversion
+	{
+		enum class ToneMapper
+		{
+			Reinhard,	//c / (1 + c) per channel, never reaches white
+			ACES		//Narkowicz's fit of the ACES filmic curve, clamped to [0, 1]
+		};
+
+		//The exact curves, 8 bit values are v / 255
+		float SRGBToLinear(float srgb);
+		float LinearToSRGB(float linear);
+
+		//count bytes to count floats and back, linear values are clamped to [0, 1] and NaN encodes as 0
+		void DecodeSRGB8(const uint8_t* pSource, float* pDestination, size_t count);
+		void EncodeSRGB8(const float* pSource, uint8_t* pDestination, size_t count);
+
+		//count RGBA8 texels with sRGB rgb and linear alpha, to and from 4 floats each
+		void DecodeRGBA8(const uint8_t* pSource, float* pDestination, size_t count);
+		void EncodeRGBA8(const float* pSource, uint8_t* pDestination, size_t count);
+
+		//The same for colors without alpha, the texels are written opaque
+		void DecodeRGBA8(const uint8_t* pSource, ColorRGB* pDestination, size_t count);
+		void EncodeRGBA8(const ColorRGB* pSource, uint8_t* pDestination, size_t count);
+
+		//Scales count linear colors by the exposure and maps them into [0, 1], in place
+		void ToneMap(ColorRGB* pColors, size_t count, ToneMapper toneMapper, float exposure = 1.f);
+	}
+}
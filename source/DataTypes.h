@@ -2,6 +2,13 @@
 
 namespace dae
 {
+	enum class VertexFormat
+	{
+		PosCol,
+		PosTex,
+		PosTexPacked
+	};
+
 	struct Vertex_PosCol
 	{
 		Vector3 position{};
@@ -12,7 +19,16 @@ namespace dae
 	{
 		Vector3 position{};
 		Vector3 normal{};
-		Vector3 tangent{};
+		Vector4 tangent{}; //w is the bitangent sign
 		Vector2 uv{};
 	};
+
+	//20 bytes instead of the 48 of Vertex_PosTex, see VertexPacking for the encoding
+	struct Vertex_PosTexPacked
+	{
+		uint16_t position[4]{};	//R16G16B16A16_UNORM relative to the mesh bounds, w is the bitangent sign (0 or 1)
+		int16_t normal[2]{};	//R16G16_SNORM octahedral
+		int16_t tangent[2]{};	//R16G16_SNORM octahedral
+		uint16_t uv[2]{};		//R16G16_FLOAT
+	};
 }
\ No newline at end of file
@@ -12,22 +12,24 @@ using namespace dae;
 //-----------------------------------------------------------------
 // Constructors
 //-----------------------------------------------------------------
-Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile, bool usesTexture)
+Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile, VertexFormat vertexFormat)
 {
 	//Load Effect
 	m_pEffect = LoadEffect(pDevice, assetFile);
 
 	
-	//Load Techniques
-	m_pTechniquePoint = m_pEffect->GetTechniqueByName("DefaultTechnique");
+	//Load Techniques, packed vertices have their own vertex shader
+	const std::string techniquePrefix = vertexFormat == VertexFormat::PosTexPacked ? "Packed" : "";
+
+	m_pTechniquePoint = m_pEffect->GetTechniqueByName((techniquePrefix + "DefaultTechnique").c_str());
 	if (!m_pTechniquePoint->IsValid())
 		std::wcout << L"DefaultTechnique not valid\n";
 
-	m_pTechniqueLinear = m_pEffect->GetTechniqueByName("LinearTechnique");
+	m_pTechniqueLinear = m_pEffect->GetTechniqueByName((techniquePrefix + "LinearTechnique").c_str());
 	if (!m_pTechniqueLinear->IsValid())
 		std::wcout << L"LinearTechnique not valid\n";
 
-	m_pTechniqueAnisotropic = m_pEffect->GetTechniqueByName("AnisotropicTechnique");
+	m_pTechniqueAnisotropic = m_pEffect->GetTechniqueByName((techniquePrefix + "AnisotropicTechnique").c_str());
 	if (!m_pTechniqueAnisotropic->IsValid())
 		std::wcout << L"AnisotropicTechnique not valid\n";
 
@@ -47,6 +49,17 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile, bool usesTe
 	if (!m_pMatInvViewVariable->IsValid())
 		std::wcout << L"Matrix Variable gInvView not valid\n";
 
+	if (vertexFormat == VertexFormat::PosTexPacked)
+	{
+		m_pPositionScaleVariable = m_pEffect->GetVariableByName("gPositionScale")->AsVector();
+		if (!m_pPositionScaleVariable->IsValid())
+			std::wcout << L"Vector Variable gPositionScale not valid\n";
+
+		m_pPositionOffsetVariable = m_pEffect->GetVariableByName("gPositionOffset")->AsVector();
+		if (!m_pPositionOffsetVariable->IsValid())
+			std::wcout << L"Vector Variable gPositionOffset not valid\n";
+	}
+
 
 	//Load Textures
 	m_pDiffuseMapVariable = m_pEffect->GetVariableByName("gDiffuseMap")->AsShaderResource();
@@ -65,17 +78,25 @@ Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile, bool usesTe
 	if (!m_pGlossMapVariable->IsValid())
 		std::wcout << L"Shader Resource gGlossMap Variable not valid\n";
 
+	m_pGlossInSpecularAlphaVariable = m_pEffect->GetVariableByName("gGlossInSpecularAlpha")->AsScalar();
+	if (!m_pGlossInSpecularAlphaVariable->IsValid())
+		std::wcout << L"Scalar Variable gGlossInSpecularAlpha not valid\n";
+
 
 	//Create Vertex Layout
 	uint32_t numElements{ 2 };
 	D3D11_INPUT_ELEMENT_DESC* vertexDesc{};
-	if (usesTexture)
-	{
-		numElements = CreateTextureVertexLayout(vertexDesc);
-	}
-	else
+	switch (vertexFormat)
 	{
+	case VertexFormat::PosCol:
 		numElements = CreateColorVertexLayout(vertexDesc);
+		break;
+	case VertexFormat::PosTex:
+		numElements = CreateTextureVertexLayout(vertexDesc);
+		break;
+	case VertexFormat::PosTexPacked:
+		numElements = CreatePackedTextureVertexLayout(vertexDesc);
+		break;
 	}
 
 
@@ -200,13 +221,41 @@ uint32_t Effect::CreateTextureVertexLayout(D3D11_INPUT_ELEMENT_DESC*& vertexDesc
 	vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	vertexDesc[2].SemanticName = "TANGENT";
-	vertexDesc[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	vertexDesc[2].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
 	vertexDesc[2].AlignedByteOffset = 24;
 	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	vertexDesc[3].SemanticName = "TEXCOORD";
 	vertexDesc[3].Format = DXGI_FORMAT_R32G32_FLOAT;
-	vertexDesc[3].AlignedByteOffset = 36;
+	vertexDesc[3].AlignedByteOffset = 40;
+	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+	return numElements;
+}
+
+uint32_t Effect::CreatePackedTextureVertexLayout(D3D11_INPUT_ELEMENT_DESC*& vertexDesc)
+{
+	static constexpr uint32_t numElements{ 4 };
+	vertexDesc = new D3D11_INPUT_ELEMENT_DESC[numElements]{};
+
+	vertexDesc[0].SemanticName = "POSITION";
+	vertexDesc[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+	vertexDesc[0].AlignedByteOffset = 0;
+	vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+	vertexDesc[1].SemanticName = "NORMAL";
+	vertexDesc[1].Format = DXGI_FORMAT_R16G16_SNORM;
+	vertexDesc[1].AlignedByteOffset = 8;
+	vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+	vertexDesc[2].SemanticName = "TANGENT";
+	vertexDesc[2].Format = DXGI_FORMAT_R16G16_SNORM;
+	vertexDesc[2].AlignedByteOffset = 12;
+	vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+
+	vertexDesc[3].SemanticName = "TEXCOORD";
+	vertexDesc[3].Format = DXGI_FORMAT_R16G16_FLOAT;
+	vertexDesc[3].AlignedByteOffset = 16;
 	vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 	return numElements;
@@ -263,6 +312,19 @@ void Effect::SetInverseViewMatrix(Matrix& pMatrix)
 		std::wcout << L"SetInverseViewMatrix failed\n";
 }
 
+void Effect::SetPositionDequantization(const Vector3& scale, const Vector3& offset)
+{
+	if (m_pPositionScaleVariable && m_pPositionOffsetVariable)
+	{
+		const float scaleVector[4]{ scale.x, scale.y, scale.z, 0.f };
+		const float offsetVector[4]{ offset.x, offset.y, offset.z, 0.f };
+		m_pPositionScaleVariable->SetFloatVector(scaleVector);
+		m_pPositionOffsetVariable->SetFloatVector(offsetVector);
+	}
+	else
+		std::wcout << L"SetPositionDequantization failed\n";
+}
+
 void Effect::SetDiffuseMap(Texture* pTexture)
 {
 	if (pTexture)
@@ -310,6 +372,8 @@ void Effect::SetSpecularMap(Texture* pTexture)
 			const HRESULT result = m_pSpecularMapVariable->SetResource(pTexture->GetResourceView());
 			if (FAILED(result))
 				assert(false);
+
+			SetGlossInSpecularAlpha(pTexture->HasPackedAlpha());
 		}
 		else
 			std::wcout << L"SetSpecularMap failed\n";
@@ -339,6 +403,12 @@ void Effect::SetGlossinessMap(Texture* pTexture)
 	}
 }
 
+void Effect::SetGlossInSpecularAlpha(bool isPacked)
+{
+	if (m_pGlossInSpecularAlphaVariable->IsValid())
+		m_pGlossInSpecularAlphaVariable->SetBool(isPacked);
+}
+
 
 //-----------------------------------------------------------------
 // Private Member Functions
@@ -1,5 +1,6 @@
 #pragma once
 // Includes
+#include "DataTypes.h"
 
 namespace dae
 {
@@ -11,7 +12,7 @@ namespace dae
 	{
 	public:
 		// Constructors and Destructor
-		explicit Effect(ID3D11Device* pDevice, const std::wstring& assetFile, bool usesTexture);
+		explicit Effect(ID3D11Device* pDevice, const std::wstring& assetFile, VertexFormat vertexFormat);
 		~Effect();
 
 		// Copy and Move semantics
@@ -26,17 +27,22 @@ namespace dae
 		static ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile);
 		uint32_t CreateColorVertexLayout(D3D11_INPUT_ELEMENT_DESC*& vertexDesc);
 		uint32_t CreateTextureVertexLayout(D3D11_INPUT_ELEMENT_DESC*& vertexDesc);
+		uint32_t CreatePackedTextureVertexLayout(D3D11_INPUT_ELEMENT_DESC*& vertexDesc);
 
 		void ToggleTechnique();
 
 		void SetWorldViewProjectionMatrix(Matrix& pMatrix);
 		void SetWorldMatrix(Matrix& pMatrix);
 		void SetInverseViewMatrix(Matrix& pMatrix);
+		void SetPositionDequantization(const Vector3& scale, const Vector3& offset);
 
 		void SetDiffuseMap(Texture* pTexture);
 		void SetNormalMap(Texture* pTexture);
+		//A specular map with a packed alpha also stands in for the gloss map, the effect then skips sampling that one
 		void SetSpecularMap(Texture* pTexture);
 		void SetGlossinessMap(Texture* pTexture);
+		//Whether the gloss is read from the alpha of the specular map, set along with it but also to reset for materials without one
+		void SetGlossInSpecularAlpha(bool isPacked);
 
 		ID3DX11Effect* GetEffect() const { return m_pEffect; }
 		ID3DX11EffectTechnique* GetTechnique() const { return m_pTechnique; }
@@ -52,6 +58,9 @@ namespace dae
 		ID3DX11EffectMatrixVariable* m_pMatWorldVariable{};
 		ID3DX11EffectMatrixVariable* m_pMatInvViewVariable{};
 
+		ID3DX11EffectVectorVariable* m_pPositionScaleVariable{};
+		ID3DX11EffectVectorVariable* m_pPositionOffsetVariable{};
+
 		ID3DX11EffectTechnique* m_pTechnique{};
 		ID3DX11EffectTechnique* m_pTechniquePoint{};
 		ID3DX11EffectTechnique* m_pTechniqueLinear{};
@@ -61,6 +70,7 @@ namespace dae
 		ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{};
 		ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{};
 		ID3DX11EffectShaderResourceVariable* m_pGlossMapVariable{};
+		ID3DX11EffectScalarVariable* m_pGlossInSpecularAlphaVariable{};
 
 		enum class TechniqueType
 		{
@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MappedFile.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Constructors
+//-----------------------------------------------------------------
+MappedFile::MappedFile(const std::string& path)
+{
+	//Open the file read-only, the OS pages it in on demand
+	m_hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(m_hFile, &fileSize))
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+		return;
+	}
+
+	//Empty files can't be mapped, they are still valid though
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+	if (m_Size == 0)
+		return;
+
+
+	//Map the whole file into our address space
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping)
+		m_pData = MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!m_pData)
+	{
+		if (m_hMapping) CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_Size = 0;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Destructor
+//-----------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	if (m_pData) UnmapViewOfFile(m_pData);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+}
+
+
+//-----------------------------------------------------------------
+// Public Member Functions
+//-----------------------------------------------------------------
+
+
+//-----------------------------------------------------------------
+// Private Member Functions
+//-----------------------------------------------------------------
+
@@ -0,0 +1,43 @@
+#pragma once
+// Includes
+
+namespace dae
+{
+	// Class Forward Declarations
+	
+	// Class Declaration
+	class MappedFile final
+	{
+	public:
+		// Constructors and Destructor
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+		
+		// Copy and Move semantics
+		MappedFile(const MappedFile& other)					= delete;
+		MappedFile& operator=(const MappedFile& other)		= delete;
+		MappedFile(MappedFile&& other) noexcept				= delete;
+		MappedFile& operator=(MappedFile&& other) noexcept	= delete;
+	
+		//---------------------------
+		// Public Member Functions
+		//---------------------------
+		bool IsOpen() const { return m_hFile != INVALID_HANDLE_VALUE; }
+		const char* GetData() const { return static_cast<const char*>(m_pData); }
+		size_t GetSize() const { return m_Size; }
+
+		
+	private:
+		// Member variables
+		HANDLE m_hFile{ INVALID_HANDLE_VALUE };
+		HANDLE m_hMapping{};
+
+		const void* m_pData{};
+		size_t m_Size{};
+	
+		//---------------------------
+		// Private Member Functions
+		//---------------------------
+	
+	};
+}
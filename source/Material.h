@@ -0,0 +1,29 @@
+#pragma once
+// Includes
+
+namespace dae
+{
+	//Everything besides the geometry that decides how a mesh is drawn
+	//Meshes with equal materials can share their buffers and draw calls, so materials are compared by file names
+	struct Material
+	{
+		std::wstring effectFile{};
+
+		//Empty if the effect doesn't sample that map
+		std::string diffuseMap{};
+		std::string normalMap{};
+		std::string specularMap{};
+		std::string glossMap{};
+
+		bool cullBackfaces{ true };
+
+		auto operator<=>(const Material& other) const = default;
+	};
+
+	//The triangles of one material, a range of the index buffer
+	struct Submesh
+	{
+		uint32_t indexOffset{};
+		uint32_t numIndices{};
+	};
+}
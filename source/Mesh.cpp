@@ -5,6 +5,10 @@
 #include "Mesh.h"
 #include "Effect.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include "VertexPacking.h"
+#include <map>
 
 using namespace dae;
 
@@ -15,77 +19,38 @@ using namespace dae;
 Mesh::Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<Vertex_PosCol>& vertices, const std::vector<uint32_t>& indices)
 {
 	//Create Effect Instance
-	m_IsTextured = false;
-	m_pEffect = new Effect(pDevice, assetFile, m_IsTextured);
+	m_VertexFormat = VertexFormat::PosCol;
+	m_pEffect = new Effect(pDevice, assetFile, m_VertexFormat);
 
-
-	//Create Vertex Buffer
-	D3D11_BUFFER_DESC bd = {};
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex_PosCol) * static_cast<uint32_t>(vertices.size());
-	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
-
-	D3D11_SUBRESOURCE_DATA initData = {};
-	initData.pSysMem = vertices.data();
-
-	HRESULT result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
-	if (FAILED(result))
-		return;
-
-
-	//Create Index Buffer
-	m_NumIndices = static_cast<uint32_t>(indices.size());
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
-	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
-
-	initData.pSysMem = indices.data();
-
-	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
-	if (FAILED(result))
-		return;
+	//Create Vertex & Index Buffer
+	const uint32_t vertexBufferSize = sizeof(Vertex_PosCol) * static_cast<uint32_t>(vertices.size());
+	CreateBuffers(pDevice, vertices.data(), vertexBufferSize, indices.data(), static_cast<uint32_t>(indices.size()));
 }
 
 Mesh::Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<Vertex_PosTex>& vertices, const std::vector<uint32_t>& indices)
+	: Mesh(pDevice, assetFile, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()))
 {
-	//Create Effect Instance
-	m_IsTextured = true;
-	m_pEffect = new Effect(pDevice, assetFile, m_IsTextured);
-
-
-	//Create Vertex Buffer
-	D3D11_BUFFER_DESC bd = {};
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex_PosTex) * static_cast<uint32_t>(vertices.size());
-	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
-
-	D3D11_SUBRESOURCE_DATA initData = {};
-	initData.pSysMem = vertices.data();
-
-	HRESULT result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
-	if (FAILED(result))
-		return;
+}
 
+Mesh::Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const Vertex_PosTex* pVertices, uint32_t numVertices, const uint32_t* pIndices, uint32_t numIndices)
+{
+	//Create Effect Instance
+	m_VertexFormat = VertexFormat::PosTex;
+	m_pEffect = new Effect(pDevice, assetFile, m_VertexFormat);
 
-	//Create Index Buffer
-	m_NumIndices = static_cast<uint32_t>(indices.size());
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
-	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
+	//Create Vertex & Index Buffer
+	CreateBuffers(pDevice, pVertices, sizeof(Vertex_PosTex) * numVertices, pIndices, numIndices);
+}
 
-	initData.pSysMem = indices.data();
+Mesh::Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const Vertex_PosTexPacked* pVertices, uint32_t numVertices, const uint32_t* pIndices, uint32_t numIndices, const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	//Create Effect Instance, the vertex shader maps the unorm positions back onto the bounds
+	m_VertexFormat = VertexFormat::PosTexPacked;
+	m_pEffect = new Effect(pDevice, assetFile, m_VertexFormat);
+	m_pEffect->SetPositionDequantization(VertexPacking::GetPositionScale(boundsMin, boundsMax), boundsMin);
 
-	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
-	if (FAILED(result))
-		return;
+	//Create Vertex & Index Buffer
+	CreateBuffers(pDevice, pVertices, sizeof(Vertex_PosTexPacked) * numVertices, pIndices, numIndices);
 }
 
 
@@ -103,14 +68,24 @@ Mesh::~Mesh()
 	delete m_pNormalTexture;
 	delete m_pSpecularTexture;
 	delete m_pGlossTexture;
+
+	for (Texture* pTexture : m_pMaterialTextures)
+	{
+		delete pTexture;
+	}
 }
 
 
 //-----------------------------------------------------------------
 // Public Member Functions
 //-----------------------------------------------------------------
-void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
+void Mesh::Render(ID3D11DeviceContext* pDeviceContext, RenderStatistics& statistics) const
 {
+	//Nothing to bind when every meshlet got culled
+	if (m_CurrentLOD == 0 && !m_Meshlets.empty() && m_DrawRanges.empty())
+		return;
+	++statistics.numMeshes;
+
 	//1. Set Primitive Topology
 	pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -118,32 +93,113 @@ void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
 	pDeviceContext->IASetInputLayout(m_pEffect->GetInputLayout());
 
 	//3. Set Vertex Buffer
-	if (m_IsTextured)
+	UINT stride{};
+	switch (m_VertexFormat)
 	{
-		constexpr UINT stride = sizeof(Vertex_PosTex);
-		constexpr UINT offset = 0;
-		pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
-	}
-	else
-	{
-		constexpr UINT stride = sizeof(Vertex_PosCol);
-		constexpr UINT offset = 0;
-		pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	case VertexFormat::PosCol:
+		stride = sizeof(Vertex_PosCol);
+		break;
+	case VertexFormat::PosTex:
+		stride = sizeof(Vertex_PosTex);
+		break;
+	case VertexFormat::PosTexPacked:
+		stride = sizeof(Vertex_PosTexPacked);
+		break;
 	}
+	constexpr UINT offset = 0;
+	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
 
 	//4. Set Index Buffer
 	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	statistics.numStateChanges += 4; //Topology, input layout, vertex and index buffer
 
-	//5. Draw
+	//5. Draw, only the meshlets that survived culling if there are any, simplified levels are drawn whole
 	D3DX11_TECHNIQUE_DESC techDesc{};
 	m_pEffect->GetTechnique()->GetDesc(&techDesc);
 	for (UINT p = 0; p < techDesc.Passes; ++p)
 	{
+		if (!m_Submeshes.empty())
+		{
+			RenderSubmeshes(pDeviceContext, m_pEffect->GetTechnique()->GetPassByIndex(p), statistics);
+			continue;
+		}
+
 		m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		++statistics.numStateChanges;
+		if (m_CurrentLOD > 0)
+		{
+			pDeviceContext->DrawIndexed(m_LODs[m_CurrentLOD].numIndices, m_LODs[m_CurrentLOD].indexOffset, 0);
+			++statistics.numDrawCalls;
+			continue;
+		}
+		if (m_Meshlets.empty())
+		{
+			pDeviceContext->DrawIndexed(m_LODs.empty() ? m_NumIndices : m_LODs[0].numIndices, 0, 0);
+			++statistics.numDrawCalls;
+			continue;
+		}
+
+		for (const DrawRange& drawRange : m_DrawRanges)
+		{
+			pDeviceContext->DrawIndexed(drawRange.numIndices, drawRange.indexOffset, 0);
+		}
+		statistics.numDrawCalls += static_cast<uint32_t>(m_DrawRanges.size());
 	}
 }
 
+void Mesh::CullMeshlets(const Matrix& view, const Matrix& projection)
+{
+	if (m_Meshlets.empty() || m_CurrentLOD > 0)
+		return;
+
+	m_CullStatistics = Meshlets::Cull(m_Meshlets, GetWorldMatrix(), view, projection, m_CullBackfaces, m_DrawRanges);
+}
+
+void Mesh::SelectLOD(const Vector3& cameraPosition, const Matrix& projection, float screenHeight)
+{
+	if (m_LODs.size() < 2)
+		return;
+
+	//Measure from the closest point of the bounding sphere, the errors grow with the largest scale
+	const float scale = std::max(std::max(m_Scale.x, m_Scale.y), m_Scale.z);
+	const Vector3 center = GetWorldMatrix().TransformPoint(m_LODCenter);
+	const float distance = (center - cameraPosition).Magnitude() - m_LODRadius * scale;
+
+	m_CurrentLOD = MeshSimplifier::SelectLOD(m_LODs.data(), static_cast<uint32_t>(m_LODs.size()), distance / scale, projection[1].y, screenHeight);
+}
+
+float Mesh::GetScreenSize(const Vector3& cameraPosition, const Matrix& projection, float screenHeight) const
+{
+	const bool isCulled = m_CurrentLOD == 0 && m_CullStatistics.numMeshlets > 0 && m_CullStatistics.numFrustumCulled == m_CullStatistics.numMeshlets;
+	if (m_LODRadius <= 0.f || isCulled)
+		return 0.f;
+
+	const float scale = std::max(std::max(m_Scale.x, m_Scale.y), m_Scale.z);
+	const Vector3 center = GetWorldMatrix().TransformPoint(m_LODCenter);
+	const float distance = (center - cameraPosition).Magnitude() - m_LODRadius * scale;
+
+	return TextureStreamer::GetScreenSize(m_LODRadius * scale, distance, projection[1].y, screenHeight);
+}
+
+void Mesh::GetTextures(std::vector<Texture*>& textures) const
+{
+	for (Texture* pTexture : { m_pDiffuseTexture, m_pNormalTexture, m_pSpecularTexture, m_pGlossTexture })
+	{
+		if (pTexture)
+			textures.push_back(pTexture);
+	}
+	textures.insert(textures.end(), m_pMaterialTextures.begin(), m_pMaterialTextures.end());
+}
+
+void Mesh::RebindTextures()
+{
+	if (m_pDiffuseTexture) m_pEffect->SetDiffuseMap(m_pDiffuseTexture);
+	if (m_pNormalTexture) m_pEffect->SetNormalMap(m_pNormalTexture);
+	if (m_pSpecularTexture) m_pEffect->SetSpecularMap(m_pSpecularTexture);
+	if (m_pGlossTexture) m_pEffect->SetGlossinessMap(m_pGlossTexture);
+	m_pEffect->SetGlossInSpecularAlpha(m_pSpecularTexture && m_pSpecularTexture->HasPackedAlpha());
+}
+
 void Mesh::ToggleSamplerState() const
 {
 	m_pEffect->ToggleTechnique();
@@ -198,8 +254,227 @@ void Mesh::SetScale(const Vector3& scale)
 	m_Scale = scale;
 }
 
+void Mesh::SetMeshlets(const Meshlet* pMeshlets, uint32_t numMeshlets)
+{
+	m_Meshlets.assign(pMeshlets, pMeshlets + numMeshlets);
+
+	//Draw the whole first level until the first cull
+	m_DrawRanges.assign(1, DrawRange{ 0, m_LODs.empty() ? m_NumIndices : m_LODs[0].numIndices });
+}
+
+void Mesh::SetLODs(const LevelOfDetail* pLods, uint32_t numLods, const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	m_LODs.assign(pLods, pLods + numLods);
+	m_CurrentLOD = 0;
+
+	m_LODCenter = (boundsMin + boundsMax) * 0.5f;
+	m_LODRadius = (boundsMax - boundsMin).Magnitude() * 0.5f;
+}
+
+void Mesh::SetMaterials(ID3D11Device* pDevice, const Material* pMaterials, uint32_t numMaterials, const Submesh* pSubmeshes)
+{
+	const size_t numLods = std::max(m_LODs.size(), size_t(1));
+	m_Submeshes.assign(pSubmeshes, pSubmeshes + numLods * numMaterials);
+
+	//Every texture is loaded once, no matter how many materials use it, and all of them are decoded together
+	//A gloss map next to a specular map is packed into its alpha, so the texture is keyed on both paths
+	std::map<std::pair<std::string, std::string>, Texture*> textures{};
+	std::vector<TextureLoader::Request> requests{};
+	const auto addRequest = [&](const std::string& path, TextureUsage usage, const std::string& alphaPath)
+		{
+			if (!path.empty() && textures.emplace(std::make_pair(path, alphaPath), nullptr).second)
+				requests.push_back({ path, usage, alphaPath });
+		};
+	const auto getPackedGloss = [](const Material& material)
+		{
+			return material.specularMap.empty() ? std::string{} : material.glossMap;
+		};
+
+	for (uint32_t material = 0; material < numMaterials; ++material)
+	{
+		const Material& source = pMaterials[material];
+		const std::string packedGloss = getPackedGloss(source);
+		addRequest(source.diffuseMap, TextureUsage::Color, {});
+		addRequest(source.normalMap, TextureUsage::Normal, {});
+		addRequest(source.specularMap, TextureUsage::Data, packedGloss);
+		addRequest(packedGloss.empty() ? source.glossMap : std::string{}, TextureUsage::Data, {});
+	}
+
+	const auto loadRequests = [&](size_t first)
+		{
+			if (first == requests.size())
+				return;
+
+			const std::vector<TextureLoader::Request> batch(requests.begin() + first, requests.end());
+			const std::vector<Texture*> loaded = TextureLoader::CreateTextures(pDevice, batch);
+			for (size_t index = 0; index < batch.size(); ++index)
+			{
+				textures[std::make_pair(batch[index].path, batch[index].alphaPath)] = loaded[index];
+				m_pMaterialTextures.push_back(loaded[index]);
+			}
+		};
+	loadRequests(0);
+
+	const auto findTexture = [&](const std::string& path, const std::string& alphaPath) -> Texture*
+		{
+			return path.empty() ? nullptr : textures[std::make_pair(path, alphaPath)];
+		};
+
+	//A gloss map that couldn't be packed, like one of another size than its specular map, is loaded as a map of its own
+	const auto getSeparateGloss = [&](const Material& material)
+		{
+			const std::string packedGloss = getPackedGloss(material);
+			const Texture* pSpecular = findTexture(material.specularMap, packedGloss);
+			return packedGloss.empty() || (pSpecular && !pSpecular->HasPackedAlpha()) ? material.glossMap : std::string{};
+		};
+
+	const size_t numPackedRequests = requests.size();
+	for (uint32_t material = 0; material < numMaterials; ++material)
+	{
+		addRequest(getSeparateGloss(pMaterials[material]), TextureUsage::Data, {});
+	}
+	loadRequests(numPackedRequests);
+
+	m_MaterialTextures.clear();
+	for (uint32_t material = 0; material < numMaterials; ++material)
+	{
+		const Material& source = pMaterials[material];
+		m_MaterialTextures.push_back(MaterialTextures{
+			findTexture(source.diffuseMap, {}),
+			findTexture(source.normalMap, {}),
+			findTexture(source.specularMap, getPackedGloss(source)),
+			findTexture(getSeparateGloss(source), {}) });
+	}
+}
+
 
 //-----------------------------------------------------------------
 // Private Member Functions
 //-----------------------------------------------------------------
+void Mesh::CreateBuffers(ID3D11Device* pDevice, const void* pVertices, uint32_t vertexBufferSize, const uint32_t* pIndices, uint32_t numIndices)
+{
+	//Create Vertex Buffer
+	m_VertexBufferSize = vertexBufferSize;
+	D3D11_BUFFER_DESC bd = {};
+	bd.Usage = D3D11_USAGE_IMMUTABLE;
+	bd.ByteWidth = m_VertexBufferSize;
+	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	bd.CPUAccessFlags = 0;
+	bd.MiscFlags = 0;
+
+	D3D11_SUBRESOURCE_DATA initData = {};
+	initData.pSysMem = pVertices;
+
+	HRESULT result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
+	if (FAILED(result))
+		return;
+
 
+	//Create Index Buffer
+	m_NumIndices = numIndices;
+	bd.Usage = D3D11_USAGE_IMMUTABLE;
+	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
+	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	bd.CPUAccessFlags = 0;
+	bd.MiscFlags = 0;
+
+	initData.pSysMem = pIndices;
+
+	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
+	if (FAILED(result))
+		return;
+}
+
+void Mesh::RenderSubmeshes(ID3D11DeviceContext* pDeviceContext, ID3DX11EffectPass* pPass, RenderStatistics& statistics) const
+{
+	const size_t numMaterials = m_MaterialTextures.size();
+	const Submesh* pLevel = m_Submeshes.data() + m_CurrentLOD * numMaterials;
+	const bool isCulled = m_CurrentLOD == 0 && !m_Meshlets.empty();
+
+	//The materials are sorted on their maps, so only the maps that differ from the last material drawn get set
+	MaterialTextures bound{};
+	const MaterialTextures* pBound{};
+	bool isBoundGlossPacked{};
+	size_t drawRange{};
+	for (size_t material = 0; material < numMaterials; ++material)
+	{
+		const Submesh& submesh = pLevel[material];
+		const uint32_t submeshEnd = submesh.indexOffset + submesh.numIndices;
+
+		//Maps the material doesn't have fall back to the mesh's own, which can still be set after SetMaterials
+		const MaterialTextures& materialTextures = m_MaterialTextures[material];
+		const MaterialTextures textures{
+			materialTextures.pDiffuse ? materialTextures.pDiffuse : m_pDiffuseTexture,
+			materialTextures.pNormal ? materialTextures.pNormal : m_pNormalTexture,
+			materialTextures.pSpecular ? materialTextures.pSpecular : m_pSpecularTexture,
+			materialTextures.pGloss ? materialTextures.pGloss : m_pGlossTexture };
+
+		//Materials without any visible triangles don't bind anything
+		bool isBound{};
+		const auto draw = [&](uint32_t indexOffset, uint32_t numIndices)
+			{
+				if (!isBound)
+				{
+					bool hasChanged = !pBound;
+					const auto bind = [&](Texture* pTexture, Texture* pBoundTexture, void (Effect::*setMap)(Texture*))
+						{
+							//A map nobody has leaves whatever the effect had bound
+							if (!pTexture || (pBound && pTexture == pBoundTexture))
+								return;
+
+							(m_pEffect->*setMap)(pTexture);
+							++statistics.numTextureBinds;
+							hasChanged = true;
+						};
+					bind(textures.pDiffuse, pBound ? pBound->pDiffuse : nullptr, &Effect::SetDiffuseMap);
+					bind(textures.pNormal, pBound ? pBound->pNormal : nullptr, &Effect::SetNormalMap);
+					bind(textures.pSpecular, pBound ? pBound->pSpecular : nullptr, &Effect::SetSpecularMap);
+					bind(textures.pGloss, pBound ? pBound->pGloss : nullptr, &Effect::SetGlossinessMap);
+
+					//Unlike the maps the flag is always set, a material without a packed specular map reads its own gloss map
+					const bool isGlossPacked = textures.pSpecular && textures.pSpecular->HasPackedAlpha();
+					if (!pBound || isGlossPacked != isBoundGlossPacked)
+					{
+						m_pEffect->SetGlossInSpecularAlpha(isGlossPacked);
+						hasChanged = true;
+					}
+
+					//The pass only commits the maps when it's applied
+					if (hasChanged)
+					{
+						pPass->Apply(0, pDeviceContext);
+						++statistics.numStateChanges;
+					}
+					bound = textures;
+					pBound = &bound;
+					isBoundGlossPacked = isGlossPacked;
+					isBound = true;
+				}
+
+				pDeviceContext->DrawIndexed(numIndices, indexOffset, 0);
+				++statistics.numDrawCalls;
+			};
+
+		if (!isCulled)
+		{
+			if (submesh.numIndices > 0)
+				draw(submesh.indexOffset, submesh.numIndices);
+			continue;
+		}
+
+		//The draw ranges are sorted and merged over the border between two materials, so they're clipped to the submesh
+		for (; drawRange < m_DrawRanges.size(); ++drawRange)
+		{
+			const DrawRange& range = m_DrawRanges[drawRange];
+			const uint32_t rangeEnd = range.indexOffset + range.numIndices;
+			const uint32_t begin = std::max(range.indexOffset, submesh.indexOffset);
+			const uint32_t end = std::min(rangeEnd, submeshEnd);
+			if (begin < end)
+				draw(begin, end - begin);
+
+			//The rest of the range belongs to the next materials
+			if (rangeEnd > submeshEnd)
+				break;
+		}
+	}
+}
@@ -1,6 +1,9 @@
 #pragma once
 // Includes
 #include "DataTypes.h"
+#include "Material.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
 
 namespace dae
 {
@@ -8,6 +11,15 @@ namespace dae
 	class Effect;
 	class Texture;
 
+	//What the meshes asked of the device context in one frame
+	struct RenderStatistics
+	{
+		uint32_t numMeshes{};
+		uint32_t numDrawCalls{};
+		uint32_t numStateChanges{}; //Input assembler bindings and effect passes applied
+		uint32_t numTextureBinds{};
+	};
+
 	// Class Declaration
 	class Mesh final
 	{
@@ -15,6 +27,8 @@ namespace dae
 		// Constructors and Destructor
 		explicit Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<Vertex_PosCol>& vertices, const std::vector<uint32_t>& indices);
 		explicit Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<Vertex_PosTex>& vertices, const std::vector<uint32_t>& indices);
+		explicit Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const Vertex_PosTex* pVertices, uint32_t numVertices, const uint32_t* pIndices, uint32_t numIndices);
+		explicit Mesh(ID3D11Device* pDevice, const std::wstring& assetFile, const Vertex_PosTexPacked* pVertices, uint32_t numVertices, const uint32_t* pIndices, uint32_t numIndices, const Vector3& boundsMin, const Vector3& boundsMax);
 		~Mesh();
 
 		// Copy and Move semantics
@@ -26,7 +40,16 @@ namespace dae
 		//---------------------------
 		// Public Member Functions
 		//---------------------------
-		void Render(ID3D11DeviceContext* pDeviceContext) const;
+		void Render(ID3D11DeviceContext* pDeviceContext, RenderStatistics& statistics) const;
+		void CullMeshlets(const Matrix& view, const Matrix& projection);
+		void SelectLOD(const Vector3& cameraPosition, const Matrix& projection, float screenHeight);
+
+		//Pixels the bounding sphere covers on screen, 0 once CullMeshlets culled every meshlet or without bounds (SetLODs)
+		float GetScreenSize(const Vector3& cameraPosition, const Matrix& projection, float screenHeight) const;
+		//Appends every texture the mesh draws with, its own and those of its materials
+		void GetTextures(std::vector<Texture*>& textures) const;
+		//Sets the mesh's own maps on the effect again, for textures that replaced their resource view
+		void RebindTextures();
 
 		void ToggleSamplerState() const;
 		void Translate(const Vector3& translation);
@@ -39,26 +62,62 @@ namespace dae
 		void SetPosition(float x, float y, float z);
 		void SetRotation(float pitch, float yaw, float roll);
 		void SetScale(const Vector3& scale);
+		void SetMeshlets(const Meshlet* pMeshlets, uint32_t numMeshlets);
+		void SetBackfaceCulling(bool isEnabled) { m_CullBackfaces = isEnabled; }
+		void SetLODs(const LevelOfDetail* pLods, uint32_t numLods, const Vector3& boundsMin, const Vector3& boundsMax);
+
+		//Draws the submeshes of every level with their own maps, call it after SetLODs
+		//There's a submesh per material per level, see MeshCache::GetSubmeshes, maps a material doesn't have fall back to the mesh's own
+		void SetMaterials(ID3D11Device* pDevice, const Material* pMaterials, uint32_t numMaterials, const Submesh* pSubmeshes);
 
 		Effect* GetEffect() const { return m_pEffect; }
+		VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+		uint32_t GetVertexBufferSize() const { return m_VertexBufferSize; }
+		const Meshlets::CullStatistics& GetCullStatistics() const { return m_CullStatistics; }
+		uint32_t GetCurrentLOD() const { return m_CurrentLOD; }
 		Matrix GetWorldMatrix() const { return Matrix::CreateTransform(m_Position, m_Rotation, m_Scale); }
 
 
 	private:
 		// Member variables
-		bool m_IsTextured{};
+		VertexFormat m_VertexFormat{};
 		Effect* m_pEffect{};
 
 		ID3D11Buffer* m_pVertexBuffer{};
 		ID3D11Buffer* m_pIndexBuffer{};
 
+		uint32_t m_VertexBufferSize{};
 		uint32_t m_NumIndices{};
 
+		//Without meshlets the whole index buffer is drawn at once
+		std::vector<Meshlet> m_Meshlets{};
+		std::vector<DrawRange> m_DrawRanges{};
+		Meshlets::CullStatistics m_CullStatistics{};
+		bool m_CullBackfaces{ true };
+
+		//Without levels of detail the whole index buffer is the only level, meshlets always belong to the first one
+		std::vector<LevelOfDetail> m_LODs{};
+		uint32_t m_CurrentLOD{};
+		Vector3 m_LODCenter{};
+		float m_LODRadius{};
+
 		Texture* m_pDiffuseTexture{};
 		Texture* m_pNormalTexture{};
 		Texture* m_pSpecularTexture{};
 		Texture* m_pGlossTexture{};
 
+		//Without submeshes the whole level is drawn with the textures above
+		struct MaterialTextures
+		{
+			Texture* pDiffuse{};
+			Texture* pNormal{};
+			Texture* pSpecular{};
+			Texture* pGloss{};
+		};
+		std::vector<MaterialTextures> m_MaterialTextures{};
+		std::vector<Submesh> m_Submeshes{};
+		std::vector<Texture*> m_pMaterialTextures{}; //Every map once, materials share the textures with the same path
+
 		Vector3 m_Position{ 0.f, 0.f, 0.f };
 		Vector3 m_Rotation{ 0.f, 0.f, 0.f };
 		Vector3 m_Scale{ 1.f, 1.f, 1.f };
@@ -66,6 +125,8 @@ namespace dae
 		//---------------------------
 		// Private Member Functions
 		//---------------------------
+		void CreateBuffers(ID3D11Device* pDevice, const void* pVertices, uint32_t vertexBufferSize, const uint32_t* pIndices, uint32_t numIndices);
+		void RenderSubmeshes(ID3D11DeviceContext* pDeviceContext, ID3DX11EffectPass* pPass, RenderStatistics& statistics) const;
 
 	};
 }
@@ -0,0 +1,472 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshCleanup.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshCodec.h"
+#include "PositionStream.h"
+#include "Utils.h"
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// File Format
+//-----------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t MeshCacheMagic{ 0x4D454144 }; //"DAEM"
+	constexpr uint32_t MeshCacheVersion{ 11 };
+	constexpr uint32_t MeshCacheAlignment{ 16 };
+
+	//Followed by the MeshCodec encoded vertices and indices, the meshlet, level of detail and submesh arrays and the material names
+	//The arrays are aligned so they can be used straight from the mapping, the vertices and indices are decoded on load
+	struct MeshCacheHeader
+	{
+		uint32_t magic{ MeshCacheMagic };
+		uint32_t version{ MeshCacheVersion };
+		uint32_t vertexSize{ sizeof(Vertex_PosTex) };
+		uint32_t flipAxisAndWinding{};
+
+		uint64_t sourceSize{};
+		int64_t sourceTime{};
+
+		uint32_t numVertices{};
+		uint32_t numIndices{};
+		uint64_t vertexOffset{};
+		uint64_t encodedVertexSize{};
+		uint64_t indexOffset{};
+		uint64_t encodedIndexSize{};
+		uint64_t meshletOffset{};
+		uint32_t numMeshlets{};
+		uint32_t meshletSize{ sizeof(Meshlet) };
+		uint64_t lodOffset{};
+		uint32_t numLODs{};
+		uint32_t lodSize{ sizeof(LevelOfDetail) };
+		uint64_t submeshOffset{};
+		uint32_t numSubmeshes{};
+		uint32_t submeshSize{ sizeof(Submesh) };
+		uint64_t materialNameOffset{}; //The material library and the names, one per line
+		uint64_t materialNameSize{};
+
+		Vector3 boundsMin{};
+		Vector3 boundsMax{};
+	};
+
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + MeshCacheAlignment - 1) & ~uint64_t(MeshCacheAlignment - 1);
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t Unused{ UINT32_MAX };
+
+	//Cleans and optimizes one mesh, builds its meshlets and levels of detail and prints what changed
+	void OptimizeMesh(const std::string& name, std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, std::vector<Meshlet>& meshlets, std::vector<LevelOfDetail>& lods)
+	{
+		//Weld the positions that are a hair apart and drop the triangles that can't produce a pixel before anything else looks at them
+		const MeshCleanup::Statistics cleanup = MeshCleanup::Clean(vertices, indices);
+		if (indices.empty())
+		{
+			meshlets.clear();
+			lods.assign(1, LevelOfDetail{});
+			std::cout << "MeshCache: " << name << " has no triangles left after cleanup\n";
+			return;
+		}
+
+		//Reorder the triangles for the post-transform cache, then sort clusters of them to reduce overdraw
+		const MeshOptimizer::VertexCacheStatistics cacheBefore = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		MeshOptimizer::OptimizeOverdraw(indices, vertices);
+
+		//Group the triangles into meshlets that can be culled on their own
+		Meshlets::Build(indices, vertices, meshlets);
+		const MeshOptimizer::VertexCacheStatistics cacheAfter = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+
+		//Append the simplified levels of detail behind the full mesh, they reuse its vertices
+		MeshSimplifier::BuildLODChain(indices, vertices, lods);
+
+		//Lay the vertices out in the order the new index buffer reads them, measured on the full mesh since only one level is drawn at a time
+		std::vector<uint32_t> fullIndices(indices.begin(), indices.begin() + lods[0].numIndices);
+		const MeshOptimizer::VertexFetchStatistics fetchBefore = MeshOptimizer::AnalyzeVertexFetch(fullIndices, vertices.size(), sizeof(Vertex_PosTex));
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+		fullIndices.assign(indices.begin(), indices.begin() + lods[0].numIndices);
+		const MeshOptimizer::VertexFetchStatistics fetchAfter = MeshOptimizer::AnalyzeVertexFetch(fullIndices, vertices.size(), sizeof(Vertex_PosTex));
+
+		std::cout << "MeshCache: " << name << " welded " << cleanup.numWeldedPositions << " positions, merged " << cleanup.numMergedVertices
+			<< " vertices, removed " << cleanup.numDegenerateTriangles << " degenerate and " << cleanup.numDuplicateTriangles << " duplicate triangles"
+			<< ", vertex cache ACMR " << cacheBefore.acmr << " -> " << cacheAfter.acmr
+			<< ", ATVR " << cacheBefore.atvr << " -> " << cacheAfter.atvr
+			<< ", vertex fetch overfetch " << fetchBefore.overfetch << " -> " << fetchAfter.overfetch
+			<< ", " << meshlets.size() << " meshlets, LOD triangles";
+		for (const LevelOfDetail& lod : lods)
+		{
+			std::cout << ' ' << lod.numIndices / 3;
+		}
+		std::cout << '\n';
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Constructors
+//-----------------------------------------------------------------
+MeshCache::MeshCache(const std::string& objFile, bool flipAxisAndWinding, bool extractPositions)
+{
+	//The cache is tied to the size and modification time of the source
+	std::error_code error{};
+	const uint64_t sourceSize = std::filesystem::file_size(objFile, error);
+	if (error)
+	{
+		std::cout << "MeshCache: " << objFile << " not found\n";
+		return;
+	}
+	const int64_t sourceTime = std::filesystem::last_write_time(objFile, error).time_since_epoch().count();
+
+	const std::string cacheFile = GetCachePath(objFile);
+	if (Load(cacheFile, sourceSize, sourceTime, flipAxisAndWinding))
+	{
+		LoadMaterials(objFile);
+		if (extractPositions)
+			PositionStream::Extract(m_pVertices, m_NumVertices, m_pIndices, m_NumIndices, m_Positions, m_PositionIndices);
+		return;
+	}
+
+
+	//No valid cache, parse the source and write a new one
+	Utils::ObjMaterials objMaterials{};
+	if (!Utils::ParseOBJ(objFile, m_Vertices, m_Indices, objMaterials, flipAxisAndWinding))
+	{
+		std::cout << "MeshCache: failed to parse " << objFile << '\n';
+		return;
+	}
+
+	m_MaterialLibrary = objMaterials.library;
+	m_MaterialNames = objMaterials.names;
+	LoadMaterials(objFile);
+
+	ProcessMesh(objFile, objMaterials.submeshes);
+
+	//The bounds are taken from the PositionStream, which is only kept when it was asked for
+	PositionStream::Extract(m_Vertices.data(), m_Vertices.size(), m_Indices.data(), m_Indices.size(), m_Positions, m_PositionIndices);
+	PositionStream::ComputeBounds(m_Positions.data(), m_Positions.size(), m_BoundsMin, m_BoundsMax);
+	if (!extractPositions)
+	{
+		m_Positions = {};
+		m_PositionIndices = {};
+	}
+
+	if (!Write(cacheFile, sourceSize, sourceTime, flipAxisAndWinding))
+		std::cout << "MeshCache: failed to write " << cacheFile << '\n';
+
+	m_pVertices = m_Vertices.data();
+	m_NumVertices = static_cast<uint32_t>(m_Vertices.size());
+	m_pIndices = m_Indices.data();
+	m_NumIndices = static_cast<uint32_t>(m_Indices.size());
+	m_pMeshlets = m_Meshlets.data();
+	m_NumMeshlets = static_cast<uint32_t>(m_Meshlets.size());
+	m_pLODs = m_LODs.data();
+	m_NumLODs = static_cast<uint32_t>(m_LODs.size());
+	m_pSubmeshes = m_Submeshes.data();
+}
+
+
+//-----------------------------------------------------------------
+// Destructor
+//-----------------------------------------------------------------
+MeshCache::~MeshCache()
+{
+	delete m_pFile;
+}
+
+
+//-----------------------------------------------------------------
+// Public Member Functions
+//-----------------------------------------------------------------
+
+
+//-----------------------------------------------------------------
+// Private Member Functions
+//-----------------------------------------------------------------
+void MeshCache::ProcessMesh(const std::string& objFile, const std::vector<Submesh>& objSubmeshes)
+{
+	if (objSubmeshes.empty())
+	{
+		OptimizeMesh(objFile, m_Vertices, m_Indices, m_Meshlets, m_LODs);
+		return;
+	}
+
+	//Draw order: materials with the same textures end up next to each other, so the mesh only rebinds what changed
+	std::vector<uint32_t> order(objSubmeshes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return m_Materials[a] < m_Materials[b]; });
+
+	//Every material is optimized as a mesh of its own, so no pass can move triangles from one material into another
+	//The vertices on the border between two materials are duplicated
+	struct Part
+	{
+		std::vector<Vertex_PosTex> vertices{};
+		std::vector<uint32_t> indices{};
+		std::vector<Meshlet> meshlets{};
+		std::vector<LevelOfDetail> lods{};
+	};
+	std::vector<Part> parts(order.size());
+	std::vector<uint32_t> remap(m_Vertices.size());
+	for (size_t index = 0; index < order.size(); ++index)
+	{
+		const Submesh& submesh = objSubmeshes[order[index]];
+		Part& part = parts[index];
+
+		std::fill(remap.begin(), remap.end(), Unused);
+		for (uint32_t corner = submesh.indexOffset; corner < submesh.indexOffset + submesh.numIndices; ++corner)
+		{
+			uint32_t& vertex = remap[m_Indices[corner]];
+			if (vertex == Unused)
+			{
+				vertex = static_cast<uint32_t>(part.vertices.size());
+				part.vertices.push_back(m_Vertices[m_Indices[corner]]);
+			}
+			part.indices.push_back(vertex);
+		}
+
+		const std::string& name = m_MaterialNames[order[index]];
+		OptimizeMesh(objFile + " [" + (name.empty() ? "default" : name) + "]", part.vertices, part.indices, part.meshlets, part.lods);
+	}
+
+	//Every level holds every material in draw order, materials with a shorter chain repeat their coarsest level
+	size_t numLODs{};
+	for (const Part& part : parts)
+	{
+		numLODs = std::max(numLODs, part.lods.size());
+	}
+
+	m_Vertices.clear();
+	m_Indices.clear();
+	m_Meshlets.clear();
+	m_LODs.clear();
+	m_Submeshes.clear();
+
+	std::vector<uint32_t> baseVertices(parts.size());
+	for (size_t index = 0; index < parts.size(); ++index)
+	{
+		baseVertices[index] = static_cast<uint32_t>(m_Vertices.size());
+		m_Vertices.insert(m_Vertices.end(), parts[index].vertices.begin(), parts[index].vertices.end());
+	}
+
+	for (size_t lod = 0; lod < numLODs; ++lod)
+	{
+		LevelOfDetail level{ static_cast<uint32_t>(m_Indices.size()), 0, 0.f };
+		for (size_t index = 0; index < parts.size(); ++index)
+		{
+			const Part& part = parts[index];
+			const LevelOfDetail& source = part.lods[std::min(lod, part.lods.size() - 1)];
+			const Submesh submesh{ static_cast<uint32_t>(m_Indices.size()), source.numIndices };
+			m_Submeshes.push_back(submesh);
+
+			//Meshlets only exist for the first level, which starts the part's index buffer
+			if (lod == 0)
+			{
+				for (Meshlet meshlet : part.meshlets)
+				{
+					meshlet.indexOffset += submesh.indexOffset;
+					m_Meshlets.push_back(meshlet);
+				}
+			}
+
+			for (uint32_t corner = source.indexOffset; corner < source.indexOffset + source.numIndices; ++corner)
+			{
+				m_Indices.push_back(part.indices[corner] + baseVertices[index]);
+			}
+			level.error = std::max(level.error, source.error);
+		}
+		level.numIndices = static_cast<uint32_t>(m_Indices.size()) - level.indexOffset;
+		m_LODs.push_back(level);
+	}
+
+	//The names and materials follow the draw order from here on
+	std::vector<std::string> names{};
+	std::vector<Material> materials{};
+	for (uint32_t material : order)
+	{
+		names.push_back(m_MaterialNames[material]);
+		materials.push_back(m_Materials[material]);
+	}
+	m_MaterialNames = std::move(names);
+	m_Materials = std::move(materials);
+}
+
+void MeshCache::LoadMaterials(const std::string& objFile)
+{
+	//The library is looked up next to the OBJ, materials it doesn't know keep empty maps
+	std::unordered_map<std::string, Material> library{};
+	if (!m_MaterialLibrary.empty())
+	{
+		const std::string libraryFile = (std::filesystem::path(objFile).parent_path() / m_MaterialLibrary).string();
+		if (!Utils::ParseMTL(libraryFile, library))
+			std::cout << "MeshCache: material library " << libraryFile << " not found\n";
+	}
+
+	m_Materials.clear();
+	for (const std::string& name : m_MaterialNames)
+	{
+		const auto it = library.find(name);
+		m_Materials.push_back(it != library.end() ? it->second : Material{});
+	}
+}
+
+bool MeshCache::Load(const std::string& cacheFile, uint64_t sourceSize, int64_t sourceTime, bool flipAxisAndWinding)
+{
+	MappedFile* pFile = new MappedFile(cacheFile);
+	if (pFile->GetSize() < sizeof(MeshCacheHeader))
+	{
+		delete pFile;
+		return false;
+	}
+
+	//Reject caches from an older version, another vertex layout or a changed source
+	const MeshCacheHeader* pHeader = reinterpret_cast<const MeshCacheHeader*>(pFile->GetData());
+	const bool isValid = pHeader->magic == MeshCacheMagic
+		&& pHeader->version == MeshCacheVersion
+		&& pHeader->vertexSize == sizeof(Vertex_PosTex)
+		&& pHeader->meshletSize == sizeof(Meshlet)
+		&& pHeader->lodSize == sizeof(LevelOfDetail)
+		&& pHeader->submeshSize == sizeof(Submesh)
+		&& pHeader->flipAxisAndWinding == uint32_t(flipAxisAndWinding)
+		&& pHeader->sourceSize == sourceSize
+		&& pHeader->sourceTime == sourceTime
+		&& pHeader->vertexOffset + pHeader->encodedVertexSize <= pFile->GetSize()
+		&& pHeader->indexOffset + pHeader->encodedIndexSize <= pFile->GetSize()
+		&& pHeader->meshletOffset + uint64_t(pHeader->numMeshlets) * sizeof(Meshlet) <= pFile->GetSize()
+		&& pHeader->lodOffset + uint64_t(pHeader->numLODs) * sizeof(LevelOfDetail) <= pFile->GetSize()
+		&& pHeader->submeshOffset + uint64_t(pHeader->numSubmeshes) * sizeof(Submesh) <= pFile->GetSize()
+		&& pHeader->materialNameOffset + pHeader->materialNameSize <= pFile->GetSize();
+
+	if (!isValid || pHeader->numVertices == 0)
+	{
+		delete pFile;
+		return false;
+	}
+
+	//The first line is the material library, every line after it a material name
+	std::string materialLibrary{};
+	std::vector<std::string> materialNames{};
+	std::istringstream names{ std::string(pFile->GetData() + pHeader->materialNameOffset, pHeader->materialNameSize) };
+	std::getline(names, materialLibrary);
+	for (std::string name{}; std::getline(names, name);)
+	{
+		materialNames.push_back(name);
+	}
+
+	//Every level holds one submesh per material, and each of them has to stay inside the index buffer
+	const Submesh* pSubmeshes = reinterpret_cast<const Submesh*>(pFile->GetData() + pHeader->submeshOffset);
+	bool areSubmeshesValid = pHeader->numSubmeshes == uint64_t(std::max(pHeader->numLODs, 1u)) * materialNames.size();
+	for (uint32_t index = 0; areSubmeshesValid && index < pHeader->numSubmeshes; ++index)
+	{
+		areSubmeshesValid = uint64_t(pSubmeshes[index].indexOffset) + pSubmeshes[index].numIndices <= pHeader->numIndices;
+	}
+
+	if (!areSubmeshesValid)
+	{
+		delete pFile;
+		return false;
+	}
+
+	//Decode the vertices and indices straight into the buffers handed to the mesh
+	m_Vertices.resize(pHeader->numVertices);
+	m_Indices.resize(pHeader->numIndices);
+	if (!MeshCodec::DecodeVertexBuffer(m_Vertices.data(), m_Vertices.size(), sizeof(Vertex_PosTex), reinterpret_cast<const uint8_t*>(pFile->GetData() + pHeader->vertexOffset), pHeader->encodedVertexSize)
+		|| !MeshCodec::DecodeIndexBuffer(m_Indices.data(), m_Indices.size(), reinterpret_cast<const uint8_t*>(pFile->GetData() + pHeader->indexOffset), pHeader->encodedIndexSize))
+	{
+		m_Vertices.clear();
+		m_Indices.clear();
+		delete pFile;
+		return false;
+	}
+
+	//The meshlets and levels of detail point straight into the mapping, nothing is copied
+	m_pFile = pFile;
+	m_pVertices = m_Vertices.data();
+	m_NumVertices = pHeader->numVertices;
+	m_pIndices = m_Indices.data();
+	m_NumIndices = pHeader->numIndices;
+	m_pMeshlets = reinterpret_cast<const Meshlet*>(pFile->GetData() + pHeader->meshletOffset);
+	m_NumMeshlets = pHeader->numMeshlets;
+	m_pLODs = reinterpret_cast<const LevelOfDetail*>(pFile->GetData() + pHeader->lodOffset);
+	m_NumLODs = pHeader->numLODs;
+	m_pSubmeshes = pSubmeshes;
+
+	m_MaterialLibrary = std::move(materialLibrary);
+	m_MaterialNames = std::move(materialNames);
+	m_BoundsMin = pHeader->boundsMin;
+	m_BoundsMax = pHeader->boundsMax;
+
+	return true;
+}
+
+bool MeshCache::Write(const std::string& cacheFile, uint64_t sourceSize, int64_t sourceTime, bool flipAxisAndWinding) const
+{
+	std::vector<uint8_t> encodedVertices{};
+	std::vector<uint8_t> encodedIndices{};
+	MeshCodec::EncodeVertexBuffer(m_Vertices.data(), m_Vertices.size(), sizeof(Vertex_PosTex), encodedVertices);
+	MeshCodec::EncodeIndexBuffer(m_Indices.data(), m_Indices.size(), encodedIndices);
+
+	std::string materialNames = m_MaterialLibrary + '\n';
+	for (const std::string& name : m_MaterialNames)
+	{
+		materialNames += name + '\n';
+	}
+
+	MeshCacheHeader header{};
+	header.flipAxisAndWinding = uint32_t(flipAxisAndWinding);
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.numVertices = static_cast<uint32_t>(m_Vertices.size());
+	header.numIndices = static_cast<uint32_t>(m_Indices.size());
+	header.vertexOffset = AlignOffset(sizeof(MeshCacheHeader));
+	header.encodedVertexSize = encodedVertices.size();
+	header.indexOffset = AlignOffset(header.vertexOffset + encodedVertices.size());
+	header.encodedIndexSize = encodedIndices.size();
+	header.numMeshlets = static_cast<uint32_t>(m_Meshlets.size());
+	header.meshletOffset = AlignOffset(header.indexOffset + encodedIndices.size());
+	header.numLODs = static_cast<uint32_t>(m_LODs.size());
+	header.lodOffset = AlignOffset(header.meshletOffset + m_Meshlets.size() * sizeof(Meshlet));
+	header.numSubmeshes = static_cast<uint32_t>(m_Submeshes.size());
+	header.submeshOffset = AlignOffset(header.lodOffset + m_LODs.size() * sizeof(LevelOfDetail));
+	header.materialNameOffset = header.submeshOffset + m_Submeshes.size() * sizeof(Submesh);
+	header.materialNameSize = materialNames.size();
+	header.boundsMin = m_BoundsMin;
+	header.boundsMax = m_BoundsMax;
+
+	std::ofstream file(cacheFile, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	const char padding[MeshCacheAlignment]{};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(padding, header.vertexOffset - sizeof(header));
+	file.write(reinterpret_cast<const char*>(encodedVertices.data()), encodedVertices.size());
+	file.write(padding, header.indexOffset - header.vertexOffset - encodedVertices.size());
+	file.write(reinterpret_cast<const char*>(encodedIndices.data()), encodedIndices.size());
+	file.write(padding, header.meshletOffset - header.indexOffset - encodedIndices.size());
+	file.write(reinterpret_cast<const char*>(m_Meshlets.data()), m_Meshlets.size() * sizeof(Meshlet));
+	file.write(padding, header.lodOffset - header.meshletOffset - m_Meshlets.size() * sizeof(Meshlet));
+	file.write(reinterpret_cast<const char*>(m_LODs.data()), m_LODs.size() * sizeof(LevelOfDetail));
+	file.write(padding, header.submeshOffset - header.lodOffset - m_LODs.size() * sizeof(LevelOfDetail));
+	file.write(reinterpret_cast<const char*>(m_Submeshes.data()), m_Submeshes.size() * sizeof(Submesh));
+	file.write(materialNames.data(), materialNames.size());
+
+	return file.good();
+}
@@ -0,0 +1,104 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+#include "Material.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+
+namespace dae
+{
+	// Class Forward Declarations
+	class MappedFile;
+	
+	// Class Declaration
+	class MeshCache final
+	{
+	public:
+		// Constructors and Destructor
+		//extractPositions also builds the PositionStream of every level, it isn't stored in the cache
+		explicit MeshCache(const std::string& objFile, bool flipAxisAndWinding = true, bool extractPositions = false);
+		~MeshCache();
+		
+		// Copy and Move semantics
+		MeshCache(const MeshCache& other)					= delete;
+		MeshCache& operator=(const MeshCache& other)		= delete;
+		MeshCache(MeshCache&& other) noexcept				= delete;
+		MeshCache& operator=(MeshCache&& other) noexcept	= delete;
+	
+		//---------------------------
+		// Public Member Functions
+		//---------------------------
+		static std::string GetCachePath(const std::string& objFile) { return objFile + ".meshcache"; }
+
+		bool IsValid() const { return m_pVertices != nullptr; }
+		bool IsFromCache() const { return m_pFile != nullptr; }
+
+		const Vertex_PosTex* GetVertices() const { return m_pVertices; }
+		uint32_t GetNumVertices() const { return m_NumVertices; }
+		const uint32_t* GetIndices() const { return m_pIndices; }
+		uint32_t GetNumIndices() const { return m_NumIndices; }
+		const Meshlet* GetMeshlets() const { return m_pMeshlets; }
+		uint32_t GetNumMeshlets() const { return m_NumMeshlets; }
+		const LevelOfDetail* GetLODs() const { return m_pLODs; }
+		uint32_t GetNumLODs() const { return m_NumLODs; }
+
+		//One material per usemtl name in draw order, meshes without usemtl have none
+		//The maps come from the material library next to the OBJ, the effect is left to the caller
+		const Material* GetMaterials() const { return m_Materials.data(); }
+		uint32_t GetNumMaterials() const { return static_cast<uint32_t>(m_Materials.size()); }
+		const std::string& GetMaterialName(uint32_t material) const { return m_MaterialNames[material]; }
+
+		//GetNumLODs() * GetNumMaterials() ranges, level by level, every level has the materials in draw order
+		const Submesh* GetSubmeshes() const { return m_pSubmeshes; }
+
+		//Empty unless the positions were extracted, there are as many position indices as indices
+		const Vector3* GetPositions() const { return m_Positions.data(); }
+		uint32_t GetNumPositions() const { return static_cast<uint32_t>(m_Positions.size()); }
+		const uint32_t* GetPositionIndices() const { return m_PositionIndices.data(); }
+
+		const Vector3& GetBoundsMin() const { return m_BoundsMin; }
+		const Vector3& GetBoundsMax() const { return m_BoundsMax; }
+
+		
+	private:
+		// Member variables
+		MappedFile* m_pFile{};
+
+		//Decoded from the cache, or parsed when there was no valid cache
+		//The meshlets and levels of detail are only used in the second case, otherwise they stay in the mapping
+		std::vector<Vertex_PosTex> m_Vertices{};
+		std::vector<uint32_t> m_Indices{};
+		std::vector<Meshlet> m_Meshlets{};
+		std::vector<LevelOfDetail> m_LODs{};
+		std::vector<Submesh> m_Submeshes{};
+
+		std::string m_MaterialLibrary{};
+		std::vector<std::string> m_MaterialNames{};
+		std::vector<Material> m_Materials{};
+
+		std::vector<Vector3> m_Positions{};
+		std::vector<uint32_t> m_PositionIndices{};
+
+		const Vertex_PosTex* m_pVertices{};
+		uint32_t m_NumVertices{};
+		const uint32_t* m_pIndices{};
+		uint32_t m_NumIndices{}; //Every level of detail, back to back
+		const Meshlet* m_pMeshlets{};
+		uint32_t m_NumMeshlets{};
+		const LevelOfDetail* m_pLODs{};
+		uint32_t m_NumLODs{};
+		const Submesh* m_pSubmeshes{};
+
+		Vector3 m_BoundsMin{};
+		Vector3 m_BoundsMax{};
+	
+		//---------------------------
+		// Private Member Functions
+		//---------------------------
+		void ProcessMesh(const std::string& objFile, const std::vector<Submesh>& objSubmeshes);
+		void LoadMaterials(const std::string& objFile);
+		bool Load(const std::string& cacheFile, uint64_t sourceSize, int64_t sourceTime, bool flipAxisAndWinding);
+		bool Write(const std::string& cacheFile, uint64_t sourceSize, int64_t sourceTime, bool flipAxisAndWinding) const;
+	
+	};
+}
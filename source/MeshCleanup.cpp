@@ -0,0 +1,316 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MeshCleanup.h"
+#include "TangentGenerator.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t Empty{ UINT32_MAX };
+
+	uint32_t GetTableSize(size_t numItems)
+	{
+		//Power of two at least twice the number of items keeps the linear probes short
+		uint32_t size{ 16 };
+		while (size < numItems * 2)
+		{
+			size *= 2;
+		}
+		return size;
+	}
+
+	//Cells are this many tolerances wide, a position only has to look into the neighbours on the axes where it's near a side of its cell
+	//Most positions are in the middle of their cell and need a single lookup
+	constexpr float CellSizeInTolerances{ 16.f };
+
+	//Open addressing table from grid cell to the vertices stored in it
+	class SpatialHashGrid final
+	{
+	public:
+		SpatialHashGrid(size_t numVertices, const Vector3& origin, float cellSize, float tolerance)
+			: m_Cells(GetTableSize(numVertices))
+			, m_NextInCell(numVertices, Empty)
+			, m_Origin{ origin }
+			, m_InvCellSize{ 1.f / cellSize }
+			, m_Border{ tolerance / cellSize }
+		{
+		}
+
+		//Lowest vertex within the tolerance of position, or Empty
+		uint32_t Find(const Vector3& position, float toleranceSquared, const std::vector<Vertex_PosTex>& vertices) const
+		{
+			const Vector3 cell = (position - m_Origin) * m_InvCellSize;
+			const int32_t base[3]{ int32_t(floorf(cell.x)), int32_t(floorf(cell.y)), int32_t(floorf(cell.z)) };
+
+			//Per axis the neighbour on the near side, or 0 when the tolerance doesn't reach out of the cell
+			int32_t side[3]{};
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float offset = cell[axis] - float(base[axis]);
+				side[axis] = offset < m_Border ? -1 : offset > 1.f - m_Border ? 1 : 0;
+			}
+
+			uint32_t found{ Empty };
+			for (int32_t neighbour = 0; neighbour < 8; ++neighbour)
+			{
+				if ((neighbour & 1 && side[0] == 0) || (neighbour & 2 && side[1] == 0) || (neighbour & 4 && side[2] == 0))
+					continue;
+
+				const int32_t x = base[0] + (neighbour & 1 ? side[0] : 0);
+				const int32_t y = base[1] + (neighbour & 2 ? side[1] : 0);
+				const int32_t z = base[2] + (neighbour & 4 ? side[2] : 0);
+
+				const Cell* pCell = FindCell(x, y, z);
+				for (uint32_t vertex = pCell ? pCell->first : Empty; vertex != Empty && vertex < found; vertex = m_NextInCell[vertex])
+				{
+					if ((vertices[vertex].position - position).SqrMagnitude() <= toleranceSquared)
+						found = vertex;
+				}
+			}
+			return found;
+		}
+
+		void Insert(uint32_t vertex, const Vector3& position)
+		{
+			const Vector3 cell = (position - m_Origin) * m_InvCellSize;
+			const int32_t x = int32_t(floorf(cell.x));
+			const int32_t y = int32_t(floorf(cell.y));
+			const int32_t z = int32_t(floorf(cell.z));
+
+			//Vertices are inserted in increasing order, so every cell's list stays sorted
+			for (uint32_t slot = Hash(x, y, z);; slot = (slot + 1) & uint32_t(m_Cells.size() - 1))
+			{
+				Cell& entry = m_Cells[slot];
+				if (entry.first == Empty)
+				{
+					entry = Cell{ x, y, z, vertex, vertex };
+					return;
+				}
+				if (entry.x == x && entry.y == y && entry.z == z)
+				{
+					m_NextInCell[entry.last] = vertex;
+					entry.last = vertex;
+					return;
+				}
+			}
+		}
+
+	private:
+		struct Cell
+		{
+			int32_t x{}, y{}, z{};
+			uint32_t first{ Empty };
+			uint32_t last{ Empty };
+		};
+
+		std::vector<Cell> m_Cells;
+		std::vector<uint32_t> m_NextInCell;
+		Vector3 m_Origin;
+		float m_InvCellSize;
+		float m_Border; //The tolerance in cells
+
+		uint32_t Hash(int32_t x, int32_t y, int32_t z) const
+		{
+			return ((uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u) ^ (uint32_t(z) * 83492791u)) & uint32_t(m_Cells.size() - 1);
+		}
+
+		const Cell* FindCell(int32_t x, int32_t y, int32_t z) const
+		{
+			for (uint32_t slot = Hash(x, y, z);; slot = (slot + 1) & uint32_t(m_Cells.size() - 1))
+			{
+				const Cell& entry = m_Cells[slot];
+				if (entry.first == Empty)
+					return nullptr;
+				if (entry.x == x && entry.y == y && entry.z == z)
+					return &entry;
+			}
+		}
+	};
+
+	bool HaveSameAttributes(const Vertex_PosTex& a, const Vertex_PosTex& b)
+	{
+		//The tangents are rebuilt afterwards, so they don't have to match
+		return a.normal.x == b.normal.x && a.normal.y == b.normal.y && a.normal.z == b.normal.z
+			&& a.uv.x == b.uv.x && a.uv.y == b.uv.y;
+	}
+
+	//Rotated so the lowest index comes first, which keeps the winding
+	void GetCanonicalTriangle(const uint32_t* pTriangle, uint32_t canonical[3])
+	{
+		const uint32_t first = pTriangle[0] < pTriangle[1] ? (pTriangle[0] < pTriangle[2] ? 0 : 2) : (pTriangle[1] < pTriangle[2] ? 1 : 2);
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			canonical[corner] = pTriangle[(first + corner) % 3];
+		}
+	}
+
+	uint32_t HashTriangle(const uint32_t triangle[3])
+	{
+		return (triangle[0] * 73856093u) ^ (triangle[1] * 19349663u) ^ (triangle[2] * 83492791u);
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+MeshCleanup::Statistics MeshCleanup::Clean(std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, float relativeTolerance)
+{
+	Statistics statistics{};
+	if (vertices.empty())
+		return statistics;
+
+	Vector3 boundsMin = vertices[0].position;
+	Vector3 boundsMax = vertices[0].position;
+	for (const Vertex_PosTex& vertex : vertices)
+	{
+		boundsMin = Vector3{ std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z) };
+		boundsMax = Vector3{ std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z) };
+	}
+	const float tolerance = (boundsMax - boundsMin).Magnitude() * relativeTolerance;
+	const float toleranceSquared = tolerance * tolerance;
+
+	//Snap every position onto the lowest vertex within the tolerance that wasn't snapped itself
+	//A zero tolerance still welds exact copies, the grid just needs cells of some size
+	const uint32_t numVertices = static_cast<uint32_t>(vertices.size());
+	std::vector<uint32_t> positionRemap(numVertices);
+	{
+		const float cellSize = tolerance > 0.f ? tolerance * CellSizeInTolerances : std::max((boundsMax - boundsMin).Magnitude(), 1.f) / float(numVertices);
+		SpatialHashGrid grid{ vertices.size(), boundsMin, cellSize, tolerance };
+
+		for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+		{
+			const Vector3& position = vertices[vertex].position;
+			const uint32_t found = grid.Find(position, toleranceSquared, vertices);
+			if (found == Empty)
+			{
+				positionRemap[vertex] = vertex;
+				grid.Insert(vertex, position);
+				continue;
+			}
+
+			positionRemap[vertex] = found;
+			const Vector3& target = vertices[found].position;
+			if (target.x != position.x || target.y != position.y || target.z != position.z)
+				++statistics.numWeldedPositions;
+		}
+	}
+
+	//Merge the vertices on one position that have the same normal and uv, the lists are threaded through the vertices on that position
+	std::vector<uint32_t> vertexRemap(numVertices);
+	{
+		std::vector<uint32_t> nextOnPosition(numVertices, Empty);
+		std::vector<uint32_t> lastOnPosition(numVertices, Empty);
+		for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+		{
+			const uint32_t position = positionRemap[vertex];
+			vertices[vertex].position = vertices[position].position;
+
+			vertexRemap[vertex] = vertex;
+			for (uint32_t other = position; other != Empty && other != vertex; other = nextOnPosition[other])
+			{
+				if (HaveSameAttributes(vertices[other], vertices[vertex]))
+				{
+					vertexRemap[vertex] = other;
+					break;
+				}
+			}
+
+			if (vertexRemap[vertex] == vertex && position != vertex)
+				nextOnPosition[lastOnPosition[position]] = vertex;
+			if (vertexRemap[vertex] == vertex)
+				lastOnPosition[position] = vertex;
+		}
+	}
+
+	//Drop triangles thinner than the tolerance and repeats of earlier triangles
+	//Every slot holds the hash of a kept triangle next to its index, so most probes don't have to read the triangle itself
+	std::vector<uint64_t> triangleTable(GetTableSize(indices.size() / 3), UINT64_MAX);
+	const uint32_t tableMask = static_cast<uint32_t>(triangleTable.size() - 1);
+	size_t numKept{};
+	for (size_t triangle = 0; triangle < indices.size() / 3; ++triangle)
+	{
+		uint32_t corners[3]{};
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			corners[corner] = vertexRemap[indices[triangle * 3 + corner]];
+		}
+
+		//Twice the area over the longest edge is the height of the triangle
+		const Vector3& p0 = vertices[corners[0]].position;
+		const Vector3& p1 = vertices[corners[1]].position;
+		const Vector3& p2 = vertices[corners[2]].position;
+		const float longestEdge = sqrtf(std::max({ (p1 - p0).SqrMagnitude(), (p2 - p1).SqrMagnitude(), (p0 - p2).SqrMagnitude() }));
+		const float doubleArea = Vector3::Cross(p1 - p0, p2 - p0).Magnitude();
+		if (longestEdge == 0.f || doubleArea <= tolerance * longestEdge)
+		{
+			++statistics.numDegenerateTriangles;
+			continue;
+		}
+
+		uint32_t canonical[3]{};
+		GetCanonicalTriangle(corners, canonical);
+
+		const uint32_t hash = HashTriangle(canonical);
+		bool isDuplicate{};
+		uint32_t slot = hash & tableMask;
+		for (; triangleTable[slot] != UINT64_MAX; slot = (slot + 1) & tableMask)
+		{
+			if (uint32_t(triangleTable[slot] >> 32) != hash)
+				continue;
+
+			uint32_t kept[3]{};
+			GetCanonicalTriangle(&indices[uint32_t(triangleTable[slot]) * 3], kept);
+			if (std::equal(canonical, canonical + 3, kept))
+			{
+				isDuplicate = true;
+				break;
+			}
+		}
+		if (isDuplicate)
+		{
+			++statistics.numDuplicateTriangles;
+			continue;
+		}
+
+		//Kept triangles are compacted in place, they never overtake the one being read
+		triangleTable[slot] = uint64_t(hash) << 32 | numKept;
+		std::copy(corners, corners + 3, indices.begin() + numKept * 3);
+		++numKept;
+	}
+	indices.resize(numKept * 3);
+
+	//Compact the vertices that are still referenced, in their original order
+	std::vector<uint32_t> compactRemap(numVertices, Empty);
+	for (uint32_t index : indices)
+	{
+		compactRemap[index] = 0;
+	}
+	uint32_t numUsed{};
+	for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+	{
+		if (compactRemap[vertex] == Empty)
+			continue;
+
+		compactRemap[vertex] = numUsed;
+		vertices[numUsed++] = vertices[vertex];
+	}
+	for (uint32_t& index : indices)
+	{
+		index = compactRemap[index];
+	}
+	statistics.numMergedVertices = numVertices - numUsed;
+	vertices.resize(numUsed);
+
+	if (statistics.numWeldedPositions > 0 || statistics.numMergedVertices > 0)
+		TangentGenerator::Generate(vertices, indices);
+
+	return statistics;
+}
@@ -0,0 +1,23 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Repairs exported meshes before they get optimized: nearly coincident positions, zero area and duplicate triangles
+	namespace MeshCleanup
+	{
+		struct Statistics
+		{
+			uint32_t numWeldedPositions{};		//Vertices moved onto a position within the tolerance
+			uint32_t numMergedVertices{};		//Vertices that became identical to an earlier one, or lost all their triangles
+			uint32_t numDegenerateTriangles{};	//Thinner than the tolerance, including triangles with two corners on one position
+			uint32_t numDuplicateTriangles{};	//Same vertices in the same winding as an earlier triangle
+		};
+
+		//Positions closer than the tolerance are snapped onto the first of them, found through a spatial hash grid
+		//Vertices that end up with the same position, normal and uv are merged and the tangents are rebuilt for the new connectivity
+		//The tolerance is relative to the bounding box diagonal, the order of the remaining vertices and triangles is kept
+		Statistics Clean(std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, float relativeTolerance = 1e-5f);
+	}
+}
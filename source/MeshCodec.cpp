@@ -0,0 +1,637 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MeshCodec.h"
+#include <bit>
+#include <immintrin.h>
+
+using namespace dae;
+using PixelConversion::InstructionSet;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+//MSVC compiles any intrinsic, GCC and Clang only inside functions marked for the instruction set
+#if defined(_MSC_VER)
+#define TARGET_SSSE3
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+namespace
+{
+	//First byte of every encoded buffer, bumped whenever the format changes
+	constexpr uint8_t IndexCodecHeader{ 0xE2 };
+	constexpr uint8_t VertexCodecHeader{ 0xA2 };
+
+	//Streams are split into blocks of this many values, every block stores one plane per byte of a value
+	constexpr size_t BlockSize{ 256 };
+
+	//A plane is bit packed in groups of 16 bytes, a 2-bit code per group picks 0, 2, 4 or 8 bits per byte
+	//With 2 and 4 bits the largest value means the byte didn't fit, it is stored minus that value after the plane's packed groups
+	constexpr size_t GroupSize{ 16 };
+	constexpr size_t GroupBits[4]{ 0, 2, 4, 8 };
+	constexpr size_t GroupBytes[4]{ 0, 4, 8, 16 };
+	constexpr uint8_t GroupEscape[4]{ 0, 3, 15, 0 };
+	constexpr size_t MaxGroupBytes{ 24 }; //4 bits with every byte escaped
+
+	//Where value i of a group goes with bits per value: both bytes of a 16-bit word hold the same slots
+	//so the decoder can shift every value down with one multiply per 16-bit lane
+	constexpr size_t PackedByte(size_t i, size_t bits)
+	{
+		return i / (16 / bits) * 2 + i % 2;
+	}
+
+	constexpr size_t PackedShift(size_t i, size_t bits)
+	{
+		return i / 2 % (8 / bits) * bits;
+	}
+
+	//How an index block predicts its indices, picked per block by whichever packs smaller
+	enum class IndexPredictor : uint8_t
+	{
+		NextVertex,		//Distance below the next vertex that hasn't been referenced yet, new vertices in first use order cost nothing
+		PreviousIndex	//Zigzagged difference with the previous index, for the levels of detail that only reuse old vertices
+	};
+
+	uint8_t ZigZag(uint8_t delta)
+	{
+		return uint8_t((delta << 1) ^ (int8_t(delta) >> 7));
+	}
+
+	uint32_t ZigZag(uint32_t delta)
+	{
+		return (delta << 1) ^ uint32_t(int32_t(delta) >> 31);
+	}
+
+	uint32_t UnZigZag(uint32_t value)
+	{
+		return (value >> 1) ^ (0 - (value & 1));
+	}
+
+	__m128i UnZigZag(__m128i value)
+	{
+		const __m128i shifted = _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7F));
+		const __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(value, _mm_set1_epi8(1)));
+		return _mm_xor_si128(shifted, sign);
+	}
+
+	//Inclusive prefix sum of the 4 lanes
+	__m128i PrefixSum(__m128i values)
+	{
+		values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+		return _mm_add_epi32(values, _mm_slli_si128(values, 8));
+	}
+
+	//Appends count bytes of pPlane, the plane has to be zero from count up to the end of its last group
+	//The 2-bit codes come first, then the packed groups and then the escaped bytes of all groups
+	void EncodePlane(const uint8_t* pPlane, size_t count, std::vector<uint8_t>& encoded)
+	{
+		const size_t numGroups = (count + GroupSize - 1) / GroupSize;
+		const size_t headerOffset = encoded.size();
+		encoded.resize(encoded.size() + (numGroups + 3) / 4);
+
+		uint8_t escapes[BlockSize];
+		size_t numEscapes{};
+		for (size_t group = 0; group < numGroups; ++group)
+		{
+			const uint8_t* pGroup = pPlane + group * GroupSize;
+
+			//Cheapest code counting the escaped bytes
+			uint8_t code{ 3 };
+			size_t size{ GroupBytes[3] };
+			for (uint8_t candidate = 0; candidate < 3; ++candidate)
+			{
+				//Zero bits has no escape, every byte has to be 0
+				const uint8_t limit = candidate == 0 ? 1 : GroupEscape[candidate];
+				const size_t numEscaped = std::count_if(pGroup, pGroup + GroupSize, [&](uint8_t value) { return value >= limit; });
+				if (candidate == 0 && numEscaped != 0)
+					continue;
+
+				if (GroupBytes[candidate] + numEscaped < size)
+				{
+					code = candidate;
+					size = GroupBytes[candidate] + numEscaped;
+				}
+			}
+			encoded[headerOffset + group / 4] |= uint8_t(code << (group % 4 * 2));
+			if (code == 0)
+				continue;
+
+			const uint8_t escape = GroupEscape[code];
+			uint8_t packed[GroupSize]{};
+			for (size_t i = 0; i < GroupSize; ++i)
+			{
+				const uint8_t value = code == 3 ? pGroup[i] : std::min(pGroup[i], escape);
+				packed[PackedByte(i, GroupBits[code])] |= uint8_t(value << PackedShift(i, GroupBits[code]));
+				if (code != 3 && pGroup[i] >= escape)
+				{
+					escapes[numEscapes++] = uint8_t(pGroup[i] - escape);
+				}
+			}
+			encoded.insert(encoded.end(), packed, packed + GroupBytes[code]);
+		}
+		encoded.insert(encoded.end(), escapes, escapes + numEscapes);
+	}
+
+	//Lookups for the decoder, built at compile time
+	struct DecodeTables
+	{
+		//Per code the pshufb control that copies the byte holding each value into its lane,
+		//the multipliers that move the values to the top of their bytes and the mask that is left after shifting them back down
+		alignas(16) uint8_t spreads[4][GroupSize]{};
+		alignas(16) uint16_t multipliers[4][GroupSize / 2]{};
+		alignas(16) uint8_t masks[4][GroupSize]{};
+		alignas(16) uint8_t escapes[4][GroupSize]{};
+		uint32_t escapeGates[4]{ 0, 0xFFFF, 0xFFFF, 0 };
+
+		//Bytes of packed groups the 4 codes of a header byte add up to
+		uint8_t groupsSize[256]{};
+
+		//pshufb controls that move the escaped bytes into place, one per 8 bits of the escape mask
+		//Every set bit takes the next escaped byte and every clear one gets 0x80, which comes out as 0
+		uint8_t escapeShuffles[256][8]{};
+		uint8_t escapeCounts[256]{};
+
+		constexpr DecodeTables()
+		{
+			for (size_t code = 0; code < 4; ++code)
+			{
+				for (size_t i = 0; i < GroupSize; ++i)
+				{
+					spreads[code][i] = code == 0 ? 0x80 : uint8_t(PackedByte(i, GroupBits[code]));
+					masks[code][i] = uint8_t((1u << GroupBits[code]) - 1);
+					escapes[code][i] = GroupEscape[code];
+				}
+				for (size_t lane = 0; lane < GroupSize / 2 && code != 0; ++lane)
+				{
+					multipliers[code][lane] = uint16_t(1u << (8 - GroupBits[code] - PackedShift(lane * 2, GroupBits[code])));
+				}
+			}
+
+			for (uint32_t byte = 0; byte < 256; ++byte)
+			{
+				groupsSize[byte] = uint8_t(GroupBytes[byte & 3] + GroupBytes[(byte >> 2) & 3] + GroupBytes[(byte >> 4) & 3] + GroupBytes[byte >> 6]);
+
+				uint8_t count{};
+				for (uint32_t bit = 0; bit < 8; ++bit)
+				{
+					escapeShuffles[byte][bit] = byte & (1u << bit) ? count++ : 0x80;
+				}
+				escapeCounts[byte] = count;
+			}
+		}
+	};
+	constexpr DecodeTables Tables{};
+
+	//The kernels load 16 bytes from wherever the groups and escapes they are decoding start
+	constexpr size_t ReadPadding{ 16 };
+
+	//Where the parts of one encoded plane start
+	//Near the end of the data they point into a zero padded copy, so the kernels never have to check what they load
+	struct Plane
+	{
+		const uint8_t* pCodes;
+		const uint8_t* pGroups;
+		const uint8_t* pEscapes;
+		size_t numGroups;
+		size_t size;
+		uint8_t padded[(BlockSize / GroupSize + 3) / 4 + BlockSize / GroupSize * MaxGroupBytes + ReadPadding];
+	};
+
+	//Sums the packed group sizes to find the escapes, before any group is decoded
+	//Returns false if the codes past the last group aren't 0
+	bool OpenPlane(Plane& plane, const uint8_t* pEncoded, const uint8_t* pEnd, size_t count)
+	{
+		plane.numGroups = (count + GroupSize - 1) / GroupSize;
+		const size_t headerSize = (plane.numGroups + 3) / 4;
+		const size_t maxSize = headerSize + plane.numGroups * MaxGroupBytes + ReadPadding;
+		plane.size = size_t(pEnd - pEncoded);
+		plane.pCodes = pEncoded;
+		if (plane.size < maxSize)
+		{
+			memcpy(plane.padded, pEncoded, plane.size);
+			memset(plane.padded + plane.size, 0, maxSize - plane.size);
+			plane.pCodes = plane.padded;
+		}
+
+		const uint8_t lastCodes = plane.pCodes[headerSize - 1];
+		if (plane.numGroups % 4 != 0 && (lastCodes >> (plane.numGroups % 4 * 2)) != 0)
+			return false;
+
+		size_t groupsSize{};
+		for (size_t i = 0; i < headerSize; ++i)
+		{
+			groupsSize += Tables.groupsSize[plane.pCodes[i]];
+		}
+		plane.pGroups = plane.pCodes + headerSize;
+		plane.pEscapes = plane.pGroups + groupsSize;
+		return true;
+	}
+
+	//Advances pEncoded past the plane, pEscapesEnd is the byte after its last escape
+	bool ClosePlane(const Plane& plane, const uint8_t* pEscapesEnd, const uint8_t*& pEncoded)
+	{
+		const size_t decodedSize = size_t(pEscapesEnd - plane.pCodes);
+		if (decodedSize > plane.size)
+			return false;
+
+		pEncoded += decodedSize;
+		return true;
+	}
+
+	//Shifts every value down from where the spread put it, the values of a 16-bit lane share a shift
+	__m128i UnpackGroup(__m128i spread, uint32_t code)
+	{
+		const __m128i shifted = _mm_mullo_epi16(spread, _mm_load_si128(reinterpret_cast<const __m128i*>(Tables.multipliers[code])));
+		const __m128i values = _mm_srl_epi16(shifted, _mm_cvtsi32_si128(int(8 - GroupBits[code])));
+		return _mm_and_si128(values, _mm_load_si128(reinterpret_cast<const __m128i*>(Tables.masks[code])));
+	}
+
+	//Mask of the bytes in values that are escapes, only the 2 and 4-bit codes have any
+	uint32_t FindEscapes(__m128i values, uint32_t code)
+	{
+		const __m128i escape = _mm_load_si128(reinterpret_cast<const __m128i*>(Tables.escapes[code]));
+		return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(values, escape))) & Tables.escapeGates[code];
+	}
+
+	//Unpacks one group and patches in its escaped bytes, returns the escapes of the next group
+	//Every code is spread with unpacks and the right one picked with masks, which is cheaper than mispredicting a switch on the code
+	const uint8_t* DecodeGroup(const uint8_t* pGroup, const uint8_t* pEscapes, uint32_t code, uint8_t* pOutput)
+	{
+		const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pGroup));
+		const __m128i words = _mm_unpacklo_epi16(bits, bits);
+		const __m128i codes = _mm_set1_epi8(char(code));
+		const __m128i spread = _mm_or_si128(_mm_or_si128(
+			_mm_and_si128(_mm_unpacklo_epi32(words, words), _mm_cmpeq_epi8(codes, _mm_set1_epi8(1))),
+			_mm_and_si128(words, _mm_cmpeq_epi8(codes, _mm_set1_epi8(2)))),
+			_mm_and_si128(bits, _mm_cmpeq_epi8(codes, _mm_set1_epi8(3))));
+		const __m128i values = UnpackGroup(spread, code);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput), values);
+
+		//Without pshufb the escapes are patched in one at a time
+		for (uint32_t escaped = FindEscapes(values, code); escaped != 0; escaped &= escaped - 1)
+		{
+			pOutput[std::countr_zero(escaped)] += *pEscapes++;
+		}
+		return pEscapes;
+	}
+
+	TARGET_SSSE3 const uint8_t* DecodeGroupSSSE3(const uint8_t* pGroup, const uint8_t* pEscapes, uint32_t code, uint8_t* pOutput)
+	{
+		const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pGroup));
+		const __m128i values = UnpackGroup(_mm_shuffle_epi8(bits, _mm_load_si128(reinterpret_cast<const __m128i*>(Tables.spreads[code]))), code);
+
+		//One shuffle drops all escaped bytes into place, the high half continues where the low half stopped
+		const uint32_t escaped = FindEscapes(values, code);
+		const uint32_t lowCount = Tables.escapeCounts[escaped & 0xFF];
+		const __m128i shuffle = _mm_unpacklo_epi64(
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Tables.escapeShuffles[escaped & 0xFF])),
+			_mm_add_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(Tables.escapeShuffles[escaped >> 8])), _mm_set1_epi8(char(lowCount))));
+		const __m128i patch = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pEscapes)), shuffle);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput), _mm_add_epi8(values, patch));
+		return pEscapes + lowCount + Tables.escapeCounts[escaped >> 8];
+	}
+
+	//Decodes a plane of count bytes into pPlane and advances pEncoded, writes whole groups so pPlane needs room for BlockSize bytes
+	//The groups only depend on the codes for where they start, so consecutive groups decode in parallel
+	//Groups past the last one have code 0, so every byte of codes is decoded as a whole
+	bool DecodePlane(const uint8_t*& pEncoded, const uint8_t* pEnd, size_t count, uint8_t* pPlane)
+	{
+		Plane plane;
+		if (!OpenPlane(plane, pEncoded, pEnd, count))
+			return false;
+
+		const uint8_t* pGroups = plane.pGroups;
+		const uint8_t* pEscapes = plane.pEscapes;
+		for (size_t group = 0; group < plane.numGroups; group += 4)
+		{
+			uint32_t codes = plane.pCodes[group / 4];
+			for (size_t i = 0; i < 4; ++i, codes >>= 2)
+			{
+				pEscapes = DecodeGroup(pGroups, pEscapes, codes & 3, pPlane + (group + i) * GroupSize);
+				pGroups += GroupBytes[codes & 3];
+			}
+		}
+		return ClosePlane(plane, pEscapes, pEncoded);
+	}
+
+	TARGET_SSSE3 bool DecodePlaneSSSE3(const uint8_t*& pEncoded, const uint8_t* pEnd, size_t count, uint8_t* pPlane)
+	{
+		Plane plane;
+		if (!OpenPlane(plane, pEncoded, pEnd, count))
+			return false;
+
+		const uint8_t* pGroups = plane.pGroups;
+		const uint8_t* pEscapes = plane.pEscapes;
+		for (size_t group = 0; group < plane.numGroups; group += 4)
+		{
+			uint32_t codes = plane.pCodes[group / 4];
+			for (size_t i = 0; i < 4; ++i, codes >>= 2)
+			{
+				pEscapes = DecodeGroupSSSE3(pGroups, pEscapes, codes & 3, pPlane + (group + i) * GroupSize);
+				pGroups += GroupBytes[codes & 3];
+			}
+		}
+		return ClosePlane(plane, pEscapes, pEncoded);
+	}
+
+	bool DecodePlane(const uint8_t*& pEncoded, const uint8_t* pEnd, size_t count, uint8_t* pPlane, InstructionSet instructionSet)
+	{
+		return instructionSet == InstructionSet::Scalar
+			? DecodePlane(pEncoded, pEnd, count, pPlane)
+			: DecodePlaneSSSE3(pEncoded, pEnd, count, pPlane);
+	}
+
+	//Two of the 4 rounds of a 16x16 byte transpose, each round rotates the bits of the row and column address by one
+	//Over two rounds rows i, i + 4, i + 8 and i + 12 only mix with each other and end up in rows 4i to 4i + 3
+	void Interleave(__m128i row0, __m128i row4, __m128i row8, __m128i row12, __m128i* pOutput)
+	{
+		const __m128i low0 = _mm_unpacklo_epi8(row0, row8);
+		const __m128i high0 = _mm_unpackhi_epi8(row0, row8);
+		const __m128i low1 = _mm_unpacklo_epi8(row4, row12);
+		const __m128i high1 = _mm_unpackhi_epi8(row4, row12);
+		pOutput[0] = _mm_unpacklo_epi8(low0, low1);
+		pOutput[1] = _mm_unpackhi_epi8(low0, low1);
+		pOutput[2] = _mm_unpacklo_epi8(high0, high1);
+		pOutput[3] = _mm_unpackhi_epi8(high0, high1);
+	}
+
+	//Stores all 16 bytes, only the last vertices of the buffer can't spill past their chunk
+	void StoreChunk(uint8_t* pOutput, const uint8_t* pEnd, __m128i values, size_t chunkSize)
+	{
+		if (pOutput + GroupSize <= pEnd)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput), values);
+		}
+		else
+		{
+			alignas(16) uint8_t bytes[GroupSize];
+			_mm_store_si128(reinterpret_cast<__m128i*>(bytes), values);
+			memcpy(pOutput, bytes, chunkSize);
+		}
+	}
+
+	//Where the vertices of one block of planes go
+	struct VertexBlock
+	{
+		const uint8_t* pPlanes;
+		size_t count;
+		size_t vertexSize;
+		uint8_t* pOutput;
+		const uint8_t* pEnd;
+	};
+
+	//Transposes the 16 planes of a chunk back into vertices, returns the last vertex
+	//Every row is a vertex after the transpose, so the prefix sum is one add per vertex
+	__m128i DecodeChunk(const VertexBlock& block, size_t chunkStart, __m128i previous)
+	{
+		const size_t chunkSize = std::min(GroupSize, block.vertexSize - chunkStart);
+		for (size_t groupStart = 0; groupStart < block.count; groupStart += GroupSize)
+		{
+			const __m128i* pRows = reinterpret_cast<const __m128i*>(block.pPlanes + chunkStart * BlockSize + groupStart);
+			const size_t stride = BlockSize / sizeof(__m128i);
+			__m128i rows[GroupSize];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				Interleave(pRows[i * stride], pRows[(i + 4) * stride], pRows[(i + 8) * stride], pRows[(i + 12) * stride], rows + i * 4);
+			}
+
+			const size_t groupCount = std::min(GroupSize, block.count - groupStart);
+			uint8_t* pOutput = block.pOutput + groupStart * block.vertexSize + chunkStart;
+			for (size_t i = 0; i < 4; ++i)
+			{
+				__m128i vertices[4];
+				Interleave(rows[i], rows[i + 4], rows[i + 8], rows[i + 12], vertices);
+				for (size_t j = 0; j < 4 && i * 4 + j < groupCount; ++j)
+				{
+					previous = _mm_add_epi8(previous, UnZigZag(vertices[j]));
+					StoreChunk(pOutput + (i * 4 + j) * block.vertexSize, block.pEnd, previous, chunkSize);
+				}
+			}
+		}
+		return previous;
+	}
+
+	//The chunks go from last to first, so what a partial chunk spills into the next vertex is written over by that vertex's whole chunks
+	//Without whole chunks every vertex is written after the one that spilled into it
+	void DecodeVertices(const VertexBlock& block, __m128i* pLastVertex)
+	{
+		const size_t numChunks = (block.vertexSize + GroupSize - 1) / GroupSize;
+		for (size_t chunk = numChunks; chunk-- > 0;)
+		{
+			pLastVertex[chunk] = DecodeChunk(block, chunk * GroupSize, pLastVertex[chunk]);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+void MeshCodec::EncodeIndexBuffer(const uint32_t* pIndices, size_t numIndices, std::vector<uint8_t>& encoded)
+{
+	encoded.clear();
+	encoded.reserve(numIndices * 2 + 1);
+	encoded.push_back(IndexCodecHeader);
+
+	uint8_t planes[4][BlockSize]{};
+	std::vector<uint8_t> candidates[2]{};
+	uint32_t nextVertex{};
+	uint32_t previousIndex{};
+	for (size_t blockStart = 0; blockStart < numIndices; blockStart += BlockSize)
+	{
+		const size_t count = std::min(BlockSize, numIndices - blockStart);
+		for (const IndexPredictor predictor : { IndexPredictor::NextVertex, IndexPredictor::PreviousIndex })
+		{
+			uint32_t next = nextVertex;
+			uint32_t previous = previousIndex;
+			for (size_t i = 0; i < BlockSize; ++i)
+			{
+				//Codes past count are padding and have to come out as 0
+				uint32_t code{};
+				if (i < count)
+				{
+					//Wraps around when an index is past the next vertex, which only happens when the buffer isn't in first use order
+					const uint32_t index = pIndices[blockStart + i];
+					code = predictor == IndexPredictor::NextVertex ? next - index : ZigZag(index - previous);
+					next = index >= next ? index + 1 : next;
+					previous = index;
+				}
+
+				for (size_t byte = 0; byte < 4; ++byte)
+				{
+					planes[byte][i] = uint8_t(code >> (byte * 8));
+				}
+			}
+
+			std::vector<uint8_t>& candidate = candidates[size_t(predictor)];
+			candidate.assign(1, uint8_t(predictor));
+			for (size_t byte = 0; byte < 4; ++byte)
+			{
+				EncodePlane(planes[byte], count, candidate);
+			}
+		}
+
+		const std::vector<uint8_t>& best = candidates[0].size() <= candidates[1].size() ? candidates[0] : candidates[1];
+		encoded.insert(encoded.end(), best.begin(), best.end());
+
+		for (size_t i = blockStart; i < blockStart + count; ++i)
+		{
+			nextVertex = pIndices[i] >= nextVertex ? pIndices[i] + 1 : nextVertex;
+		}
+		previousIndex = pIndices[blockStart + count - 1];
+	}
+}
+
+bool MeshCodec::DecodeIndexBuffer(uint32_t* pIndices, size_t numIndices, const uint8_t* pEncoded, size_t encodedSize, InstructionSet instructionSet)
+{
+	const uint8_t* pEnd = pEncoded + encodedSize;
+	if (encodedSize == 0 || *pEncoded++ != IndexCodecHeader)
+		return false;
+
+	alignas(16) uint8_t planes[4][BlockSize];
+	uint32_t nextVertex{};
+	uint32_t previousIndex{};
+	for (size_t blockStart = 0; blockStart < numIndices; blockStart += BlockSize)
+	{
+		if (pEncoded == pEnd || *pEncoded > uint8_t(IndexPredictor::PreviousIndex))
+			return false;
+
+		const IndexPredictor predictor = IndexPredictor(*pEncoded++);
+		const size_t count = std::min(BlockSize, numIndices - blockStart);
+		for (size_t byte = 0; byte < 4; ++byte)
+		{
+			if (!DecodePlane(pEncoded, pEnd, count, planes[byte], instructionSet))
+				return false;
+		}
+
+		for (size_t groupStart = 0; groupStart < count; groupStart += GroupSize)
+		{
+			//Put the 4 planes back together into 32-bit codes
+			const __m128i byte0 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[0] + groupStart));
+			const __m128i byte1 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[1] + groupStart));
+			const __m128i byte2 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[2] + groupStart));
+			const __m128i byte3 = _mm_load_si128(reinterpret_cast<const __m128i*>(planes[3] + groupStart));
+			const __m128i low[2]{ _mm_unpacklo_epi8(byte0, byte1), _mm_unpackhi_epi8(byte0, byte1) };
+			const __m128i high[2]{ _mm_unpacklo_epi8(byte2, byte3), _mm_unpackhi_epi8(byte2, byte3) };
+			const __m128i codes[4]
+			{
+				_mm_unpacklo_epi16(low[0], high[0]), _mm_unpackhi_epi16(low[0], high[0]),
+				_mm_unpacklo_epi16(low[1], high[1]), _mm_unpackhi_epi16(low[1], high[1])
+			};
+
+			const size_t groupCount = std::min(GroupSize, count - groupStart);
+			uint32_t* pOutput = pIndices + blockStart + groupStart;
+			__m128i* pOutputs = reinterpret_cast<__m128i*>(pOutput);
+			if (groupCount < GroupSize)
+			{
+				//The last group of the buffer goes one index at a time
+				alignas(16) uint32_t values[GroupSize];
+				std::copy(codes, codes + 4, reinterpret_cast<__m128i*>(values));
+				for (size_t i = 0; i < groupCount; ++i)
+				{
+					const uint32_t index = predictor == IndexPredictor::NextVertex ? nextVertex - values[i] : previousIndex + UnZigZag(values[i]);
+					nextVertex = index >= nextVertex ? index + 1 : nextVertex;
+					previousIndex = index;
+					pOutput[i] = index;
+				}
+			}
+			else if (predictor == IndexPredictor::NextVertex)
+			{
+				//An index only moves the next vertex when it isn't below it, which is when its code is 0 or negative
+				//What every index moves it by then only depends on its own code, and the next vertex before each index is a prefix sum
+				const __m128i one = _mm_set1_epi32(1);
+				__m128i next = _mm_set1_epi32(int(nextVertex));
+				for (const __m128i& code : codes)
+				{
+					const __m128i advance = _mm_and_si128(_mm_cmpgt_epi32(one, code), _mm_sub_epi32(one, code));
+					const __m128i advanced = PrefixSum(advance);
+					_mm_storeu_si128(pOutputs++, _mm_sub_epi32(_mm_add_epi32(next, _mm_sub_epi32(advanced, advance)), code));
+					next = _mm_add_epi32(next, _mm_shuffle_epi32(advanced, _MM_SHUFFLE(3, 3, 3, 3)));
+				}
+				nextVertex = uint32_t(_mm_cvtsi128_si32(next));
+			}
+			else
+			{
+				__m128i previous = _mm_set1_epi32(int(previousIndex));
+				for (const __m128i& code : codes)
+				{
+					const __m128i delta = _mm_xor_si128(_mm_srli_epi32(code, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(code, _mm_set1_epi32(1))));
+					const __m128i indices = _mm_add_epi32(previous, PrefixSum(delta));
+					_mm_storeu_si128(pOutputs++, indices);
+					previous = _mm_shuffle_epi32(indices, _MM_SHUFFLE(3, 3, 3, 3));
+				}
+				previousIndex = uint32_t(_mm_cvtsi128_si32(previous));
+
+				for (size_t i = 0; i < GroupSize; ++i)
+				{
+					nextVertex = pOutput[i] >= nextVertex ? pOutput[i] + 1 : nextVertex;
+				}
+			}
+		}
+		previousIndex = pIndices[blockStart + count - 1];
+	}
+
+	return pEncoded == pEnd;
+}
+
+void MeshCodec::EncodeVertexBuffer(const void* pVertices, size_t numVertices, size_t vertexSize, std::vector<uint8_t>& encoded)
+{
+	encoded.clear();
+	encoded.reserve(numVertices * vertexSize + 1);
+	encoded.push_back(VertexCodecHeader);
+
+	const uint8_t* pBytes = static_cast<const uint8_t*>(pVertices);
+	std::vector<uint8_t> lastVertex(vertexSize);
+	uint8_t plane[BlockSize]{};
+	for (size_t blockStart = 0; blockStart < numVertices; blockStart += BlockSize)
+	{
+		const size_t count = std::min(BlockSize, numVertices - blockStart);
+		for (size_t byte = 0; byte < vertexSize; ++byte)
+		{
+			uint8_t previous = lastVertex[byte];
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint8_t value = pBytes[(blockStart + i) * vertexSize + byte];
+				plane[i] = ZigZag(uint8_t(value - previous));
+				previous = value;
+			}
+			std::fill(plane + count, plane + BlockSize, uint8_t{});
+			lastVertex[byte] = previous;
+
+			EncodePlane(plane, count, encoded);
+		}
+	}
+}
+
+bool MeshCodec::DecodeVertexBuffer(void* pVertices, size_t numVertices, size_t vertexSize, const uint8_t* pEncoded, size_t encodedSize, InstructionSet instructionSet)
+{
+	const uint8_t* pEnd = pEncoded + encodedSize;
+	if (encodedSize == 0 || *pEncoded++ != VertexCodecHeader)
+		return false;
+
+	//The planes of a block are decoded first and then transposed back into vertices 16 bytes at a time
+	//The padding planes past vertexSize only feed the transpose and are never written out
+	const size_t numChunks = (vertexSize + GroupSize - 1) / GroupSize;
+	std::vector<__m128i> planes(numChunks * GroupSize * BlockSize / sizeof(__m128i));
+	std::vector<__m128i> lastVertex(numChunks, _mm_setzero_si128());
+	uint8_t* pPlanes = reinterpret_cast<uint8_t*>(planes.data());
+	uint8_t* pBytes = static_cast<uint8_t*>(pVertices);
+
+	for (size_t blockStart = 0; blockStart < numVertices; blockStart += BlockSize)
+	{
+		const size_t count = std::min(BlockSize, numVertices - blockStart);
+		for (size_t byte = 0; byte < vertexSize; ++byte)
+		{
+			if (!DecodePlane(pEncoded, pEnd, count, pPlanes + byte * BlockSize, instructionSet))
+				return false;
+		}
+
+		DecodeVertices({ pPlanes, count, vertexSize, pBytes + blockStart * vertexSize, pBytes + numVertices * vertexSize }, lastVertex.data());
+	}
+
+	return pEncoded == pEnd;
+}
@@ -0,0 +1,30 @@
+#pragma once
+// Includes
+#include "PixelConversion.h"
+
+namespace dae
+{
+	//Lossless compression of index and vertex buffers for the mesh cache
+	//Both streams are turned into small numbers first (zigzagged deltas), split into byte planes and bit packed in groups of 16 bytes
+	namespace MeshCodec
+	{
+		//Index codes are relative to the next vertex that hasn't been referenced yet, so a buffer in first use order
+		//(MeshOptimizer::OptimizeVertexFetch) turns every new vertex into a 0 and every reuse into a small distance
+		void EncodeIndexBuffer(const uint32_t* pIndices, size_t numIndices, std::vector<uint8_t>& encoded);
+
+		//Decodes into pIndices, which must have room for numIndices
+		//Returns false if the data is truncated or wasn't made by EncodeIndexBuffer for this many indices
+		//Every instruction set decodes the same values, SSSE3 patches the escaped bytes in with pshufb and Scalar is the SSE2 baseline
+		bool DecodeIndexBuffer(uint32_t* pIndices, size_t numIndices, const uint8_t* pEncoded, size_t encodedSize,
+			PixelConversion::InstructionSet instructionSet = PixelConversion::GetInstructionSet());
+
+		//Every byte of a vertex is stored as the difference with the same byte of the previous vertex
+		//Works on any vertex layout, best when neighbouring vertices are close in the buffer
+		void EncodeVertexBuffer(const void* pVertices, size_t numVertices, size_t vertexSize, std::vector<uint8_t>& encoded);
+
+		//Decodes into pVertices, which must have room for numVertices * vertexSize bytes
+		//Returns false if the data is truncated or wasn't made by EncodeVertexBuffer for this many vertices of this size
+		bool DecodeVertexBuffer(void* pVertices, size_t numVertices, size_t vertexSize, const uint8_t* pEncoded, size_t encodedSize,
+			PixelConversion::InstructionSet instructionSet = PixelConversion::GetInstructionSet());
+	}
+}
@@ -0,0 +1,517 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include <unordered_map>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Forsyth's tuning, the simulated LRU cache is bigger than any real one to stay useful on most hardware
+	constexpr uint32_t ForsythCacheSize{ 32 };
+	constexpr uint32_t ForsythMaxValence{ 64 };
+
+	struct ForsythScoreTable
+	{
+		float cache[ForsythCacheSize]{};
+		float valence[ForsythMaxValence]{};
+
+		ForsythScoreTable()
+		{
+			//The last triangle's vertices get a fixed score so its neighbours aren't preferred over a fresh strip
+			for (uint32_t i = 0; i < ForsythCacheSize; ++i)
+			{
+				cache[i] = i < 3 ? 0.75f : powf(1.f - (i - 3) / float(ForsythCacheSize - 3), 1.5f);
+			}
+
+			//Vertices with few triangles left get a boost so we don't leave lone triangles behind
+			for (uint32_t i = 1; i < ForsythMaxValence; ++i)
+			{
+				valence[i] = 2.f / sqrtf(float(i));
+			}
+		}
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const Vector3& position) const
+		{
+			uint32_t bits[3]{};
+			memcpy(bits, &position, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const Vector3& a, const Vector3& b) const
+		{
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+	};
+
+	constexpr uint32_t OverdrawCacheSize{ 16 };
+
+	//Small direct mapped cache in front of the vertex fetch, roughly what a GPU has per unit
+	constexpr uint32_t FetchCacheLineSize{ 64 };
+	constexpr uint32_t FetchCacheNumLines{ 64 };
+	constexpr uint32_t FetchTransformCacheSize{ 16 };
+
+	float GetVertexScore(const ForsythScoreTable& table, int cachePosition, uint32_t remainingValence)
+	{
+		if (remainingValence == 0)
+			return -1.f;
+
+		const float cacheScore = cachePosition >= 0 ? table.cache[cachePosition] : 0.f;
+		return cacheScore + table.valence[std::min(remainingValence, ForsythMaxValence - 1)];
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+MeshOptimizer::VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices, uint32_t cacheSize)
+{
+	VertexCacheStatistics statistics{};
+	if (indices.empty() || numVertices == 0)
+		return statistics;
+
+	//A vertex is in the FIFO as long as fewer than cacheSize misses happened since it was inserted
+	std::vector<uint32_t> insertTime(numVertices, 0);
+	uint32_t time{ cacheSize + 1 };
+
+	for (uint32_t index : indices)
+	{
+		if (time - insertTime[index] > cacheSize)
+		{
+			insertTime[index] = time++;
+			++statistics.numTransformed;
+		}
+	}
+
+	statistics.acmr = statistics.numTransformed / float(indices.size() / 3);
+	statistics.atvr = statistics.numTransformed / float(numVertices);
+	return statistics;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices)
+{
+	const size_t numTriangles = indices.size() / 3;
+	if (numTriangles == 0)
+		return;
+
+	static const ForsythScoreTable scoreTable{};
+
+	//Triangle adjacency per vertex, emitted triangles get swapped out of the vertex's range
+	std::vector<uint32_t> remainingValence(numVertices, 0);
+	for (uint32_t index : indices)
+	{
+		++remainingValence[index];
+	}
+
+	std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		adjacencyOffsets[i + 1] = adjacencyOffsets[i] + remainingValence[i];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	//Initial scores
+	std::vector<int> cachePositions(numVertices, -1);
+	std::vector<float> vertexScores(numVertices);
+	for (size_t i = 0; i < numVertices; ++i)
+	{
+		vertexScores[i] = GetVertexScore(scoreTable, -1, remainingValence[i]);
+	}
+
+	std::vector<bool> isEmitted(numTriangles, false);
+
+	std::vector<uint32_t> result{};
+	result.reserve(indices.size());
+
+	uint32_t cache[ForsythCacheSize + 3]{};
+	uint32_t cacheCount{};
+	size_t nextUnemitted{};
+	int64_t bestTriangle{ -1 };
+
+	for (size_t emitted = 0; emitted < numTriangles; ++emitted)
+	{
+		//Nothing in the cache has triangles left, continue with the next triangle in the input order
+		if (bestTriangle < 0)
+		{
+			while (isEmitted[nextUnemitted])
+				++nextUnemitted;
+			bestTriangle = static_cast<int64_t>(nextUnemitted);
+		}
+
+		const uint32_t* pTriangle = &indices[bestTriangle * 3];
+		result.insert(result.end(), pTriangle, pTriangle + 3);
+		isEmitted[bestTriangle] = true;
+
+		//Remove the triangle from its vertices' adjacency
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			const uint32_t vertex = pTriangle[i];
+			uint32_t* pBegin = &adjacency[adjacencyOffsets[vertex]];
+			uint32_t* pEnd = pBegin + remainingValence[vertex];
+			uint32_t* pFound = std::find(pBegin, pEnd, static_cast<uint32_t>(bestTriangle));
+			std::swap(*pFound, *(pEnd - 1));
+			--remainingValence[vertex];
+		}
+
+		//Move the triangle's vertices to the front of the LRU cache
+		uint32_t newCache[ForsythCacheSize + 3]{ pTriangle[0], pTriangle[1], pTriangle[2] };
+		uint32_t newCacheCount{ 3 };
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			const uint32_t vertex = cache[i];
+			if (vertex != pTriangle[0] && vertex != pTriangle[1] && vertex != pTriangle[2])
+				newCache[newCacheCount++] = vertex;
+		}
+
+		for (uint32_t i = ForsythCacheSize; i < newCacheCount; ++i)
+		{
+			cachePositions[newCache[i]] = -1;
+			vertexScores[newCache[i]] = GetVertexScore(scoreTable, -1, remainingValence[newCache[i]]);
+		}
+
+		cacheCount = std::min(newCacheCount, ForsythCacheSize);
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			cache[i] = newCache[i];
+			cachePositions[cache[i]] = static_cast<int>(i);
+			vertexScores[cache[i]] = GetVertexScore(scoreTable, static_cast<int>(i), remainingValence[cache[i]]);
+		}
+
+		//Only triangles touching the cache changed score, the best one of those is next
+		bestTriangle = -1;
+		float bestScore{ -FLT_MAX };
+		for (uint32_t i = 0; i < cacheCount; ++i)
+		{
+			const uint32_t vertex = cache[i];
+			for (uint32_t j = 0; j < remainingValence[vertex]; ++j)
+			{
+				const uint32_t triangle = adjacency[adjacencyOffsets[vertex] + j];
+				const float score = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = triangle;
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+MeshOptimizer::OverdrawStatistics MeshOptimizer::AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, uint32_t numViews, uint32_t resolution)
+{
+	OverdrawStatistics statistics{};
+	if (indices.empty() || vertices.empty())
+		return statistics;
+
+	//Fit every view around the bounding sphere of the mesh
+	Vector3 boundsMin = vertices[0].position, boundsMax = vertices[0].position;
+	for (const Vertex_PosTex& vertex : vertices)
+	{
+		boundsMin = Vector3{ std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z) };
+		boundsMax = Vector3{ std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z) };
+	}
+	const Vector3 center = (boundsMin + boundsMax) * 0.5f;
+	const float radius = std::max((boundsMax - center).Magnitude(), FLT_EPSILON);
+	const float toPixels = resolution * 0.5f / radius;
+
+	std::vector<float> depthBuffer(size_t(resolution) * resolution);
+	std::vector<Vector3> projected(vertices.size());
+
+	for (uint32_t view = 0; view < numViews; ++view)
+	{
+		//Directions spread evenly over the sphere (Fibonacci lattice)
+		const float y = 1.f - 2.f * (view + 0.5f) / numViews;
+		const float ringRadius = sqrtf(std::max(1.f - y * y, 0.f));
+		const float angle = view * 2.39996323f;
+		const Vector3 forward{ cosf(angle) * ringRadius, y, sinf(angle) * ringRadius };
+		const Vector3 right = Vector3::Cross(fabsf(forward.y) < 0.99f ? Vector3::UnitY : Vector3::UnitX, forward).Normalized();
+		const Vector3 up = Vector3::Cross(forward, right);
+
+		//Screen space x right, y down and depth along the view direction
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			const Vector3 offset = vertices[i].position - center;
+			projected[i] = Vector3{ (Vector3::Dot(offset, right) + radius) * toPixels, (radius - Vector3::Dot(offset, up)) * toPixels, Vector3::Dot(offset, forward) };
+		}
+
+		std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const Vector3& v0 = projected[indices[i]];
+			const Vector3& v1 = projected[indices[i + 1]];
+			const Vector3& v2 = projected[indices[i + 2]];
+
+			//Clockwise triangles have a positive area with y pointing down
+			const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+			if (area <= 0.f)
+				continue;
+
+			const int minX = std::max(static_cast<int>(std::min({ v0.x, v1.x, v2.x })), 0);
+			const int maxX = std::min(static_cast<int>(std::max({ v0.x, v1.x, v2.x })), static_cast<int>(resolution) - 1);
+			const int minY = std::max(static_cast<int>(std::min({ v0.y, v1.y, v2.y })), 0);
+			const int maxY = std::min(static_cast<int>(std::max({ v0.y, v1.y, v2.y })), static_cast<int>(resolution) - 1);
+
+			const float invArea = 1.f / area;
+			for (int py = minY; py <= maxY; ++py)
+			{
+				for (int px = minX; px <= maxX; ++px)
+				{
+					//Sample at the pixel center
+					const float x = px + 0.5f, yPixel = py + 0.5f;
+					const float w0 = (v2.x - v1.x) * (yPixel - v1.y) - (v2.y - v1.y) * (x - v1.x);
+					const float w1 = (v0.x - v2.x) * (yPixel - v2.y) - (v0.y - v2.y) * (x - v2.x);
+					const float w2 = (v1.x - v0.x) * (yPixel - v0.y) - (v1.y - v0.y) * (x - v0.x);
+					if (w0 < 0.f || w1 < 0.f || w2 < 0.f)
+						continue;
+
+					const float depth = (w0 * v0.z + w1 * v1.z + w2 * v2.z) * invArea;
+					float& storedDepth = depthBuffer[size_t(py) * resolution + px];
+					if (depth < storedDepth)
+					{
+						storedDepth = depth;
+						++statistics.pixelsShaded;
+					}
+				}
+			}
+		}
+
+		for (float depth : depthBuffer)
+		{
+			if (depth != FLT_MAX)
+				++statistics.pixelsCovered;
+		}
+	}
+
+	statistics.overdraw = statistics.pixelsCovered ? statistics.pixelsShaded / float(statistics.pixelsCovered) : 0.f;
+	return statistics;
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, float threshold)
+{
+	const size_t numTriangles = indices.size() / 3;
+	if (numTriangles == 0)
+		return;
+
+	//Hard boundaries: triangles where the cache simulation misses all three vertices, splitting there costs nothing
+	std::vector<size_t> hardBoundaries{};
+	{
+		std::vector<uint32_t> insertTime(vertices.size(), 0);
+		uint32_t time{ OverdrawCacheSize + 1 };
+		for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+		{
+			uint32_t misses{};
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				const uint32_t index = indices[triangle * 3 + i];
+				if (time - insertTime[index] > OverdrawCacheSize)
+				{
+					insertTime[index] = time++;
+					++misses;
+				}
+			}
+
+			if (misses == 3)
+				hardBoundaries.push_back(triangle);
+		}
+		hardBoundaries.push_back(numTriangles);
+	}
+
+	//Soft boundaries: split a run again whenever the part so far is close enough to the ACMR of the whole run
+	std::vector<size_t> clusters{};
+	std::vector<uint32_t> insertTime(vertices.size(), 0);
+	uint32_t time{ OverdrawCacheSize + 1 };
+	for (size_t run = 0; run + 1 < hardBoundaries.size(); ++run)
+	{
+		const size_t runBegin = hardBoundaries[run];
+		const size_t runEnd = hardBoundaries[run + 1];
+
+		//The ACMR of the whole run from a cold cache, on the same timestamps as the clusters
+		uint32_t runMisses{};
+		time += OverdrawCacheSize + 1;
+		for (size_t index = runBegin * 3; index < runEnd * 3; ++index)
+		{
+			if (time - insertTime[indices[index]] > OverdrawCacheSize)
+			{
+				insertTime[indices[index]] = time++;
+				++runMisses;
+			}
+		}
+		const float runAcmr = runMisses / float(runEnd - runBegin);
+
+		size_t clusterBegin = runBegin;
+		uint32_t clusterMisses{};
+		time += OverdrawCacheSize + 1;
+		clusters.push_back(clusterBegin);
+		for (size_t triangle = runBegin; triangle < runEnd; ++triangle)
+		{
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				const uint32_t index = indices[triangle * 3 + i];
+				if (time - insertTime[index] > OverdrawCacheSize)
+				{
+					insertTime[index] = time++;
+					++clusterMisses;
+				}
+			}
+
+			const float clusterAcmr = clusterMisses / float(triangle + 1 - clusterBegin);
+			if (triangle + 1 < runEnd && clusterAcmr <= runAcmr * threshold)
+			{
+				//Start the next cluster with a cold cache, like it will be after sorting
+				clusterBegin = triangle + 1;
+				clusterMisses = 0;
+				time += OverdrawCacheSize + 1;
+				clusters.push_back(clusterBegin);
+			}
+		}
+	}
+	clusters.push_back(numTriangles);
+
+	//Sort key: how far the cluster faces away from the mesh center
+	Vector3 meshCenter{};
+	float meshArea{};
+	std::vector<float> sortKeys(clusters.size() - 1);
+	std::vector<Vector3> clusterCenters(clusters.size() - 1);
+	std::vector<Vector3> clusterNormals(clusters.size() - 1);
+	for (size_t cluster = 0; cluster + 1 < clusters.size(); ++cluster)
+	{
+		Vector3 center{}, normal{};
+		float area{};
+		for (size_t triangle = clusters[cluster]; triangle < clusters[cluster + 1]; ++triangle)
+		{
+			const Vector3& p0 = vertices[indices[triangle * 3]].position;
+			const Vector3& p1 = vertices[indices[triangle * 3 + 1]].position;
+			const Vector3& p2 = vertices[indices[triangle * 3 + 2]].position;
+
+			//Area weighted, the cross product is twice the area along the face normal
+			const Vector3 cross = Vector3::Cross(p1 - p0, p2 - p0);
+			const float triangleArea = cross.Magnitude();
+
+			center += (p0 + p1 + p2) * (triangleArea / 3.f);
+			normal += cross;
+			area += triangleArea;
+		}
+
+		meshCenter += center;
+		meshArea += area;
+		clusterCenters[cluster] = area > 0.f ? center / area : vertices[indices[clusters[cluster] * 3]].position;
+		clusterNormals[cluster] = normal.Normalized();
+	}
+	if (meshArea > 0.f)
+		meshCenter /= meshArea;
+
+	//With clockwise front faces in a left-handed space the cross product points out of the front side
+	for (size_t cluster = 0; cluster < sortKeys.size(); ++cluster)
+	{
+		sortKeys[cluster] = Vector3::Dot(clusterCenters[cluster] - meshCenter, clusterNormals[cluster]);
+	}
+
+	std::vector<uint32_t> order(sortKeys.size());
+	for (uint32_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> result{};
+	result.reserve(indices.size());
+	for (uint32_t cluster : order)
+	{
+		result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+	}
+	indices.swap(result);
+}
+
+MeshOptimizer::VertexFetchStatistics MeshOptimizer::AnalyzeVertexFetch(const std::vector<uint32_t>& indices, size_t numVertices, size_t vertexSize)
+{
+	VertexFetchStatistics statistics{};
+	if (indices.empty() || numVertices == 0 || vertexSize == 0)
+		return statistics;
+
+	std::vector<uint32_t> insertTime(numVertices, 0);
+	uint32_t time{ FetchTransformCacheSize + 1 };
+
+	uint64_t cacheTags[FetchCacheNumLines];
+	std::fill(std::begin(cacheTags), std::end(cacheTags), UINT64_MAX);
+
+	for (uint32_t index : indices)
+	{
+		//Vertices still in the post-transform cache aren't fetched again
+		if (time - insertTime[index] <= FetchTransformCacheSize)
+			continue;
+		insertTime[index] = time++;
+
+		const uint64_t firstLine = index * uint64_t(vertexSize) / FetchCacheLineSize;
+		const uint64_t lastLine = ((index + 1) * uint64_t(vertexSize) - 1) / FetchCacheLineSize;
+		for (uint64_t line = firstLine; line <= lastLine; ++line)
+		{
+			uint64_t& tag = cacheTags[line % FetchCacheNumLines];
+			if (tag != line)
+			{
+				tag = line;
+				++statistics.linesFetched;
+			}
+		}
+	}
+
+	statistics.bytesFetched = uint64_t(statistics.linesFetched) * FetchCacheLineSize;
+	statistics.overfetch = statistics.bytesFetched / float(numVertices * vertexSize);
+	return statistics;
+}
+
+void MeshOptimizer::GeneratePositionRemap(const std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& remap)
+{
+	remap.resize(vertices.size());
+
+	std::unordered_map<Vector3, uint32_t, PositionHash, PositionEqual> firstVertex{};
+	firstVertex.reserve(vertices.size());
+	for (size_t vertex = 0; vertex < vertices.size(); ++vertex)
+	{
+		remap[vertex] = firstVertex.emplace(vertices[vertex].position, static_cast<uint32_t>(vertex)).first->second;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices)
+{
+	constexpr uint32_t unused{ UINT32_MAX };
+	std::vector<uint32_t> remap(vertices.size(), unused);
+
+	std::vector<Vertex_PosTex> result{};
+	result.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<uint32_t>(result.size());
+			result.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(result);
+}
@@ -0,0 +1,55 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Index and vertex buffer processing that runs once before a mesh gets cached
+	namespace MeshOptimizer
+	{
+		struct VertexCacheStatistics
+		{
+			uint32_t numTransformed{};
+			float acmr{}; //Average transformed vertices per triangle, 0.5 is the best possible
+			float atvr{}; //Average transformed vertices per vertex, 1.0 is the best possible
+		};
+
+		struct OverdrawStatistics
+		{
+			uint64_t pixelsCovered{};
+			uint64_t pixelsShaded{};
+			float overdraw{}; //Shaded per covered pixel, 1.0 means every pixel is shaded exactly once
+		};
+
+		struct VertexFetchStatistics
+		{
+			uint64_t bytesFetched{};
+			uint32_t linesFetched{};
+			float overfetch{}; //Fetched bytes per byte of vertex data, 1.0 means every line is loaded once
+		};
+
+		//Simulates a FIFO post-transform cache of the given size
+		VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices, uint32_t cacheSize = 16);
+
+		//Reorders the triangles for the post-transform cache (Forsyth's linear-speed vertex cache optimisation)
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t numVertices);
+
+		//Rasterizes the mesh in index order with a depth test from numViews directions around it
+		//Back faces (counter-clockwise in D3D) are culled, like the default rasterizer state does
+		OverdrawStatistics AnalyzeOverdraw(const std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, uint32_t numViews = 16, uint32_t resolution = 256);
+
+		//Splits a cache optimized index buffer into clusters and sorts them so outward facing clusters are drawn first
+		//A cluster may end early as long as its ACMR stays within threshold times the ACMR of the unsplit run
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, float threshold = 1.05f);
+
+		//Simulates the 64-byte cache lines read for every vertex that misses the post-transform cache
+		VertexFetchStatistics AnalyzeVertexFetch(const std::vector<uint32_t>& indices, size_t numVertices, size_t vertexSize);
+
+		//For every vertex the first vertex with exactly the same position, hard edges and uv seams split a position over several vertices
+		void GeneratePositionRemap(const std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& remap);
+
+		//Orders the vertices by first use in the index buffer and rewrites the indices to match, unused vertices are dropped
+		//Run this last, after every pass that changes the triangle order
+		void OptimizeVertexFetch(std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices);
+	}
+}
@@ -0,0 +1,454 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <numeric>
+#include <unordered_map>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Keeps borders and seams in place, relative to the planes of the triangles around them
+	constexpr float BoundaryWeight{ 10.f };
+
+	//A collapse may turn a triangle by at most about 75 degrees, beyond that the shading changes too much
+	constexpr float MinNormalDot{ 0.25f };
+
+	constexpr uint32_t NoEdge{ UINT32_MAX };
+	constexpr uint32_t MultipleEdges{ UINT32_MAX - 1 };
+
+	enum class VertexKind : uint8_t
+	{
+		Manifold,	//Surrounded by triangles, can collapse onto any neighbour
+		Border,		//On an open edge, can only collapse along it
+		Seam,		//Split in two by a uv or normal seam, both halves collapse along the seam together
+		Locked		//Anything more complex, never moves
+	};
+
+	//Sum of squared distances to a set of weighted planes
+	struct Quadric
+	{
+		float a00{}, a11{}, a22{};
+		float a10{}, a20{}, a21{};
+		float b0{}, b1{}, b2{};
+		float c{};
+		float weight{};
+
+		void AddPlane(const Vector3& normal, float distance, float planeWeight)
+		{
+			a00 += planeWeight * normal.x * normal.x;
+			a11 += planeWeight * normal.y * normal.y;
+			a22 += planeWeight * normal.z * normal.z;
+			a10 += planeWeight * normal.y * normal.x;
+			a20 += planeWeight * normal.z * normal.x;
+			a21 += planeWeight * normal.z * normal.y;
+			b0 += planeWeight * normal.x * distance;
+			b1 += planeWeight * normal.y * distance;
+			b2 += planeWeight * normal.z * distance;
+			c += planeWeight * distance * distance;
+			weight += planeWeight;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a10 += other.a10; a20 += other.a20; a21 += other.a21;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+
+		//Weighted mean of the squared distances
+		float GetError(const Vector3& p) const
+		{
+			const float rx = a00 * p.x + a10 * p.y + a20 * p.z + b0;
+			const float ry = a10 * p.x + a11 * p.y + a21 * p.z + b1;
+			const float rz = a20 * p.x + a21 * p.y + a22 * p.z + b2;
+			const float error = rx * p.x + ry * p.y + rz * p.z + b0 * p.x + b1 * p.y + b2 * p.z + c;
+			return weight > 0.f ? fabsf(error) / weight : 0.f;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from{};
+		uint32_t to{};
+		float error{};
+	};
+
+	//Topology of the current index buffer, rebuilt before every pass
+	struct Topology
+	{
+		std::vector<VertexKind> kinds{};
+		std::vector<uint32_t> openOut{};	//The open edge leaving each vertex
+		std::vector<uint32_t> openIn{};		//The open edge arriving at each vertex
+		std::vector<uint32_t> wedges{};		//Ring of the used vertices that share a position
+
+		//Triangles around every position
+		std::vector<uint32_t> adjacencyOffsets{};
+		std::vector<uint32_t> adjacency{};
+	};
+
+	void SetOpenEdge(std::vector<uint32_t>& edges, uint32_t vertex, uint32_t other)
+	{
+		edges[vertex] = edges[vertex] == NoEdge ? other : MultipleEdges;
+	}
+
+	bool IsSingleEdge(uint32_t edge)
+	{
+		return edge != NoEdge && edge != MultipleEdges;
+	}
+
+	void BuildTopology(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& positionRemap, Topology& topology)
+	{
+		const size_t numVertices = positionRemap.size();
+		topology.kinds.assign(numVertices, VertexKind::Locked);
+		topology.openOut.assign(numVertices, NoEdge);
+		topology.openIn.assign(numVertices, NoEdge);
+		topology.wedges.resize(numVertices);
+		std::iota(topology.wedges.begin(), topology.wedges.end(), 0u);
+
+		//Every directed edge, an edge is open when its reverse is missing and non-manifold when it shows up twice
+		std::unordered_map<uint64_t, uint32_t> edges{};
+		edges.reserve(indices.size());
+		for (size_t corner = 0; corner < indices.size(); ++corner)
+		{
+			const uint32_t a = indices[corner];
+			const uint32_t b = indices[corner - corner % 3 + (corner + 1) % 3];
+			++edges[uint64_t(a) << 32 | b];
+		}
+
+		std::vector<bool> isUsed(numVertices, false);
+		std::vector<bool> isNonManifold(numVertices, false);
+		for (const auto& [edge, count] : edges)
+		{
+			const uint32_t a = uint32_t(edge >> 32);
+			const uint32_t b = uint32_t(edge);
+			isUsed[a] = isUsed[b] = true;
+
+			if (count > 1)
+				isNonManifold[a] = isNonManifold[b] = true;
+
+			if (edges.find(uint64_t(b) << 32 | a) == edges.end())
+			{
+				SetOpenEdge(topology.openOut, a, b);
+				SetOpenEdge(topology.openIn, b, a);
+			}
+		}
+
+		//Link the used vertices of each position into a ring
+		std::vector<uint32_t> ringStart(numVertices, NoEdge);
+		for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+		{
+			if (!isUsed[vertex])
+				continue;
+
+			uint32_t& start = ringStart[positionRemap[vertex]];
+			if (start == NoEdge)
+			{
+				start = vertex;
+				continue;
+			}
+			topology.wedges[vertex] = topology.wedges[start];
+			topology.wedges[start] = vertex;
+		}
+
+		for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+		{
+			if (!isUsed[vertex] || isNonManifold[vertex])
+				continue;
+
+			const uint32_t out = topology.openOut[vertex];
+			const uint32_t in = topology.openIn[vertex];
+			const uint32_t sibling = topology.wedges[vertex];
+			if (sibling == vertex)
+			{
+				if (out == NoEdge && in == NoEdge)
+					topology.kinds[vertex] = VertexKind::Manifold;
+				else if (IsSingleEdge(out) && IsSingleEdge(in))
+					topology.kinds[vertex] = VertexKind::Border;
+			}
+			else if (topology.wedges[sibling] == vertex && !isNonManifold[sibling])
+			{
+				//Both halves run along the same pair of positions in opposite directions
+				const uint32_t siblingOut = topology.openOut[sibling];
+				const uint32_t siblingIn = topology.openIn[sibling];
+				if (IsSingleEdge(out) && IsSingleEdge(in) && IsSingleEdge(siblingOut) && IsSingleEdge(siblingIn)
+					&& positionRemap[out] == positionRemap[siblingIn] && positionRemap[in] == positionRemap[siblingOut])
+					topology.kinds[vertex] = VertexKind::Seam;
+			}
+		}
+
+		//Triangles per position, stored back to back
+		topology.adjacencyOffsets.assign(numVertices + 1, 0);
+		for (const uint32_t index : indices)
+		{
+			++topology.adjacencyOffsets[positionRemap[index] + 1];
+		}
+		for (size_t position = 0; position < numVertices; ++position)
+		{
+			topology.adjacencyOffsets[position + 1] += topology.adjacencyOffsets[position];
+		}
+
+		topology.adjacency.resize(indices.size());
+		std::vector<uint32_t> fill(topology.adjacencyOffsets.begin(), topology.adjacencyOffsets.end() - 1);
+		for (size_t corner = 0; corner < indices.size(); ++corner)
+		{
+			topology.adjacency[fill[positionRemap[indices[corner]]]++] = static_cast<uint32_t>(corner / 3);
+		}
+	}
+
+	bool CanCollapse(const Topology& topology, const std::vector<uint32_t>& positionRemap, uint32_t from, uint32_t to)
+	{
+		if (positionRemap[from] == positionRemap[to])
+			return false;
+
+		switch (topology.kinds[from])
+		{
+		case VertexKind::Manifold:
+			return true;
+		case VertexKind::Border:
+		case VertexKind::Seam:
+			return topology.kinds[to] == topology.kinds[from] && (topology.openOut[from] == to || topology.openIn[from] == to);
+		default:
+			return false;
+		}
+	}
+
+	//Moving a position may not fold any of its triangles over or flatten it
+	bool HasTriangleFlips(const Topology& topology, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& positionRemap,
+		const std::vector<Vector3>& positions, uint32_t fromPosition, uint32_t toPosition)
+	{
+		for (uint32_t i = topology.adjacencyOffsets[fromPosition]; i < topology.adjacencyOffsets[fromPosition + 1]; ++i)
+		{
+			const uint32_t* pTriangle = &indices[topology.adjacency[i] * 3];
+			const uint32_t corners[3]{ positionRemap[pTriangle[0]], positionRemap[pTriangle[1]], positionRemap[pTriangle[2]] };
+			if (corners[0] == toPosition || corners[1] == toPosition || corners[2] == toPosition)
+				continue; //Removed by the collapse
+
+			Vector3 moved[3]{ positions[corners[0]], positions[corners[1]], positions[corners[2]] };
+			const Vector3 before = Vector3::Cross(moved[1] - moved[0], moved[2] - moved[0]);
+			moved[std::find(corners, corners + 3, fromPosition) - corners] = positions[toPosition];
+			const Vector3 after = Vector3::Cross(moved[1] - moved[0], moved[2] - moved[0]);
+
+			const float lengths = before.Magnitude() * after.Magnitude();
+			if (lengths <= 0.f || Vector3::Dot(before, after) < MinNormalDot * lengths)
+				return true;
+		}
+		return false;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+float MeshSimplifier::Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, size_t targetNumIndices, float maxError, std::vector<uint32_t>& result)
+{
+	result = indices;
+	if (result.size() <= targetNumIndices || vertices.empty())
+		return 0.f;
+
+	const size_t numVertices = vertices.size();
+
+	//Work inside a unit cube so the quadrics keep their precision in float
+	Vector3 boundsMin{ vertices[0].position };
+	Vector3 boundsMax{ vertices[0].position };
+	for (const Vertex_PosTex& vertex : vertices)
+	{
+		boundsMin = Vector3{ std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z) };
+		boundsMax = Vector3{ std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z) };
+	}
+	const float extent = std::max(std::max(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y), boundsMax.z - boundsMin.z);
+	const float scale = extent > 0.f ? 1.f / extent : 1.f;
+
+	std::vector<Vector3> positions(numVertices);
+	for (size_t vertex = 0; vertex < numVertices; ++vertex)
+	{
+		positions[vertex] = (vertices[vertex].position - boundsMin) * scale;
+	}
+
+	//Quadrics, positions and adjacency are all kept per position, on its first vertex
+	std::vector<uint32_t> positionRemap{};
+	MeshOptimizer::GeneratePositionRemap(vertices, positionRemap);
+
+	Topology topology{};
+	BuildTopology(result, positionRemap, topology);
+
+	std::vector<Quadric> quadrics(numVertices);
+	for (size_t triangle = 0; triangle < result.size() / 3; ++triangle)
+	{
+		const uint32_t* pTriangle = &result[triangle * 3];
+		const Vector3& p0 = positions[pTriangle[0]];
+		Vector3 normal = Vector3::Cross(positions[pTriangle[1]] - p0, positions[pTriangle[2]] - p0);
+		const float area = normal.Normalize() * 0.5f;
+		if (area <= 0.f)
+			continue;
+
+		Quadric quadric{};
+		quadric.AddPlane(normal, -Vector3::Dot(normal, p0), area);
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			quadrics[positionRemap[pTriangle[i]]] += quadric;
+		}
+
+		//Open edges get a plane through them, perpendicular to the triangle
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			const uint32_t a = pTriangle[i];
+			const uint32_t b = pTriangle[(i + 1) % 3];
+			if (topology.openOut[a] != b)
+				continue;
+
+			const Vector3 edge = positions[b] - positions[a];
+			Vector3 edgeNormal = Vector3::Cross(edge, normal);
+			if (edgeNormal.Normalize() <= 0.f)
+				continue;
+
+			Quadric edgeQuadric{};
+			edgeQuadric.AddPlane(edgeNormal, -Vector3::Dot(edgeNormal, positions[a]), edge.SqrMagnitude() * BoundaryWeight);
+			quadrics[positionRemap[a]] += edgeQuadric;
+			quadrics[positionRemap[b]] += edgeQuadric;
+		}
+	}
+
+	const float maxErrorSquared = maxError < sqrtf(FLT_MAX) * extent ? (maxError * scale) * (maxError * scale) : FLT_MAX;
+	float resultError{};
+
+	std::vector<Collapse> collapses{};
+	std::vector<uint32_t> collapseRemap(numVertices);
+	std::vector<bool> isLocked(numVertices);
+	while (result.size() > targetNumIndices)
+	{
+		//Cheapest valid direction of every edge
+		collapses.clear();
+		for (size_t corner = 0; corner < result.size(); ++corner)
+		{
+			const uint32_t a = result[corner];
+			const uint32_t b = result[corner - corner % 3 + (corner + 1) % 3];
+
+			Collapse collapse{ 0, 0, FLT_MAX };
+			if (CanCollapse(topology, positionRemap, a, b))
+				collapse = Collapse{ a, b, quadrics[positionRemap[a]].GetError(positions[b]) };
+			if (CanCollapse(topology, positionRemap, b, a))
+			{
+				const float error = quadrics[positionRemap[b]].GetError(positions[a]);
+				if (error < collapse.error)
+					collapse = Collapse{ b, a, error };
+			}
+
+			if (collapse.error < FLT_MAX)
+				collapses.push_back(collapse);
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		//Apply as many as possible, each one locks the triangles it touches for the rest of the pass
+		std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+		std::fill(isLocked.begin(), isLocked.end(), false);
+
+		const size_t triangleGoal = (result.size() - targetNumIndices) / 3;
+		size_t numRemoved{};
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.error > maxErrorSquared || numRemoved >= triangleGoal)
+				break;
+
+			const uint32_t fromPosition = positionRemap[collapse.from];
+			const uint32_t toPosition = positionRemap[collapse.to];
+			if (isLocked[fromPosition] || isLocked[toPosition])
+				continue;
+
+			if (HasTriangleFlips(topology, result, positionRemap, positions, fromPosition, toPosition))
+				continue;
+
+			collapseRemap[collapse.from] = collapse.to;
+			if (topology.kinds[collapse.from] == VertexKind::Seam)
+			{
+				const uint32_t sibling = topology.wedges[collapse.from];
+				collapseRemap[sibling] = topology.openOut[collapse.from] == collapse.to ? topology.openIn[sibling] : topology.openOut[sibling];
+			}
+
+			quadrics[toPosition] += quadrics[fromPosition];
+			resultError = std::max(resultError, collapse.error);
+
+			for (uint32_t i = topology.adjacencyOffsets[fromPosition]; i < topology.adjacencyOffsets[fromPosition + 1]; ++i)
+			{
+				const uint32_t* pTriangle = &result[topology.adjacency[i] * 3];
+				bool isRemoved{};
+				for (uint32_t j = 0; j < 3; ++j)
+				{
+					isLocked[positionRemap[pTriangle[j]]] = true;
+					isRemoved |= positionRemap[pTriangle[j]] == toPosition;
+				}
+				numRemoved += isRemoved;
+			}
+		}
+
+		if (numRemoved == 0)
+			break;
+
+		//Move the indices and drop the triangles that collapsed to a line
+		size_t numIndices{};
+		for (size_t triangle = 0; triangle < result.size() / 3; ++triangle)
+		{
+			const uint32_t a = collapseRemap[result[triangle * 3]];
+			const uint32_t b = collapseRemap[result[triangle * 3 + 1]];
+			const uint32_t c = collapseRemap[result[triangle * 3 + 2]];
+			if (positionRemap[a] == positionRemap[b] || positionRemap[b] == positionRemap[c] || positionRemap[c] == positionRemap[a])
+				continue;
+
+			result[numIndices++] = a;
+			result[numIndices++] = b;
+			result[numIndices++] = c;
+		}
+		result.resize(numIndices);
+
+		BuildTopology(result, positionRemap, topology);
+	}
+
+	return sqrtf(resultError) / scale;
+}
+
+void MeshSimplifier::BuildLODChain(std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, std::vector<LevelOfDetail>& lods, const std::vector<float>& ratios)
+{
+	//Every level starts from the full mesh, simplifying the previous level would add up the errors
+	const std::vector<uint32_t> original = indices;
+
+	lods.clear();
+	lods.push_back(LevelOfDetail{ 0, static_cast<uint32_t>(original.size()), 0.f });
+
+	std::vector<uint32_t> simplified{};
+	for (const float ratio : ratios)
+	{
+		const size_t targetNumIndices = static_cast<size_t>(original.size() / 3 * ratio) * 3;
+		const float error = Simplify(original, vertices, targetNumIndices, FLT_MAX, simplified);
+		if (simplified.size() >= lods.back().numIndices)
+			continue;
+
+		MeshOptimizer::OptimizeVertexCache(simplified, vertices.size());
+
+		//The selector walks the levels from coarse to fine, so the error may never go down
+		lods.push_back(LevelOfDetail{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), std::max(error, lods.back().error) });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+	}
+}
+
+uint32_t MeshSimplifier::SelectLOD(const LevelOfDetail* pLods, uint32_t numLods, float distance, float projectionScale, float screenHeight, float maxPixelError)
+{
+	const float pixelsPerUnit = projectionScale * screenHeight * 0.5f / std::max(distance, FLT_EPSILON);
+	for (uint32_t lod = numLods; lod-- > 1;)
+	{
+		if (pLods[lod].error * pixelsPerUnit <= maxPixelError)
+			return lod;
+	}
+	return 0;
+}
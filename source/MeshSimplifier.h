@@ -0,0 +1,33 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//A simplified copy of the mesh stored as a range of the shared index buffer
+	struct LevelOfDetail
+	{
+		uint32_t indexOffset{};
+		uint32_t numIndices{};
+		float error{}; //Largest distance between the simplified and the original surface, in object space units
+	};
+
+	//Quadric error edge collapse that only ever moves a vertex onto a neighbour, so every level of detail shares the vertex buffer
+	namespace MeshSimplifier
+	{
+		//Collapses edges, cheapest first, until the mesh has targetNumIndices indices or the next collapse would exceed maxError
+		//Border and seam vertices only slide along their own border or seam, and collapses that fold a triangle over are rejected
+		//Returns the error of the result, in object space units
+		float Simplify(const std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, size_t targetNumIndices, float maxError,
+			std::vector<uint32_t>& result);
+
+		//Simplifies the mesh in indices to each ratio of its triangles and appends the results to indices
+		//The first level of detail is the untouched input, levels that don't remove any triangles are skipped
+		void BuildLODChain(std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, std::vector<LevelOfDetail>& lods,
+			const std::vector<float>& ratios = { 0.5f, 0.25f, 0.125f });
+
+		//Coarsest level whose error projects to at most maxPixelError pixels at the given distance
+		//projectionScale is the y scale of the projection matrix, 1 / tan(fov / 2)
+		uint32_t SelectLOD(const LevelOfDetail* pLods, uint32_t numLods, float distance, float projectionScale, float screenHeight, float maxPixelError = 1.f);
+	}
+}
@@ -0,0 +1,383 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "Meshlets.h"
+#include "PositionStream.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Triangles only join a meshlet while they face within about 70 degrees of its average normal
+	//Smaller meshlets, but without it most of them end up with normals in every direction and a useless cone
+	constexpr float MinGrowDot{ 0.3f };
+
+	//Below this the normals spread over more than a hemisphere minus a sliver and the cone would never cull anything
+	constexpr float MinConeDot{ 0.1f };
+
+	Vector3 GetTriangleNormal(const Vector3& p0, const Vector3& p1, const Vector3& p2)
+	{
+		const Vector3 normal = Vector3::Cross(p1 - p0, p2 - p0);
+		const float length = normal.Magnitude();
+		return length > FLT_EPSILON ? normal / length : Vector3{};
+	}
+
+	struct Plane
+	{
+		Vector3 normal{};
+		float distance{};
+	};
+
+	//Gribb-Hartmann: the frustum planes are sums of the columns of the (row vector) worldViewProjection matrix
+	//D3D clip space has 0 <= z <= w, so the near plane is the third column on its own
+	void ExtractFrustumPlanes(const Matrix& worldViewProjection, Plane planes[6])
+	{
+		const Vector4 column[4]{
+			{ worldViewProjection[0].x, worldViewProjection[1].x, worldViewProjection[2].x, worldViewProjection[3].x },
+			{ worldViewProjection[0].y, worldViewProjection[1].y, worldViewProjection[2].y, worldViewProjection[3].y },
+			{ worldViewProjection[0].z, worldViewProjection[1].z, worldViewProjection[2].z, worldViewProjection[3].z },
+			{ worldViewProjection[0].w, worldViewProjection[1].w, worldViewProjection[2].w, worldViewProjection[3].w },
+		};
+
+		const Vector4 equations[6]{
+			column[3] + column[0],	//Left
+			column[3] - column[0],	//Right
+			column[3] + column[1],	//Bottom
+			column[3] - column[1],	//Top
+			column[2],				//Near
+			column[3] - column[2],	//Far
+		};
+
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			const Vector3 normal{ equations[i].x, equations[i].y, equations[i].z };
+			const float length = normal.Magnitude();
+			planes[i].normal = normal / length;
+			planes[i].distance = equations[i].w / length;
+		}
+	}
+
+	//Works on anything that maps a vertex index to its position, interleaved vertices or a position stream
+	template<typename GetPosition>
+	void ComputeMeshletBounds(Meshlet& meshlet, const uint32_t* pIndices, GetPosition&& getPosition)
+	{
+		const uint32_t* pBegin = pIndices + meshlet.indexOffset;
+		const uint32_t* pEnd = pBegin + meshlet.numIndices;
+		if (pBegin == pEnd)
+			return;
+
+		//Ritter's bounding sphere: start from two far apart points, then grow to include the rest
+		const Vector3& first = getPosition(*pBegin);
+		Vector3 a{ first };
+		Vector3 b{ first };
+		for (const uint32_t* pIndex = pBegin; pIndex != pEnd; ++pIndex)
+		{
+			if ((getPosition(*pIndex) - first).SqrMagnitude() > (a - first).SqrMagnitude())
+				a = getPosition(*pIndex);
+		}
+		for (const uint32_t* pIndex = pBegin; pIndex != pEnd; ++pIndex)
+		{
+			if ((getPosition(*pIndex) - a).SqrMagnitude() > (b - a).SqrMagnitude())
+				b = getPosition(*pIndex);
+		}
+
+		Vector3 center = (a + b) * 0.5f;
+		float radius = (b - a).Magnitude() * 0.5f;
+		for (const uint32_t* pIndex = pBegin; pIndex != pEnd; ++pIndex)
+		{
+			const Vector3& position = getPosition(*pIndex);
+			const float distance = (position - center).Magnitude();
+			if (distance > radius)
+			{
+				const float newRadius = (radius + distance) * 0.5f;
+				center += (position - center) * ((newRadius - radius) / distance);
+				radius = newRadius;
+			}
+		}
+
+		meshlet.center = center;
+		meshlet.radius = radius;
+
+
+		//Normal cone: the average normal and the widest angle any triangle makes with it
+		Vector3 axis{};
+		for (const uint32_t* pIndex = pBegin; pIndex != pEnd; pIndex += 3)
+		{
+			axis += GetTriangleNormal(getPosition(pIndex[0]), getPosition(pIndex[1]), getPosition(pIndex[2]));
+		}
+
+		meshlet.coneApex = center;
+		meshlet.coneAxis = Vector3{};
+		meshlet.coneCutoff = 1.f;
+
+		const float axisLength = axis.Magnitude();
+		if (axisLength <= FLT_EPSILON)
+			return;
+		axis = axis / axisLength;
+
+		float minDot{ 1.f };
+		for (const uint32_t* pIndex = pBegin; pIndex != pEnd; pIndex += 3)
+		{
+			const Vector3 normal = GetTriangleNormal(getPosition(pIndex[0]), getPosition(pIndex[1]), getPosition(pIndex[2]));
+			if (normal.SqrMagnitude() > 0.f)
+				minDot = std::min(minDot, Vector3::Dot(normal, axis));
+		}
+
+		meshlet.coneAxis = axis;
+		if (minDot <= MinConeDot)
+			return;
+
+		//Move the apex back along the axis until it lies behind every triangle's plane
+		float maxT{};
+		for (const uint32_t* pIndex = pBegin; pIndex != pEnd; pIndex += 3)
+		{
+			const Vector3& p0 = getPosition(pIndex[0]);
+			const Vector3 normal = GetTriangleNormal(p0, getPosition(pIndex[1]), getPosition(pIndex[2]));
+			if (normal.SqrMagnitude() > 0.f)
+				maxT = std::max(maxT, Vector3::Dot(center - p0, normal) / Vector3::Dot(axis, normal));
+		}
+
+		meshlet.coneApex = center - axis * maxT;
+		meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+void Meshlets::Build(std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, std::vector<Meshlet>& meshlets, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	meshlets.clear();
+
+	const size_t numTriangles = indices.size() / 3;
+	if (numTriangles == 0)
+		return;
+
+	//Hard edges and uv seams split vertices, so neighbours are found through the PositionStream, which shares a position between them
+	//Nothing past this point reads a vertex, only its index and its position
+	std::vector<Vector3> positions{};
+	std::vector<uint32_t> positionIndices{};
+	PositionStream::Extract(vertices.data(), vertices.size(), indices.data(), indices.size(), positions, positionIndices);
+
+	//Triangles per position, stored back to back
+	std::vector<uint32_t> adjacencyOffsets(positions.size() + 1, 0);
+	for (const uint32_t position : positionIndices)
+	{
+		++adjacencyOffsets[position + 1];
+	}
+	for (size_t position = 0; position < positions.size(); ++position)
+	{
+		adjacencyOffsets[position + 1] += adjacencyOffsets[position];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t corner = 0; corner < indices.size(); ++corner)
+		{
+			adjacency[fill[positionIndices[corner]]++] = static_cast<uint32_t>(corner / 3);
+		}
+	}
+
+	std::vector<Vector3> triangleNormals(numTriangles);
+	for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+	{
+		triangleNormals[triangle] = GetTriangleNormal(positions[positionIndices[triangle * 3]], positions[positionIndices[triangle * 3 + 1]], positions[positionIndices[triangle * 3 + 2]]);
+	}
+
+
+	//Grow one meshlet at a time, preferring neighbours that add the fewest vertices and then the ones facing the same way
+	std::vector<uint32_t> sorted{};
+	sorted.reserve(indices.size());
+	std::vector<uint32_t> sortedPositions{};
+	sortedPositions.reserve(indices.size());
+
+	std::vector<bool> isEmitted(numTriangles, false);
+	std::vector<uint32_t> vertexMeshlet(vertices.size(), UINT32_MAX);
+	std::vector<uint32_t> candidates{};
+	size_t cursor{};
+
+	Meshlet meshlet{};
+	uint32_t meshletIndex{};
+	uint32_t numMeshletTriangles{};
+	Vector3 normalSum{};
+
+	const auto getNewVertices = [&](uint32_t triangle)
+		{
+			uint32_t newVertices{};
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				newVertices += vertexMeshlet[indices[triangle * 3 + i]] != meshletIndex;
+			}
+			return newVertices;
+		};
+
+	const auto closeMeshlet = [&]()
+		{
+			meshlet.numIndices = numMeshletTriangles * 3;
+			meshlets.push_back(meshlet);
+
+			meshlet = Meshlet{};
+			meshlet.indexOffset = static_cast<uint32_t>(sorted.size());
+			++meshletIndex;
+			numMeshletTriangles = 0;
+			normalSum = Vector3{};
+			candidates.clear();
+		};
+
+	for (size_t numEmitted = 0; numEmitted < numTriangles; ++numEmitted)
+	{
+		//Pick the best neighbour of the meshlet so far
+		const Vector3 averageNormal = normalSum.SqrMagnitude() > 0.f ? normalSum.Normalized() : Vector3{};
+		uint32_t bestTriangle{ UINT32_MAX };
+		uint32_t bestNewVertices{ UINT32_MAX };
+		float bestDot{ -FLT_MAX };
+		for (const uint32_t triangle : candidates)
+		{
+			if (isEmitted[triangle])
+				continue;
+
+			const uint32_t newVertices = getNewVertices(triangle);
+			if (meshlet.numVertices + newVertices > maxVertices)
+				continue;
+
+			const float dot = Vector3::Dot(triangleNormals[triangle], averageNormal);
+			if (numMeshletTriangles > 0 && dot < MinGrowDot)
+				continue;
+
+			if (newVertices < bestNewVertices || (newVertices == bestNewVertices && dot > bestDot))
+			{
+				bestTriangle = triangle;
+				bestNewVertices = newVertices;
+				bestDot = dot;
+			}
+		}
+
+		//No neighbour fits, continue with the next triangle in the incoming order or start a new meshlet with it
+		if (bestTriangle == UINT32_MAX)
+		{
+			while (isEmitted[cursor])
+			{
+				++cursor;
+			}
+
+			bestTriangle = static_cast<uint32_t>(cursor);
+			bestNewVertices = getNewVertices(bestTriangle);
+			if (numMeshletTriangles > 0 && (!candidates.empty() || meshlet.numVertices + bestNewVertices > maxVertices
+				|| Vector3::Dot(triangleNormals[bestTriangle], averageNormal) < MinGrowDot))
+			{
+				closeMeshlet();
+			}
+		}
+
+		//Add the triangle
+		isEmitted[bestTriangle] = true;
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			const uint32_t index = indices[bestTriangle * 3 + i];
+			const uint32_t position = positionIndices[bestTriangle * 3 + i];
+			sorted.push_back(index);
+			sortedPositions.push_back(position);
+
+			if (vertexMeshlet[index] != meshletIndex)
+			{
+				vertexMeshlet[index] = meshletIndex;
+				++meshlet.numVertices;
+			}
+
+			for (uint32_t j = adjacencyOffsets[position]; j < adjacencyOffsets[position + 1]; ++j)
+			{
+				if (!isEmitted[adjacency[j]])
+					candidates.push_back(adjacency[j]);
+			}
+		}
+		normalSum += triangleNormals[bestTriangle];
+		++numMeshletTriangles;
+
+		//Drop candidates that were emitted meanwhile so the list doesn't keep growing
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](uint32_t triangle) { return isEmitted[triangle]; }), candidates.end());
+
+		if (numMeshletTriangles == maxTriangles || meshlet.numVertices == maxVertices)
+			closeMeshlet();
+	}
+
+	if (numMeshletTriangles > 0)
+		closeMeshlet();
+
+	indices = std::move(sorted);
+
+	//The position indices were sorted along, so the bounds read 12 byte positions instead of whole vertices
+	for (Meshlet& result : meshlets)
+	{
+		ComputeBounds(result, sortedPositions.data(), positions.data());
+	}
+}
+
+void Meshlets::ComputeBounds(Meshlet& meshlet, const uint32_t* pIndices, const Vertex_PosTex* pVertices)
+{
+	ComputeMeshletBounds(meshlet, pIndices, [pVertices](uint32_t index) -> const Vector3& { return pVertices[index].position; });
+}
+
+void Meshlets::ComputeBounds(Meshlet& meshlet, const uint32_t* pPositionIndices, const Vector3* pPositions)
+{
+	ComputeMeshletBounds(meshlet, pPositionIndices, [pPositions](uint32_t index) -> const Vector3& { return pPositions[index]; });
+}
+
+Meshlets::CullStatistics Meshlets::Cull(const std::vector<Meshlet>& meshlets, const Matrix& world, const Matrix& view, const Matrix& projection, bool cullBackfaces, std::vector<DrawRange>& drawRanges)
+{
+	drawRanges.clear();
+
+	CullStatistics statistics{};
+	statistics.numMeshlets = static_cast<uint32_t>(meshlets.size());
+
+	//Everything is tested in object space, so the meshlet bounds never get transformed
+	Plane planes[6]{};
+	ExtractFrustumPlanes(world * view * projection, planes);
+
+	const Vector3 cameraPosition = Matrix::Inverse(world).TransformPoint(Matrix::Inverse(view).GetTranslation());
+
+	for (const Meshlet& meshlet : meshlets)
+	{
+		const uint32_t numTriangles = meshlet.numIndices / 3;
+		statistics.numTriangles += numTriangles;
+
+		bool isVisible{ true };
+		for (const Plane& plane : planes)
+		{
+			if (Vector3::Dot(plane.normal, meshlet.center) + plane.distance < -meshlet.radius)
+			{
+				isVisible = false;
+				++statistics.numFrustumCulled;
+				break;
+			}
+		}
+
+		if (isVisible && cullBackfaces && meshlet.coneCutoff < 1.f)
+		{
+			const Vector3 toApex = meshlet.coneApex - cameraPosition;
+			if (Vector3::Dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * toApex.Magnitude())
+			{
+				isVisible = false;
+				++statistics.numBackfaceCulled;
+			}
+		}
+
+		if (!isVisible)
+			continue;
+
+		statistics.numTrianglesDrawn += numTriangles;
+		if (!drawRanges.empty() && drawRanges.back().indexOffset + drawRanges.back().numIndices == meshlet.indexOffset)
+			drawRanges.back().numIndices += meshlet.numIndices;
+		else
+			drawRanges.push_back(DrawRange{ meshlet.indexOffset, meshlet.numIndices });
+	}
+
+	statistics.numDrawRanges = static_cast<uint32_t>(drawRanges.size());
+	return statistics;
+}
@@ -0,0 +1,65 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//A contiguous run of triangles in the index buffer with the bounds used to cull it
+	struct Meshlet
+	{
+		uint32_t indexOffset{};
+		uint32_t numIndices{};
+		uint32_t numVertices{};
+
+		//Bounding sphere
+		Vector3 center{};
+		float radius{};
+
+		//Every triangle faces away from a camera inside the cone behind the apex
+		//A cutoff of 1 means the triangles face too many directions to ever be culled
+		Vector3 coneApex{};
+		Vector3 coneAxis{};
+		float coneCutoff{ 1.f }; //Sine of the cone angle
+	};
+
+	//Indices [indexOffset, indexOffset + numIndices) passed to DrawIndexed
+	struct DrawRange
+	{
+		uint32_t indexOffset{};
+		uint32_t numIndices{};
+	};
+
+	//Splitting a mesh into meshlets and culling them on the CPU
+	namespace Meshlets
+	{
+		constexpr uint32_t MaxVertices{ 64 };
+		constexpr uint32_t MaxTriangles{ 124 };
+
+		struct CullStatistics
+		{
+			uint32_t numMeshlets{};
+			uint32_t numFrustumCulled{};
+			uint32_t numBackfaceCulled{};
+			uint32_t numTriangles{};
+			uint32_t numTrianglesDrawn{};
+			uint32_t numDrawRanges{};
+		};
+
+		//Reorders the triangles so every meshlet is a contiguous range of the index buffer
+		//Meshlets grow through shared vertices from the current triangle order, so run it after the cache and overdraw passes
+		void Build(std::vector<uint32_t>& indices, const std::vector<Vertex_PosTex>& vertices, std::vector<Meshlet>& meshlets,
+			uint32_t maxVertices = MaxVertices, uint32_t maxTriangles = MaxTriangles);
+
+		//Bounding sphere and normal cone of the triangles in the meshlet's index range
+		void ComputeBounds(Meshlet& meshlet, const uint32_t* pIndices, const Vertex_PosTex* pVertices);
+
+		//Same bounds from a PositionStream, the meshlet's range is read from the position indices
+		void ComputeBounds(Meshlet& meshlet, const uint32_t* pPositionIndices, const Vector3* pPositions);
+
+		//Tests every meshlet against the view frustum and, if the mesh is drawn with back faces culled, the camera position
+		//Adjacent visible meshlets are merged into a single draw range
+		//The cone test assumes the world matrix has a uniform scale
+		CullStatistics Cull(const std::vector<Meshlet>& meshlets, const Matrix& world, const Matrix& view, const Matrix& projection,
+			bool cullBackfaces, std::vector<DrawRange>& drawRanges);
+	}
+}
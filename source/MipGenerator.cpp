@@ -0,0 +1,343 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "MipGenerator.h"
+#include "ColorConversion.h"
+#include "Parallel.h"
+#include <immintrin.h>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Every texel is filtered as 4 floats in one SSE register, rgba in linear space
+	struct Texel
+	{
+		float rgba[4];
+	};
+
+	//Filters are separable, every destination row or column sums a few weighted source ones
+	struct Tap
+	{
+		uint32_t source;
+		float weight;
+	};
+
+	struct Taps
+	{
+		std::vector<uint32_t> first{}; //Taps of destination i are [first[i], first[i + 1])
+		std::vector<Tap> taps{};
+	};
+
+	constexpr float KaiserRadius{ 3.f }; //In destination texels
+	constexpr float KaiserAlpha{ 4.f };
+
+	//Modified Bessel function of the first kind, the series converges quickly for the arguments a Kaiser window uses
+	float BesselI0(float x)
+	{
+		float sum{ 1.f };
+		float term{ 1.f };
+		const float halfSquared = x * x * 0.25f;
+		for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+		{
+			term *= halfSquared / float(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float Kaiser(float t)
+	{
+		const float x = t / KaiserRadius;
+		if (x * x >= 1.f)
+			return 0.f;
+
+		const float sinc = t == 0.f ? 1.f : sinf(PI * t) / (PI * t);
+		return sinc * BesselI0(KaiserAlpha * sqrtf(1.f - x * x)) / BesselI0(KaiserAlpha);
+	}
+
+	Taps BuildTaps(uint32_t sourceSize, uint32_t size, MipGenerator::Filter filter)
+	{
+		Taps result{};
+		result.first.reserve(size + 1);
+
+		//Texel i covers [i, i + 1) in its own level, scale source texels per destination texel
+		const float scale = float(sourceSize) / float(size);
+		for (uint32_t i = 0; i < size; ++i)
+		{
+			result.first.push_back(static_cast<uint32_t>(result.taps.size()));
+
+			//An axis that is already 1 wide stays as it is
+			if (sourceSize == size)
+			{
+				result.taps.push_back(Tap{ i, 1.f });
+				continue;
+			}
+
+			const float begin = float(i) * scale;
+			const float end = float(i + 1) * scale;
+			float sum{};
+			if (filter == MipGenerator::Filter::Box)
+			{
+				for (uint32_t source = uint32_t(begin); source < sourceSize && float(source) < end; ++source)
+				{
+					const float weight = std::min(end, float(source + 1)) - std::max(begin, float(source));
+					result.taps.push_back(Tap{ source, weight });
+					sum += weight;
+				}
+			}
+			else
+			{
+				//Taps outside the image are clamped to the edge, the atlas-like textures here don't tile
+				const float center = (begin + end) * 0.5f;
+				const int32_t firstSource = int32_t(floorf(center - KaiserRadius * scale));
+				const int32_t lastSource = int32_t(ceilf(center + KaiserRadius * scale));
+				for (int32_t source = firstSource; source <= lastSource; ++source)
+				{
+					const float weight = Kaiser((float(source) + 0.5f - center) / scale);
+					if (weight == 0.f)
+						continue;
+
+					result.taps.push_back(Tap{ uint32_t(std::clamp(source, 0, int32_t(sourceSize) - 1)), weight });
+					sum += weight;
+				}
+			}
+
+			for (size_t tap = result.first.back(); tap < result.taps.size(); ++tap)
+			{
+				result.taps[tap].weight /= sum;
+			}
+		}
+		result.first.push_back(static_cast<uint32_t>(result.taps.size()));
+		return result;
+	}
+
+	void DecodeRow(const uint8_t* pSource, Texel* pTexels, uint32_t width, TextureUsage usage)
+	{
+		if (usage == TextureUsage::Color)
+		{
+			ColorConversion::DecodeRGBA8(pSource, pTexels->rgba, width);
+			return;
+		}
+
+		//Normals are stored as n * 0.5 + 0.5, everything else as is
+		const __m128 scale = usage == TextureUsage::Normal ? _mm_setr_ps(2.f / 255.f, 2.f / 255.f, 2.f / 255.f, 1.f / 255.f) : _mm_set1_ps(1.f / 255.f);
+		const __m128 bias = usage == TextureUsage::Normal ? _mm_setr_ps(-1.f, -1.f, -1.f, 0.f) : _mm_setzero_ps();
+		const __m128i zero = _mm_setzero_si128();
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			int32_t bytes{};
+			memcpy(&bytes, pSource + x * 4, 4);
+			const __m128i values = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+			_mm_storeu_ps(pTexels[x].rgba, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(values), scale), bias));
+		}
+	}
+
+	void EncodeRow(const Texel* pTexels, uint8_t* pDestination, uint32_t width, TextureUsage usage)
+	{
+		//The curve clamps on its own, alpha stays linear
+		if (usage == TextureUsage::Color)
+		{
+			ColorConversion::EncodeRGBA8(pTexels->rgba, pDestination, width);
+			return;
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 toByte = _mm_set1_ps(255.f);
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			__m128 value = _mm_loadu_ps(pTexels[x].rgba);
+			if (usage == TextureUsage::Normal)
+				value = _mm_add_ps(_mm_mul_ps(value, _mm_setr_ps(0.5f, 0.5f, 0.5f, 1.f)), _mm_setr_ps(0.5f, 0.5f, 0.5f, 0.f));
+
+			//Sharpening filters overshoot, so everything is clamped first
+			value = _mm_min_ps(_mm_max_ps(value, zero), one);
+
+			const __m128i bytes = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, toByte), half));
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(bytes, bytes), bytes);
+			const int32_t rgba = _mm_cvtsi128_si32(packed);
+			memcpy(pDestination + x * 4, &rgba, 4);
+		}
+	}
+
+	//Zero stays zero instead of turning into a NaN, alpha is left alone
+	void RenormalizeRow(Texel* pTexels, uint32_t width)
+	{
+		const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const __m128 value = _mm_loadu_ps(pTexels[x].rgba);
+			const __m128 xyz = _mm_and_ps(value, xyzMask);
+
+			__m128 sqrMagnitude = _mm_mul_ps(xyz, xyz);
+			sqrMagnitude = _mm_add_ps(sqrMagnitude, _mm_shuffle_ps(sqrMagnitude, sqrMagnitude, _MM_SHUFFLE(2, 3, 0, 1)));
+			sqrMagnitude = _mm_add_ps(sqrMagnitude, _mm_shuffle_ps(sqrMagnitude, sqrMagnitude, _MM_SHUFFLE(1, 0, 3, 2)));
+
+			const __m128 isValid = _mm_cmpgt_ps(sqrMagnitude, _mm_set1_ps(FLT_MIN));
+			const __m128 inverse = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(_mm_max_ps(sqrMagnitude, _mm_set1_ps(FLT_MIN)))), isValid);
+			const __m128 normalized = _mm_or_ps(_mm_mul_ps(xyz, inverse), _mm_andnot_ps(xyzMask, value));
+			_mm_storeu_ps(pTexels[x].rgba, normalized);
+		}
+	}
+
+	//Sums the weighted source rows into one destination row, count floats each
+	void AddWeightedRow(const float* pSource, float* pDestination, size_t count, float weight, bool isFirst)
+	{
+		size_t i{};
+#if defined(__AVX__)
+		const __m256 weight8 = _mm256_set1_ps(weight);
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 weighted = _mm256_mul_ps(_mm256_loadu_ps(pSource + i), weight8);
+			_mm256_storeu_ps(pDestination + i, isFirst ? weighted : _mm256_add_ps(_mm256_loadu_ps(pDestination + i), weighted));
+		}
+#endif
+		const __m128 weight4 = _mm_set1_ps(weight);
+		for (; i < count; i += 4)
+		{
+			const __m128 weighted = _mm_mul_ps(_mm_loadu_ps(pSource + i), weight4);
+			_mm_storeu_ps(pDestination + i, isFirst ? weighted : _mm_add_ps(_mm_loadu_ps(pDestination + i), weighted));
+		}
+	}
+
+	//Filters the rows first and the columns of the result second, both split over the threads by rows
+	void Downsample(const std::vector<Texel>& source, uint32_t sourceWidth, uint32_t sourceHeight,
+		std::vector<Texel>& destination, uint32_t width, uint32_t height, MipGenerator::Filter filter, TextureUsage usage, uint32_t numThreads)
+	{
+		const Taps columns = BuildTaps(sourceWidth, width, filter);
+		const Taps rows = BuildTaps(sourceHeight, height, filter);
+
+		std::vector<Texel> horizontal(size_t(width) * sourceHeight);
+		ParallelFor(sourceHeight, [&](size_t begin, size_t end, uint32_t)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					const Texel* pSource = source.data() + y * sourceWidth;
+					Texel* pDestination = horizontal.data() + y * width;
+					for (uint32_t x = 0; x < width; ++x)
+					{
+						__m128 sum = _mm_setzero_ps();
+						for (uint32_t tap = columns.first[x]; tap < columns.first[x + 1]; ++tap)
+						{
+							sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pSource[columns.taps[tap].source].rgba), _mm_set1_ps(columns.taps[tap].weight)));
+						}
+						_mm_storeu_ps(pDestination[x].rgba, sum);
+					}
+				}
+			}, numThreads);
+
+		destination.resize(size_t(width) * height);
+		ParallelFor(height, [&](size_t begin, size_t end, uint32_t)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					Texel* pDestination = destination.data() + y * width;
+					for (uint32_t tap = rows.first[y]; tap < rows.first[y + 1]; ++tap)
+					{
+						const Texel* pSource = horizontal.data() + size_t(rows.taps[tap].source) * width;
+						AddWeightedRow(pSource->rgba, pDestination->rgba, size_t(width) * 4, rows.taps[tap].weight, tap == rows.first[y]);
+					}
+
+					//The next level is filtered from unit normals again
+					if (usage == TextureUsage::Normal)
+						RenormalizeRow(pDestination, width);
+				}
+			}, numThreads);
+	}
+
+	//Filtering from the float level above keeps the rounding of one level out of the next
+	void GenerateLevels(std::vector<Texel>& texels, TextureUsage usage, MipGenerator::Filter filter, TextureData& texture, uint32_t numThreads)
+	{
+		std::vector<Texel> nextTexels{};
+		for (size_t level = 1; level < texture.levels.size(); ++level)
+		{
+			const TextureData::Level& source = texture.levels[level - 1];
+			const TextureData::Level& destination = texture.levels[level];
+			Downsample(texels, source.width, source.height, nextTexels, destination.width, destination.height, filter, usage, numThreads);
+
+			uint8_t* pDestination = texture.data.data() + destination.offset;
+			const uint32_t destinationPitch = texture.GetRowPitch(level);
+			ParallelFor(destination.height, [&](size_t begin, size_t end, uint32_t)
+				{
+					for (size_t y = begin; y < end; ++y)
+					{
+						EncodeRow(nextTexels.data() + y * destination.width, pDestination + y * destinationPitch, destination.width, usage);
+					}
+				}, numThreads);
+
+			texels.swap(nextTexels);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+uint32_t MipGenerator::GetNumLevels(uint32_t width, uint32_t height)
+{
+	uint32_t numLevels{ 1 };
+	for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+	{
+		++numLevels;
+	}
+	return numLevels;
+}
+
+void MipGenerator::Generate(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch, TextureUsage usage, Filter filter, TextureData& texture, uint32_t numThreads)
+{
+	Allocate(width, height, texture);
+
+	//Level 0 is kept exactly as it was loaded, it's only decoded to filter the next one
+	std::vector<Texel> texels(size_t(width) * height);
+	ParallelFor(height, [&](size_t begin, size_t end, uint32_t)
+		{
+			for (size_t y = begin; y < end; ++y)
+			{
+				const uint8_t* pSource = pPixels + y * rowPitch;
+				memcpy(texture.data.data() + y * texture.GetRowPitch(0), pSource, texture.GetRowPitch(0));
+				DecodeRow(pSource, texels.data() + y * width, width, usage);
+			}
+		}, numThreads);
+
+	GenerateLevels(texels, usage, filter, texture, numThreads);
+}
+
+void MipGenerator::Allocate(uint32_t width, uint32_t height, TextureData& texture)
+{
+	texture.format = TextureFormat::RGBA8;
+	texture.levels.clear();
+
+	size_t size{};
+	for (uint32_t level = 0, levelWidth = width, levelHeight = height; level < GetNumLevels(width, height); ++level)
+	{
+		texture.levels.push_back(TextureData::Level{ levelWidth, levelHeight, size });
+		size += GetLevelSize(texture.format, levelWidth, levelHeight);
+
+		levelWidth = std::max(levelWidth / 2, 1u);
+		levelHeight = std::max(levelHeight / 2, 1u);
+	}
+	texture.data.resize(size);
+}
+
+void MipGenerator::Generate(TextureUsage usage, Filter filter, TextureData& texture, uint32_t numThreads)
+{
+	const TextureData::Level& first = texture.levels[0];
+	std::vector<Texel> texels(size_t(first.width) * first.height);
+	ParallelFor(first.height, [&](size_t begin, size_t end, uint32_t)
+		{
+			for (size_t y = begin; y < end; ++y)
+			{
+				DecodeRow(texture.data.data() + y * texture.GetRowPitch(0), texels.data() + y * first.width, first.width, usage);
+			}
+		}, numThreads);
+
+	GenerateLevels(texels, usage, filter, texture, numThreads);
+}
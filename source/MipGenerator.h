@@ -0,0 +1,29 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+
+namespace dae
+{
+	//Full mip chains built on the CPU, every level is filtered from the one above it in linear space
+	namespace MipGenerator
+	{
+		enum class Filter
+		{
+			Box,	//Average of the texels a destination texel covers
+			Kaiser	//Kaiser windowed sinc, sharper distant textures at the cost of some ringing
+		};
+
+		//Levels down to 1x1
+		uint32_t GetNumLevels(uint32_t width, uint32_t height);
+
+		//Reads RGBA8 pixels, rowPitch bytes apart, and writes every level into texture, level 0 is copied as is
+		//Rows are split over the threads, numThreads = 0 picks one per hardware thread and the result is identical for any thread count
+		void Generate(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch, TextureUsage usage, Filter filter, TextureData& texture, uint32_t numThreads = 0);
+
+		//Lays out every level of an RGBA8 chain, level 0 is left for the caller to write into directly
+		void Allocate(uint32_t width, uint32_t height, TextureData& texture);
+
+		//Fills in the levels below 0 of a chain laid out by Allocate
+		void Generate(TextureUsage usage, Filter filter, TextureData& texture, uint32_t numThreads = 0);
+	}
+}
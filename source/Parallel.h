@@ -0,0 +1,43 @@
+#pragma once
+#include <thread>
+
+namespace dae
+{
+	//Returns how many workers to use for a job of count items, 0 means one per hardware thread
+	inline uint32_t GetNumWorkers(size_t count, uint32_t numThreads = 0)
+	{
+		if (numThreads == 0)
+			numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		return static_cast<uint32_t>(std::max<size_t>(std::min<size_t>(numThreads, count), 1));
+	}
+
+	//Splits [0, count) into one contiguous range per worker and calls function(begin, end, workerIndex) for each
+	//The calling thread handles the first range itself
+	template<typename Function>
+	void ParallelFor(size_t count, Function&& function, uint32_t numThreads = 0)
+	{
+		const uint32_t numWorkers = GetNumWorkers(count, numThreads);
+		if (numWorkers == 1)
+		{
+			function(size_t{ 0 }, count, 0u);
+			return;
+		}
+
+		std::vector<std::thread> threads{};
+		threads.reserve(numWorkers - 1);
+		for (uint32_t worker = 1; worker < numWorkers; ++worker)
+		{
+			const size_t begin = count * worker / numWorkers;
+			const size_t end = count * (worker + 1) / numWorkers;
+			threads.emplace_back([&function, begin, end, worker]() { function(begin, end, worker); });
+		}
+
+		function(size_t{ 0 }, count / numWorkers, 0u);
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
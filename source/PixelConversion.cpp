@@ -0,0 +1,373 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "PixelConversion.h"
+#include "Parallel.h"
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+using namespace dae;
+using namespace dae::PixelConversion;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+//MSVC compiles any intrinsic, GCC and Clang only inside functions marked for the instruction set
+#if defined(_MSC_VER)
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+	constexpr uint32_t OpaqueBlack{ 0xFF000000 };
+
+	InstructionSet DetectInstructionSet()
+	{
+		uint32_t info[4]{};
+		const auto cpuid = [&info](uint32_t leaf)
+			{
+#if defined(_MSC_VER)
+				__cpuidex(reinterpret_cast<int*>(info), leaf, 0);
+#else
+				__cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+			};
+
+		cpuid(0);
+		const uint32_t maxLeaf = info[0];
+		if (maxLeaf < 1)
+			return InstructionSet::Scalar;
+
+		cpuid(1);
+		const bool hasSSSE3 = info[2] & (1u << 9);
+		const bool hasOSXSAVE = info[2] & (1u << 27);
+		if (!hasSSSE3)
+			return InstructionSet::Scalar;
+		if (!hasOSXSAVE || maxLeaf < 7)
+			return InstructionSet::SSSE3;
+
+		//The OS has to save the ymm registers as well
+#if defined(_MSC_VER)
+		const uint64_t enabledStates = _xgetbv(0);
+#else
+		uint32_t low{}, high{};
+		__asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		const uint64_t enabledStates = (uint64_t(high) << 32) | low;
+#endif
+		cpuid(7);
+		const bool hasAVX2 = info[1] & (1u << 5);
+		return hasAVX2 && (enabledStates & 0x6) == 0x6 ? InstructionSet::AVX2 : InstructionSet::SSSE3;
+	}
+
+	//Scalar kernels, the SIMD ones finish their rows with these
+	void SwizzleScalar(const uint8_t* pSource, uint8_t* pDestination, uint32_t count)
+	{
+		for (uint32_t x = 0; x < count; ++x)
+		{
+			pDestination[x * 4 + 0] = pSource[x * 4 + 2];
+			pDestination[x * 4 + 1] = pSource[x * 4 + 1];
+			pDestination[x * 4 + 2] = pSource[x * 4 + 0];
+			pDestination[x * 4 + 3] = pSource[x * 4 + 3];
+		}
+	}
+
+	void ExpandRGBScalar(const uint8_t* pSource, uint8_t* pDestination, uint32_t count, bool isBGR)
+	{
+		const uint32_t red = isBGR ? 2 : 0;
+		for (uint32_t x = 0; x < count; ++x)
+		{
+			pDestination[x * 4 + 0] = pSource[x * 3 + red];
+			pDestination[x * 4 + 1] = pSource[x * 3 + 1];
+			pDestination[x * 4 + 2] = pSource[x * 3 + 2 - red];
+			pDestination[x * 4 + 3] = 255;
+		}
+	}
+
+	void ExpandGrayScalar(const uint8_t* pSource, uint8_t* pDestination, uint32_t count)
+	{
+		for (uint32_t x = 0; x < count; ++x)
+		{
+			const uint32_t texel = pSource[x] * 0x010101u | OpaqueBlack;
+			memcpy(pDestination + x * 4, &texel, 4);
+		}
+	}
+
+	void ExpandPaletteScalar(const uint8_t* pSource, uint8_t* pDestination, uint32_t count, const uint32_t* pPalette)
+	{
+		for (uint32_t x = 0; x < count; ++x)
+		{
+			memcpy(pDestination + x * 4, pPalette + pSource[x], 4);
+		}
+	}
+
+	//SSSE3, 16 pixels per iteration
+	TARGET_SSSE3 void SwizzleSSSE3(const uint8_t* pSource, uint8_t* pDestination, uint32_t count)
+	{
+		const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		uint32_t x{};
+		for (; x + 16 <= count; x += 16)
+		{
+			for (uint32_t part = 0; part < 4; ++part)
+			{
+				const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + (x + part * 4) * 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination + (x + part * 4) * 4), _mm_shuffle_epi8(texels, shuffle));
+			}
+		}
+		SwizzleScalar(pSource + x * 4, pDestination + x * 4, count - x);
+	}
+
+	TARGET_SSSE3 void ExpandRGBSSSE3(const uint8_t* pSource, uint8_t* pDestination, uint32_t count, bool isBGR)
+	{
+		//Spreads the 12 bytes of 4 pixels over 16, the zeroed alpha is filled in after
+		const __m128i shuffle = isBGR
+			? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+			: _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(OpaqueBlack));
+
+		//Three loads hold 16 pixels, the pixels that straddle two of them are lined up with alignr
+		uint32_t x{};
+		for (; x + 16 <= count; x += 16)
+		{
+			const __m128i* pBlock = reinterpret_cast<const __m128i*>(pSource + x * 3);
+			const __m128i first = _mm_loadu_si128(pBlock);
+			const __m128i second = _mm_loadu_si128(pBlock + 1);
+			const __m128i third = _mm_loadu_si128(pBlock + 2);
+
+			__m128i* pOut = reinterpret_cast<__m128i*>(pDestination + x * 4);
+			_mm_storeu_si128(pOut + 0, _mm_or_si128(_mm_shuffle_epi8(first, shuffle), alpha));
+			_mm_storeu_si128(pOut + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(second, first, 12), shuffle), alpha));
+			_mm_storeu_si128(pOut + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(third, second, 8), shuffle), alpha));
+			_mm_storeu_si128(pOut + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(third, 4), shuffle), alpha));
+		}
+		ExpandRGBScalar(pSource + x * 3, pDestination + x * 4, count - x, isBGR);
+	}
+
+	TARGET_SSSE3 void ExpandGraySSSE3(const uint8_t* pSource, uint8_t* pDestination, uint32_t count)
+	{
+		const __m128i shuffles[4]
+		{
+			_mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1),
+			_mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+			_mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+			_mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)
+		};
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(OpaqueBlack));
+
+		uint32_t x{};
+		for (; x + 16 <= count; x += 16)
+		{
+			const __m128i gray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x));
+			__m128i* pOut = reinterpret_cast<__m128i*>(pDestination + x * 4);
+			for (uint32_t part = 0; part < 4; ++part)
+			{
+				_mm_storeu_si128(pOut + part, _mm_or_si128(_mm_shuffle_epi8(gray, shuffles[part]), alpha));
+			}
+		}
+		ExpandGrayScalar(pSource + x, pDestination + x * 4, count - x);
+	}
+
+	//AVX2, shuffles stay within 128 bit lanes so every lane gets its own pixels first
+	TARGET_AVX2 void SwizzleAVX2(const uint8_t* pSource, uint8_t* pDestination, uint32_t count)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+		uint32_t x{};
+		for (; x + 16 <= count; x += 16)
+		{
+			for (uint32_t part = 0; part < 2; ++part)
+			{
+				const __m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSource + (x + part * 8) * 4));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDestination + (x + part * 8) * 4), _mm256_shuffle_epi8(texels, shuffle));
+			}
+		}
+		SwizzleScalar(pSource + x * 4, pDestination + x * 4, count - x);
+	}
+
+	TARGET_AVX2 void ExpandRGBAVX2(const uint8_t* pSource, uint8_t* pDestination, uint32_t count, bool isBGR)
+	{
+		const __m256i shuffle = isBGR
+			? _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+			: _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OpaqueBlack));
+
+		//The 24 bytes of 8 pixels are moved apart so each lane starts with 12 of them
+		const __m256i spread = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+
+		//A load covers 8 bytes past its pixels, those have to lie inside the row
+		uint32_t x{};
+		for (; (size_t(x) + 8) * 3 + 8 <= size_t(count) * 3; x += 8)
+		{
+			const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSource + x * 3));
+			const __m256i texels = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(block, spread), shuffle);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDestination + x * 4), _mm256_or_si256(texels, alpha));
+		}
+		ExpandRGBSSSE3(pSource + x * 3, pDestination + x * 4, count - x, isBGR);
+	}
+
+	TARGET_AVX2 void ExpandGrayAVX2(const uint8_t* pSource, uint8_t* pDestination, uint32_t count)
+	{
+		const __m256i shuffles[2]
+		{
+			_mm256_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1, 4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+			_mm256_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1, 12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)
+		};
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(OpaqueBlack));
+
+		uint32_t x{};
+		for (; x + 16 <= count; x += 16)
+		{
+			const __m256i gray = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x)));
+			__m256i* pOut = reinterpret_cast<__m256i*>(pDestination + x * 4);
+			for (uint32_t part = 0; part < 2; ++part)
+			{
+				_mm256_storeu_si256(pOut + part, _mm256_or_si256(_mm256_shuffle_epi8(gray, shuffles[part]), alpha));
+			}
+		}
+		ExpandGrayScalar(pSource + x, pDestination + x * 4, count - x);
+	}
+
+	//SSSE3 has no gather, palettes only get a kernel of their own with AVX2
+	TARGET_AVX2 void ExpandPaletteAVX2(const uint8_t* pSource, uint8_t* pDestination, uint32_t count, const uint32_t* pPalette)
+	{
+		const int* pEntries = reinterpret_cast<const int*>(pPalette);
+
+		uint32_t x{};
+		for (; x + 16 <= count; x += 16)
+		{
+			const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x));
+			const __m256i first = _mm256_i32gather_epi32(pEntries, _mm256_cvtepu8_epi32(indices), 4);
+			const __m256i second = _mm256_i32gather_epi32(pEntries, _mm256_cvtepu8_epi32(_mm_srli_si128(indices, 8)), 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDestination + x * 4), first);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDestination + x * 4) + 1, second);
+		}
+		ExpandPaletteScalar(pSource + x, pDestination + x * 4, count - x, pPalette);
+	}
+
+	bool GetLayout(const SDL_PixelFormat* pFormat, Layout& layout)
+	{
+		switch (pFormat->format)
+		{
+		case SDL_PIXELFORMAT_RGBA32: layout = Layout::RGBA8; return true;
+		case SDL_PIXELFORMAT_BGRA32: layout = Layout::BGRA8; return true;
+		case SDL_PIXELFORMAT_RGB24: layout = Layout::RGB8; return true;
+		case SDL_PIXELFORMAT_BGR24: layout = Layout::BGR8; return true;
+		case SDL_PIXELFORMAT_INDEX8: layout = Layout::Palette8; return pFormat->palette != nullptr;
+		default: return false;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+InstructionSet PixelConversion::GetInstructionSet()
+{
+	static const InstructionSet instructionSet{ DetectInstructionSet() };
+	return instructionSet;
+}
+
+void PixelConversion::ConvertRow(Layout layout, const uint8_t* pSource, uint8_t* pDestination, uint32_t count, const uint32_t* pPalette, InstructionSet instructionSet)
+{
+	const bool hasAVX2 = instructionSet == InstructionSet::AVX2;
+	const bool hasSSSE3 = instructionSet != InstructionSet::Scalar;
+
+	switch (layout)
+	{
+	case Layout::RGBA8:
+		memcpy(pDestination, pSource, size_t(count) * 4);
+		break;
+	case Layout::BGRA8:
+		if (hasAVX2) SwizzleAVX2(pSource, pDestination, count);
+		else if (hasSSSE3) SwizzleSSSE3(pSource, pDestination, count);
+		else SwizzleScalar(pSource, pDestination, count);
+		break;
+	case Layout::RGB8:
+	case Layout::BGR8:
+		if (hasAVX2) ExpandRGBAVX2(pSource, pDestination, count, layout == Layout::BGR8);
+		else if (hasSSSE3) ExpandRGBSSSE3(pSource, pDestination, count, layout == Layout::BGR8);
+		else ExpandRGBScalar(pSource, pDestination, count, layout == Layout::BGR8);
+		break;
+	case Layout::Gray8:
+		if (hasAVX2) ExpandGrayAVX2(pSource, pDestination, count);
+		else if (hasSSSE3) ExpandGraySSSE3(pSource, pDestination, count);
+		else ExpandGrayScalar(pSource, pDestination, count);
+		break;
+	case Layout::Palette8:
+		if (hasAVX2) ExpandPaletteAVX2(pSource, pDestination, count, pPalette);
+		else ExpandPaletteScalar(pSource, pDestination, count, pPalette);
+		break;
+	}
+}
+
+bool PixelConversion::CanConvert(const SDL_Surface* pSurface)
+{
+	Layout layout{};
+	if (!pSurface || !GetLayout(pSurface->format, layout))
+		return false;
+
+	//SDL makes color keyed pixels transparent when it converts, for a palette that's one entry of the table
+	uint32_t colorKey{};
+	return layout == Layout::Palette8 || SDL_GetColorKey(const_cast<SDL_Surface*>(pSurface), &colorKey) != 0;
+}
+
+bool PixelConversion::ConvertSurface(const SDL_Surface* pSurface, uint8_t* pDestination, uint32_t numThreads, InstructionSet instructionSet)
+{
+	if (!CanConvert(pSurface))
+		return false;
+
+	Layout layout{};
+	GetLayout(pSurface->format, layout);
+
+	//Indices past the colors of the palette come out opaque black, like SDL does
+	uint32_t palette[256]{};
+	if (layout == Layout::Palette8)
+	{
+		const SDL_Palette* pPalette = pSurface->format->palette;
+		bool isGrayRamp = pPalette->ncolors == 256;
+		for (int index = 0; index < 256; ++index)
+		{
+			palette[index] = OpaqueBlack;
+			if (index < pPalette->ncolors)
+			{
+				const SDL_Color& color = pPalette->colors[index];
+				memcpy(&palette[index], &color, 4);
+			}
+			isGrayRamp = isGrayRamp && palette[index] == (index * 0x010101u | OpaqueBlack);
+		}
+
+		uint32_t colorKey{};
+		if (SDL_GetColorKey(const_cast<SDL_Surface*>(pSurface), &colorKey) == 0 && colorKey < 256)
+		{
+			palette[colorKey] &= ~OpaqueBlack;
+			isGrayRamp = false;
+		}
+
+		//Grayscale images load as a palette of every gray
+		if (isGrayRamp)
+			layout = Layout::Gray8;
+	}
+
+	const uint8_t* pSource = static_cast<const uint8_t*>(pSurface->pixels);
+	const uint32_t width = static_cast<uint32_t>(pSurface->w);
+	ParallelFor(static_cast<size_t>(pSurface->h), [&](size_t begin, size_t end, uint32_t)
+		{
+			for (size_t y = begin; y < end; ++y)
+			{
+				ConvertRow(layout, pSource + y * pSurface->pitch, pDestination + y * width * 4, width, palette, instructionSet);
+			}
+		}, numThreads);
+	return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+// Includes
+
+namespace dae
+{
+	//Expands the pixel layouts images load in to RGBA8 in one pass, without going through SDL_ConvertSurfaceFormat
+	//The shuffle kernels are picked at runtime, SSSE3 and AVX2 when the processor has them, and every instruction set writes the same bytes
+	namespace PixelConversion
+	{
+		//Byte order in memory
+		enum class Layout
+		{
+			RGBA8,
+			BGRA8,
+			RGB8,
+			BGR8,
+			Gray8,		//Opaque gray, the rgb channels repeat it
+			Palette8	//An index into 256 rgba entries
+		};
+
+		enum class InstructionSet
+		{
+			Scalar,
+			SSSE3,
+			AVX2
+		};
+
+		//The best one the processor and the OS support, checked once
+		InstructionSet GetInstructionSet();
+
+		//count pixels to RGBA8, the palette holds rgba in memory order and is only read for Palette8
+		void ConvertRow(Layout layout, const uint8_t* pSource, uint8_t* pDestination, uint32_t count, const uint32_t* pPalette = nullptr, InstructionSet instructionSet = GetInstructionSet());
+
+		//Whether the surface has a kernel, other layouts and color keys on anything but a palette are left to SDL
+		bool CanConvert(const SDL_Surface* pSurface);
+
+		//Every row of the surface into width * height * 4 tightly packed bytes, split over numThreads
+		//A palette that holds a gray ramp takes the gray kernel and a color keyed palette entry becomes transparent
+		bool ConvertSurface(const SDL_Surface* pSurface, uint8_t* pDestination, uint32_t numThreads = 0, InstructionSet instructionSet = GetInstructionSet());
+	}
+}
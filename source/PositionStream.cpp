@@ -0,0 +1,83 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "PositionStream.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t Empty{ UINT32_MAX };
+
+	//Exact bit patterns, the positions on a seam are copies of each other
+	uint32_t HashPosition(const Vector3& position)
+	{
+		uint32_t bits[3]{};
+		memcpy(bits, &position, sizeof(bits));
+		return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+	}
+
+	bool IsSamePosition(const Vector3& a, const Vector3& b)
+	{
+		return memcmp(&a, &b, sizeof(Vector3)) == 0;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+void PositionStream::Extract(const Vertex_PosTex* pVertices, size_t numVertices, const uint32_t* pIndices, size_t numIndices,
+	std::vector<Vector3>& positions, std::vector<uint32_t>& positionIndices)
+{
+	positions.clear();
+	positionIndices.resize(numIndices);
+
+	//Power of two at least twice the number of vertices keeps the linear probes short
+	uint32_t tableSize{ 16 };
+	while (tableSize < numVertices * 2)
+	{
+		tableSize *= 2;
+	}
+	std::vector<uint32_t> table(tableSize, Empty);
+
+	//Vertices are looked up once, later references reuse the position found the first time
+	std::vector<uint32_t> vertexToPosition(numVertices, Empty);
+	for (size_t index = 0; index < numIndices; ++index)
+	{
+		const uint32_t vertex = pIndices[index];
+		if (vertexToPosition[vertex] == Empty)
+		{
+			const Vector3& position = pVertices[vertex].position;
+
+			uint32_t slot = HashPosition(position) & (tableSize - 1);
+			while (table[slot] != Empty && !IsSamePosition(positions[table[slot]], position))
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == Empty)
+			{
+				table[slot] = static_cast<uint32_t>(positions.size());
+				positions.emplace_back(position);
+			}
+			vertexToPosition[vertex] = table[slot];
+		}
+		positionIndices[index] = vertexToPosition[vertex];
+	}
+}
+
+void PositionStream::ComputeBounds(const Vector3* pPositions, size_t numPositions, Vector3& boundsMin, Vector3& boundsMax)
+{
+	boundsMin = boundsMax = numPositions > 0 ? pPositions[0] : Vector3{};
+	for (size_t index = 0; index < numPositions; ++index)
+	{
+		const Vector3& position = pPositions[index];
+		boundsMin = Vector3{ std::min(boundsMin.x, position.x), std::min(boundsMin.y, position.y), std::min(boundsMin.z, position.z) };
+		boundsMax = Vector3{ std::max(boundsMax.x, position.x), std::max(boundsMax.y, position.y), std::max(boundsMax.z, position.z) };
+	}
+}
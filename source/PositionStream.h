@@ -0,0 +1,18 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Tightly packed positions for everything that only looks at the geometry: bounds, culling, picking and depth-only passes
+	//A Vertex_PosTex is 48 bytes of which 12 are the position, the stream also shares a position between the vertices split on a seam
+	namespace PositionStream
+	{
+		//Every distinct position once, in the order the index buffer first reads it, and an index buffer into them
+		//The position indices hold the same triangles in the same order, so meshlet and level of detail ranges apply to both buffers
+		void Extract(const Vertex_PosTex* pVertices, size_t numVertices, const uint32_t* pIndices, size_t numIndices,
+			std::vector<Vector3>& positions, std::vector<uint32_t>& positionIndices);
+
+		void ComputeBounds(const Vector3* pPositions, size_t numPositions, Vector3& boundsMin, Vector3& boundsMax);
+	}
+}
@@ -1,11 +1,13 @@
 #include "pch.h"
 #include "Renderer.h"
-#include "Utils.h"
+#include "MeshCache.h"
 #include "Scene.h"
 #include "Camera.h"
 #include "Mesh.h"
 #include "Effect.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "VertexPacking.h"
 
 namespace dae {
 
@@ -32,6 +34,24 @@ namespace dae {
 		}
 	}
 
+	Renderer::Renderer(int width, int height) :
+		m_Width(width),
+		m_Height(height)
+	{
+		//Initialize DirectX pipeline without a window to present to
+		IDXGIFactory1* pDxgiFactory{};
+		const HRESULT result = InitializeDirectX(pDxgiFactory);
+		if (pDxgiFactory) pDxgiFactory->Release();
+		if (result == S_OK)
+		{
+			m_IsInitialized = true;
+		}
+		else
+		{
+			std::cout << "DirectX initialization failed!\n";
+		}
+	}
+
 	Renderer::~Renderer()
 	{
 		if (m_pScene) delete m_pScene;
@@ -77,7 +97,8 @@ namespace dae {
 		m_pScene->Render(m_pDeviceContext);
 
 		//3. PRESENT BACKBUFFER (SWAP)
-		m_pSwapChain->Present(0, 0);
+		if (m_pSwapChain)
+			m_pSwapChain->Present(0, 0);
 	}
 
 	void Renderer::ToggleSamplerStates() const
@@ -85,6 +106,43 @@ namespace dae {
 		m_pScene->ToggleSamplerState();
 	}
 
+	void Renderer::ToggleVertexFormat()
+	{
+		if (!m_IsInitialized)
+			return;
+
+		m_UsePackedVertices = !m_UsePackedVertices;
+		std::cout << "Vertex format: " << (m_UsePackedVertices ? "packed" : "float") << '\n';
+
+		//Rebuild the scene so every mesh gets recreated with the new layout
+		delete m_pScene;
+		m_pMeshRotating = nullptr;
+		m_pScene = Scene_5();
+	}
+
+	void Renderer::RunStaticBatchingTest()
+	{
+		if (!m_IsInitialized)
+			return;
+
+		//Unbatched, batched, then batched with the vehicle maps in atlases
+		const char* names[]{ "Unbatched: ", "Batched:   ", "Atlased:   " };
+		for (int mode = 0; mode < 3; ++mode)
+		{
+			const bool useBatching = mode > 0;
+			const bool useAtlases = mode > 1;
+			delete m_pScene;
+			m_pScene = Scene_6(useBatching, useAtlases);
+			m_pScene->UpdateMeshes();
+			Render();
+			m_pDeviceContext->Flush();
+
+			const RenderStatistics& statistics = m_pScene->GetRenderStatistics();
+			std::cout << names[mode] << statistics.numMeshes << " meshes, "
+				<< statistics.numDrawCalls << " draw calls, " << statistics.numStateChanges << " state changes, " << statistics.numTextureBinds << " texture binds\n";
+		}
+	}
+
 	HRESULT Renderer::InitializeDirectX(IDXGIFactory1*& pDxgiFactory)
 	{
 		//1. Create Device & Context
@@ -95,8 +153,9 @@ namespace dae {
 		createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
 #endif
 
+		//Without a window the software rasterizer is used, it's available on every machine
 		HRESULT result = D3D11CreateDevice(	nullptr,
-											D3D_DRIVER_TYPE_HARDWARE,
+											m_pWindow ? D3D_DRIVER_TYPE_HARDWARE : D3D_DRIVER_TYPE_WARP,
 											0,
 											createDeviceFlags,
 											&featureLevel,
@@ -133,16 +192,20 @@ namespace dae {
 		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
 		swapChainDesc.Flags = 0;
 
-		//Get the handle (HWND) from the SDL Backbuffer
-		SDL_SysWMinfo sysWMInfo{};
-		SDL_VERSION(&sysWMInfo.version);
-		SDL_GetWindowWMInfo(m_pWindow, &sysWMInfo);
-		swapChainDesc.OutputWindow = sysWMInfo.info.win.window;
-
-		//Creat Swapchain
-		result = pDxgiFactory->CreateSwapChain(m_pDevice, &swapChainDesc, &m_pSwapChain);
-		if (FAILED(result))
-			return result;
+		//Headless renderers have no window to present to
+		if (m_pWindow)
+		{
+			//Get the handle (HWND) from the SDL Backbuffer
+			SDL_SysWMinfo sysWMInfo{};
+			SDL_VERSION(&sysWMInfo.version);
+			SDL_GetWindowWMInfo(m_pWindow, &sysWMInfo);
+			swapChainDesc.OutputWindow = sysWMInfo.info.win.window;
+
+			//Creat Swapchain
+			result = pDxgiFactory->CreateSwapChain(m_pDevice, &swapChainDesc, &m_pSwapChain);
+			if (FAILED(result))
+				return result;
+		}
 
 
 
@@ -180,8 +243,18 @@ namespace dae {
 		//4. Create RenderTarget (RT) & RenderTargetView (RTV)
 		//=====
 
-		//Resource
-		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
+		//Resource, an offscreen texture in the back buffer's format without a swapchain
+		if (m_pSwapChain)
+		{
+			result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
+		}
+		else
+		{
+			D3D11_TEXTURE2D_DESC renderTargetDesc{ depthStencilDesc };
+			renderTargetDesc.Format = swapChainDesc.BufferDesc.Format;
+			renderTargetDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+			result = m_pDevice->CreateTexture2D(&renderTargetDesc, nullptr, &m_pRenderTargetBuffer);
+		}
 		if (FAILED(result))
 			return result;
 
@@ -270,14 +343,13 @@ namespace dae {
 	{
 		//Instantiate the scene
 		Scene* scene = new Scene(Camera({ 0.f, 0.f, -50.f }, 45.f, m_Width / (float)m_Height));
+		scene->SetScreenHeight(static_cast<float>(m_Height));
 
 		//Create data for our mesh
-		std::vector<Vertex_PosTex> vertices{};
-		std::vector<uint32_t> indices{};
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
+		const MeshCache vehicle{ "Resources/vehicle.obj" };
 
 		//Add mesh to the scene
-		m_pMeshRotating = new Mesh(m_pDevice, L"Resources/PosTex3D.fx", vertices, indices);
+		m_pMeshRotating = CreateMesh(L"Resources/PosTex3D.fx", vehicle);
 		m_pMeshRotating->SetDiffuseTexture(new Texture(m_pDevice, "Resources/vehicle_diffuse.png"));
 
 		scene->AddMesh(m_pMeshRotating);
@@ -289,18 +361,24 @@ namespace dae {
 	{
 		//Instantiate the scene
 		Scene* scene = new Scene(Camera({ 0.f, 0.f, -50.f }, 45.f, m_Width / (float)m_Height));
+		scene->SetScreenHeight(static_cast<float>(m_Height));
 
 		//Create data for our mesh
-		std::vector<Vertex_PosTex> vertices{};
-		std::vector<uint32_t> indices{};
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
-
-		//Add mesh to the scene
-		m_pMeshRotating = new Mesh(m_pDevice, L"Resources/PosTex3D.fx", vertices, indices);
-		m_pMeshRotating->SetDiffuseTexture(new Texture(m_pDevice, "Resources/vehicle_diffuse.png"));
-		m_pMeshRotating->SetNormalTexture(new Texture(m_pDevice, "Resources/vehicle_normal.png"));
-		m_pMeshRotating->SetSpecularTexture(new Texture(m_pDevice, "Resources/vehicle_specular.png"));
-		m_pMeshRotating->SetGlossinessTexture(new Texture(m_pDevice, "Resources/vehicle_gloss.png"));
+		const MeshCache vehicle{ "Resources/vehicle.obj" };
+
+		//Add mesh to the scene, its textures stream in from their mip tails
+		m_pMeshRotating = CreateMesh(L"Resources/PosTex3D.fx", vehicle);
+		scene->EnableTextureStreaming(m_pDevice, m_TextureBudget);
+		//The gloss map goes into the alpha of the specular map, or is loaded on its own when it can't be packed
+		const std::vector<Texture*> textures = TextureLoader::CreateTextures(m_pDevice, {
+			{ "Resources/vehicle_diffuse.png", TextureUsage::Color },
+			{ "Resources/vehicle_normal.png", TextureUsage::Normal },
+			{ "Resources/vehicle_specular.png", TextureUsage::Data, "Resources/vehicle_gloss.png" } }, scene->GetTextureStreamer());
+		m_pMeshRotating->SetDiffuseTexture(textures[0]);
+		m_pMeshRotating->SetNormalTexture(textures[1]);
+		m_pMeshRotating->SetSpecularTexture(textures[2]);
+		if (!textures[2]->HasPackedAlpha())
+			m_pMeshRotating->SetGlossinessTexture(TextureLoader::CreateTextures(m_pDevice, { { "Resources/vehicle_gloss.png", TextureUsage::Data } }, scene->GetTextureStreamer())[0]);
 
 		scene->AddMesh(m_pMeshRotating);
 
@@ -311,34 +389,112 @@ namespace dae {
 	{
 		//Instantiate the scene
 		Scene* scene = new Scene(Camera({ 0.f, 0.f, -50.f }, 45.f, m_Width / (float)m_Height));
+		scene->SetScreenHeight(static_cast<float>(m_Height));
 
 		
+		//Load the textures of both meshes together, the images are decoded side by side and stream in from their mip tails
+		//The gloss map goes into the alpha of the specular map, or is loaded on its own when it can't be packed
+		scene->EnableTextureStreaming(m_pDevice, m_TextureBudget);
+		const std::vector<Texture*> textures = TextureLoader::CreateTextures(m_pDevice, {
+			{ "Resources/vehicle_diffuse.png", TextureUsage::Color },
+			{ "Resources/vehicle_normal.png", TextureUsage::Normal },
+			{ "Resources/vehicle_specular.png", TextureUsage::Data, "Resources/vehicle_gloss.png" },
+			{ "Resources/fireFX_diffuse.png", TextureUsage::Color } }, scene->GetTextureStreamer());
+
+
 		//Create data for our vehicle mesh
-		std::vector<Vertex_PosTex> vertices{};
-		std::vector<uint32_t> indices{};
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
+		const MeshCache vehicle{ "Resources/vehicle.obj" };
 
 		//Add vehicle mesh to the scene
-		Mesh* pMesh = new Mesh(m_pDevice, L"Resources/PosTex3D.fx", vertices, indices);
-		pMesh->SetDiffuseTexture(new Texture(m_pDevice, "Resources/vehicle_diffuse.png"));
-		pMesh->SetNormalTexture(new Texture(m_pDevice, "Resources/vehicle_normal.png"));
-		pMesh->SetSpecularTexture(new Texture(m_pDevice, "Resources/vehicle_specular.png"));
-		pMesh->SetGlossinessTexture(new Texture(m_pDevice, "Resources/vehicle_gloss.png"));
+		Mesh* pMesh = CreateMesh(L"Resources/PosTex3D.fx", vehicle);
+		pMesh->SetDiffuseTexture(textures[0]);
+		pMesh->SetNormalTexture(textures[1]);
+		pMesh->SetSpecularTexture(textures[2]);
+		if (!textures[2]->HasPackedAlpha())
+			pMesh->SetGlossinessTexture(TextureLoader::CreateTextures(m_pDevice, { { "Resources/vehicle_gloss.png", TextureUsage::Data } }, scene->GetTextureStreamer())[0]);
 
 		scene->AddMesh(pMesh);
 
 
 		//Create data for our fire mesh
-		Utils::ParseOBJ("Resources/fireFX.obj", vertices, indices);
+		const MeshCache fire{ "Resources/fireFX.obj" };
 
 		//Add mesh to the scene
-		pMesh = new Mesh(m_pDevice, L"Resources/PosDiffuse3D.fx", vertices, indices);
-		pMesh->SetDiffuseTexture(new Texture(m_pDevice, "Resources/fireFX_diffuse.png"));
+		pMesh = CreateMesh(L"Resources/PosDiffuse3D.fx", fire);
+		pMesh->SetBackfaceCulling(false); //The fire effect is drawn double sided
+		pMesh->SetDiffuseTexture(textures[3]);
 
 		scene->AddMesh(pMesh);
 
 
 		return scene;
 	}
+
+	Scene* Renderer::Scene_6(bool useBatching, bool useAtlases)
+	{
+		//Instantiate the scene, looking along the grid so the sides of the nearest rows and the farthest rows fall outside the frustum
+		Scene* scene = new Scene(Camera({ 0.f, 10.f, -30.f }, 45.f, m_Width / (float)m_Height));
+
+		//Create data for our meshes
+		const MeshCache vehicle{ "Resources/vehicle.obj" };
+		const MeshCache fire{ "Resources/fireFX.obj" };
+
+		Material vehicleMaterial{};
+		vehicleMaterial.effectFile = L"Resources/PosTex3D.fx";
+		vehicleMaterial.diffuseMap = "Resources/vehicle_diffuse.png";
+		vehicleMaterial.normalMap = "Resources/vehicle_normal.png";
+		vehicleMaterial.specularMap = "Resources/vehicle_specular.png";
+		vehicleMaterial.glossMap = "Resources/vehicle_gloss.png";
+
+		//Half of the vehicles are painted with the uv grid, only an atlas lets them share a batch with the others
+		Material gridMaterial{ vehicleMaterial };
+		gridMaterial.diffuseMap = "Resources/uv_grid_2.png";
+
+		Material fireMaterial{};
+		fireMaterial.effectFile = L"Resources/PosDiffuse3D.fx";
+		fireMaterial.diffuseMap = "Resources/fireFX_diffuse.png";
+		fireMaterial.cullBackfaces = false; //The fire effect is drawn double sided
+
+		//Add a grid of small static props to the scene, every one is turned a bit further than the last
+		constexpr int gridSize{ 8 };
+		constexpr float spacing{ 12.f };
+		const Vector3 scale{ 0.25f, 0.25f, 0.25f };
+		for (int row = 0; row < gridSize; ++row)
+		{
+			for (int column = 0; column < gridSize; ++column)
+			{
+				const Vector3 position{ (column - gridSize / 2) * spacing, 0.f, row * spacing };
+				const Vector3 rotation{ 0.f, (row * gridSize + column) * 0.3f, 0.f };
+				scene->AddStaticMesh(vehicle, (row + column) % 2 == 0 ? vehicleMaterial : gridMaterial, position, rotation, scale);
+				scene->AddStaticMesh(fire, fireMaterial, position, rotation, scale);
+			}
+		}
+		scene->BuildStaticMeshes(m_pDevice, useBatching, useAtlases);
+
+		return scene;
+	}
+
+	Mesh* Renderer::CreateMesh(const std::wstring& assetFile, const MeshCache& meshCache) const
+	{
+		Mesh* pMesh{};
+		if (m_UsePackedVertices)
+		{
+			std::vector<Vertex_PosTexPacked> packed{};
+			VertexPacking::PackVertices(meshCache.GetVertices(), meshCache.GetNumVertices(), meshCache.GetBoundsMin(), meshCache.GetBoundsMax(), packed);
+			pMesh = new Mesh(m_pDevice, assetFile, packed.data(), meshCache.GetNumVertices(), meshCache.GetIndices(), meshCache.GetNumIndices(), meshCache.GetBoundsMin(), meshCache.GetBoundsMax());
+		}
+		else
+		{
+			pMesh = new Mesh(m_pDevice, assetFile, meshCache.GetVertices(), meshCache.GetNumVertices(), meshCache.GetIndices(), meshCache.GetNumIndices());
+		}
+
+		pMesh->SetLODs(meshCache.GetLODs(), meshCache.GetNumLODs(), meshCache.GetBoundsMin(), meshCache.GetBoundsMax());
+		pMesh->SetMeshlets(meshCache.GetMeshlets(), meshCache.GetNumMeshlets());
+		if (meshCache.GetNumMaterials() > 0)
+			pMesh->SetMaterials(m_pDevice, meshCache.GetMaterials(), meshCache.GetNumMaterials(), meshCache.GetSubmeshes());
+
+		std::cout << "Vertex buffer: " << pMesh->GetVertexBufferSize() / 1024 << " KB (" << meshCache.GetNumVertices() << " vertices)\n";
+		return pMesh;
+	}
 #pragma endregion
 }
@@ -7,11 +7,13 @@ namespace dae
 {
 	class Scene;
 	class Mesh;
+	class MeshCache;
 
 	class Renderer final
 	{
 	public:
 		Renderer(SDL_Window* pWindow);
+		Renderer(int width, int height); //Headless, renders into an offscreen target on the software rasterizer
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -23,6 +25,10 @@ namespace dae
 		void Render() const;
 
 		void ToggleSamplerStates() const;
+		void ToggleVertexFormat();
+
+		//Renders one frame of the static mesh scene with and without batching and prints what was submitted
+		void RunStaticBatchingTest();
 
 	private:
 		SDL_Window* m_pWindow{};
@@ -35,6 +41,9 @@ namespace dae
 		Scene* m_pScene{};
 		Mesh* m_pMeshRotating{};
 
+		bool m_UsePackedVertices{ false };
+		size_t m_TextureBudget{ 32 * 1024 * 1024 }; //Bytes of texture memory the streaming scenes keep resident
+
 		//DIRECTX
 		HRESULT InitializeDirectX(IDXGIFactory1*& pDxgiFactory);
 
@@ -55,5 +64,8 @@ namespace dae
 		Scene* Scene_3(); //vehicle mesh with diffuse texture
 		Scene* Scene_4(); //vehicle mesh with all textures and shading
 		Scene* Scene_5(); //vehicle mesh and fire mesh
+		Scene* Scene_6(bool useBatching, bool useAtlases = false); //grid of static vehicle and fire meshes
+
+		Mesh* CreateMesh(const std::wstring& assetFile, const MeshCache& meshCache) const;
 	};
 }
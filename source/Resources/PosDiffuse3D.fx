@@ -2,6 +2,8 @@
 // Global Variables
 //---------------------------------------------------
 float4x4 gWorldViewProj : WorldViewProjection;
+float3 gPositionScale = float3(1.f, 1.f, 1.f);
+float3 gPositionOffset = float3(0.f, 0.f, 0.f);
 Texture2D gDiffuseMap : DiffuseMap;
 
 RasterizerState gRasterizerState
@@ -58,7 +60,15 @@ struct VS_INPUT
 {
 	float3 Position : POSITION;
 	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Tangent : TANGENT; //w is the bitangent sign
+	float2 TextureUV : TEXCOORD;
+};
+
+struct VS_INPUT_PACKED
+{
+	float4 Position : POSITION;
+	float2 Normal : NORMAL;
+	float2 Tangent : TANGENT;
 	float2 TextureUV : TEXCOORD;
 };
 
@@ -79,6 +89,24 @@ VS_OUTPUT VS(VS_INPUT input)
 	return output;
 }
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-direction.z);
+	direction.xy += direction.xy >= 0.f ? -t : t;
+	return normalize(direction);
+}
+
+VS_OUTPUT VS_PACKED(VS_INPUT_PACKED input)
+{
+	VS_INPUT unpacked = (VS_INPUT)0;
+	unpacked.Position = input.Position.xyz * gPositionScale + gPositionOffset;
+	unpacked.Normal = DecodeOctahedral(input.Normal);
+	unpacked.Tangent = float4(DecodeOctahedral(input.Tangent), input.Position.w * 2.f - 1.f);
+	unpacked.TextureUV = input.TextureUV;
+	return VS(unpacked);
+}
+
 //---------------------------------------------------
 // Pixel Shader
 //---------------------------------------------------
@@ -137,4 +165,43 @@ technique11 AnisotropicTechnique
 		SetGeometryShader(NULL);
 		SetPixelShader(CompileShader(ps_5_0, PS_ANI()));
 	}
-}
\ No newline at end of file
+}
+
+technique11 PackedDefaultTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_PACKED()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+technique11 PackedLinearTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_PACKED()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS_LIN()));
+	}
+}
+
+technique11 PackedAnisotropicTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_PACKED()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS_ANI()));
+	}
+}
@@ -7,6 +7,8 @@ float gShininess = 25.f;
 float3 gLightDirection = float3(0.577f, -0.577f, 0.577f);
 
 float4x4 gWorldViewProj : WorldViewProjection;
+float3 gPositionScale = float3(1.f, 1.f, 1.f);
+float3 gPositionOffset = float3(0.f, 0.f, 0.f);
 float4x4 gWorld : World;
 float4x4 gInvView : InverseView;
 
@@ -14,6 +16,7 @@ Texture2D gDiffuseMap : DiffuseMap;
 Texture2D gNormalMap : NormalMap;
 Texture2D gSpecularMap : SpecularMap;
 Texture2D gGlossMap : GlossinessMap;
+bool gGlossInSpecularAlpha = false; //The gloss map is packed into the alpha of the specular map
 
 RasterizerState gRasterizerState {};
 BlendState gBlendState {};
@@ -47,7 +50,15 @@ struct VS_INPUT
 {
 	float3 Position : POSITION;
 	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Tangent : TANGENT; //w is the bitangent sign
+	float2 TextureUV : TEXCOORD;
+};
+
+struct VS_INPUT_PACKED
+{
+	float4 Position : POSITION;
+	float2 Normal : NORMAL;
+	float2 Tangent : TANGENT;
 	float2 TextureUV : TEXCOORD;
 };
 
@@ -56,7 +67,7 @@ struct VS_OUTPUT
 	float4 Position : SV_POSITION;
 	float4 WorldPosition : COLOR;
 	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Tangent : TANGENT;
 	float2 TextureUV : TEXCOORD;
 };
 
@@ -69,11 +80,29 @@ VS_OUTPUT VS(VS_INPUT input)
 	output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
 	output.WorldPosition = mul(float4(input.Position, 1.f), gWorld);
 	output.Normal = mul(normalize(input.Normal), (float3x3)gWorld);
-	output.Tangent = mul(normalize(input.Tangent), (float3x3)gWorld);
+	output.Tangent = float4(mul(normalize(input.Tangent.xyz), (float3x3)gWorld), input.Tangent.w);
 	output.TextureUV = input.TextureUV;
 	return output;
 }
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-direction.z);
+	direction.xy += direction.xy >= 0.f ? -t : t;
+	return normalize(direction);
+}
+
+VS_OUTPUT VS_PACKED(VS_INPUT_PACKED input)
+{
+	VS_INPUT unpacked = (VS_INPUT)0;
+	unpacked.Position = input.Position.xyz * gPositionScale + gPositionOffset;
+	unpacked.Normal = DecodeOctahedral(input.Normal);
+	unpacked.Tangent = float4(DecodeOctahedral(input.Tangent), input.Position.w * 2.f - 1.f);
+	unpacked.TextureUV = input.TextureUV;
+	return VS(unpacked);
+}
+
 //---------------------------------------------------
 // BRDF
 //---------------------------------------------------
@@ -104,10 +133,12 @@ float3 Shading(VS_OUTPUT input, SamplerState sam)
 	float3 viewDirection = normalize(float3(input.WorldPosition.xyz) - float3(gInvView[3].xyz));
 
 	//normal map
-	float3 binormal = cross(input.Normal, input.Tangent);
-	float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent, 0.f), float4(binormal, 0.f), float4(input.Normal, 0.f), float4(0.f, 0.f, 0.f, 1.f));
+	float3 binormal = cross(input.Normal, input.Tangent.xyz) * input.Tangent.w;
+	float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent.xyz, 0.f), float4(binormal, 0.f), float4(input.Normal, 0.f), float4(0.f, 0.f, 0.f, 1.f));
+	//z is rebuilt from x and y, so BC5 normal maps that only store those two work too
 	float4 sampledColor = gNormalMap.Sample(sam, input.TextureUV);
-	float3 partialColor = 2.f * sampledColor.rgb - float3(1.f, 1.f, 1.f);
+	float3 partialColor = float3(2.f * sampledColor.rg - float2(1.f, 1.f), 0.f);
+	partialColor.z = sqrt(saturate(1.f - dot(partialColor.xy, partialColor.xy)));
 	float3 normalResult = mul(float4(partialColor, 0.0f), tangentSpaceAxis);
 
 	//Observed area (lambert cosine law)
@@ -116,10 +147,16 @@ float3 Shading(VS_OUTPUT input, SamplerState sam)
 	//Sampled Textures
 	float4 sampledDiffuse = gDiffuseMap.Sample(sam, input.TextureUV);
 	float4 sampledSpecular = gSpecularMap.Sample(sam, input.TextureUV);
-	float4 sampledGlossiness = gGlossMap.Sample(sam, input.TextureUV);
+
+	//A packed gloss map skips its own fetch, the gradients are taken outside the branch
+	float glossiness = sampledSpecular.a;
+	float2 uvDdx = ddx(input.TextureUV);
+	float2 uvDdy = ddy(input.TextureUV);
+	[branch] if (!gGlossInSpecularAlpha)
+		glossiness = gGlossMap.SampleGrad(sam, input.TextureUV, uvDdx, uvDdy).r;
 
 	finalColor += Lambert(gLightIntensity, sampledDiffuse.rgb) * dotProduct;
-	finalColor += Phong(sampledSpecular.rgb, gShininess * sampledGlossiness.r, -gLightDirection, viewDirection, normalResult) * dotProduct;
+	finalColor += Phong(sampledSpecular.rgb, gShininess * glossiness, -gLightDirection, viewDirection, normalResult) * dotProduct;
 
 	return finalColor;
 }
@@ -182,4 +219,43 @@ technique11 AnisotropicTechnique
 		SetGeometryShader(NULL);
 		SetPixelShader(CompileShader(ps_5_0, PS_ANI()));
 	}
-}
\ No newline at end of file
+}
+
+technique11 PackedDefaultTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_PACKED()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+technique11 PackedLinearTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_PACKED()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS_LIN()));
+	}
+}
+
+technique11 PackedAnisotropicTechnique
+{
+	pass P0
+	{
+		SetRasterizerState(gRasterizerState);
+		SetDepthStencilState(gDepthStencilState, 0);
+		SetBlendState(gBlendState, float4(0.f, 0.f, 0.f, 0.f), 0xFFFFFFFF);
+		SetVertexShader(CompileShader(vs_5_0, VS_PACKED()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS_ANI()));
+	}
+}
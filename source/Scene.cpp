@@ -6,10 +6,61 @@
 #include "Camera.h"
 #include "Mesh.h"
 #include "Effect.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include "MeshCache.h"
+#include "StaticBatching.h"
+#include "TextureAtlas.h"
+#include "Parallel.h"
+#include <chrono>
+#include <iomanip>
+#include <map>
 
 using namespace dae;
 
 
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Meant for props that are small on screen, larger maps lose their finest levels to fit in a tile
+	constexpr uint32_t AtlasSize{ 2048 };
+	constexpr uint32_t MaxTileSize{ 512 };
+	constexpr uint32_t AtlasPadding{ 4 };
+	constexpr uint32_t AtlasLevels{ 5 }; //Down to 32x32 for a tile of the largest size, the gutters grow with the levels
+
+	//The maps of a material are decoded together, a gloss map next to a specular map is packed into its alpha
+	std::vector<TextureLoader::Request> GetTextureRequests(const Material& material)
+	{
+		const bool isGlossPacked = !material.specularMap.empty() && !material.glossMap.empty();
+		std::vector<TextureLoader::Request> requests{};
+		if (!material.diffuseMap.empty())
+			requests.push_back({ material.diffuseMap, TextureUsage::Color });
+		if (!material.normalMap.empty())
+			requests.push_back({ material.normalMap, TextureUsage::Normal });
+		if (!material.specularMap.empty())
+			requests.push_back({ material.specularMap, TextureUsage::Data, isGlossPacked ? material.glossMap : std::string{} });
+		if (!material.glossMap.empty() && !isGlossPacked)
+			requests.push_back({ material.glossMap, TextureUsage::Data });
+		return requests;
+	}
+
+	//Materials that can share an atlas, the same effect and culling with the same maps in use
+	Material GetAtlasKey(const Material& material, const std::string& mapName)
+	{
+		Material key{ material };
+		for (std::string* pMap : { &key.diffuseMap, &key.normalMap, &key.specularMap, &key.glossMap })
+		{
+			if (!pMap->empty())
+				*pMap = mapName;
+		}
+		return key;
+	}
+}
+
+
 //-----------------------------------------------------------------
 // Constructors
 //-----------------------------------------------------------------
@@ -36,6 +87,9 @@ Scene::~Scene()
 		delete pMesh;
 	}
 	m_Meshes.clear();
+
+	//After the meshes, their textures unregister themselves
+	delete m_pTextureStreamer;
 }
 
 
@@ -47,27 +101,39 @@ void Scene::Update(const Timer* pTimer)
 	//Update camera first since we need to retrieve data from it
 	m_pCamera->Update(pTimer);
 
-	//Calculate the WorldViewProjection matrix
-	Matrix worldViewProj = m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix();
+	UpdateMeshes();
+}
+
+void Scene::UpdateMeshes()
+{
+	//Calculate the ViewProjection matrix
+	const Matrix viewProj = m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix();
 	Matrix invView = m_pCamera->GetInverseViewMatrix();
 
 	//Update effects for all meshes
 	for (Mesh* pMesh : m_Meshes)
 	{
 		Matrix world = pMesh->GetWorldMatrix();
-		worldViewProj = world * worldViewProj;
+		Matrix worldViewProj = world * viewProj;
 
 		pMesh->GetEffect()->SetWorldViewProjectionMatrix(worldViewProj);
 		pMesh->GetEffect()->SetWorldMatrix(world);
 		pMesh->GetEffect()->SetInverseViewMatrix(invView);
+
+		if (m_ScreenHeight > 0.f)
+			pMesh->SelectLOD(invView.GetTranslation(), m_pCamera->GetProjectionMatrix(), m_ScreenHeight);
+		pMesh->CullMeshlets(m_pCamera->GetViewMatrix(), m_pCamera->GetProjectionMatrix());
 	}
+
+	StreamTextures();
 }
 
 void Scene::Render(ID3D11DeviceContext* pDeviceContext)
 {
+	m_RenderStatistics = RenderStatistics{};
 	for (Mesh* pMesh : m_Meshes)
 	{
-		pMesh->Render(pDeviceContext);
+		pMesh->Render(pDeviceContext, m_RenderStatistics);
 	}
 }
 
@@ -79,13 +145,320 @@ void Scene::ToggleSamplerState() const
 	}
 }
 
+void Scene::EnableTextureStreaming(ID3D11Device* pDevice, size_t budget)
+{
+	m_pDevice = pDevice;
+	if (m_pTextureStreamer)
+		m_pTextureStreamer->SetBudget(budget);
+	else
+		m_pTextureStreamer = new TextureStreamer(budget);
+}
+
 void Scene::AddMesh(Mesh* pMesh)
 {
 	m_Meshes.emplace_back(pMesh);
 }
 
+void Scene::AddStaticMesh(const MeshCache& meshCache, const Material& material, const Vector3& position, const Vector3& rotation, const Vector3& scale)
+{
+	//The meshlets always belong to the first level, which is at the start of the index buffer
+	const uint32_t numIndices = meshCache.GetNumLODs() > 0 ? meshCache.GetLODs()[0].numIndices : meshCache.GetNumIndices();
+
+	StaticMesh& staticMesh = m_StaticMeshes.emplace_back();
+	staticMesh.material = material;
+	staticMesh.vertices.assign(meshCache.GetVertices(), meshCache.GetVertices() + meshCache.GetNumVertices());
+	staticMesh.indices.assign(meshCache.GetIndices(), meshCache.GetIndices() + numIndices);
+	staticMesh.meshlets.assign(meshCache.GetMeshlets(), meshCache.GetMeshlets() + meshCache.GetNumMeshlets());
+	staticMesh.position = position;
+	staticMesh.rotation = rotation;
+	staticMesh.scale = scale;
+}
+
+void Scene::BuildStaticMeshes(ID3D11Device* pDevice, bool useBatching, bool useAtlases)
+{
+	if (!useBatching)
+	{
+		for (const StaticMesh& staticMesh : m_StaticMeshes)
+		{
+			Mesh* pMesh = new Mesh(pDevice, staticMesh.material.effectFile, staticMesh.vertices, staticMesh.indices);
+			pMesh->SetPosition(staticMesh.position.x, staticMesh.position.y, staticMesh.position.z);
+			pMesh->SetRotation(staticMesh.rotation.x, staticMesh.rotation.y, staticMesh.rotation.z);
+			pMesh->SetScale(staticMesh.scale);
+			pMesh->SetMeshlets(staticMesh.meshlets.data(), static_cast<uint32_t>(staticMesh.meshlets.size()));
+			ApplyMaterial(pDevice, pMesh, staticMesh.material);
+
+			AddMesh(pMesh);
+		}
+		m_StaticMeshes.clear();
+		return;
+	}
+
+	//Meshes that moved into an atlas share its material from here on
+	std::map<Material, std::vector<TextureLoader::LoadedTexture>> atlases{};
+	if (useAtlases)
+		BuildTextureAtlases(atlases);
+
+	//Group by material, the batches are built in material order so meshes with the same effect end up next to each other
+	std::map<Material, std::vector<StaticBatching::Instance>> batches{};
+	for (const StaticMesh& staticMesh : m_StaticMeshes)
+	{
+		StaticBatching::Instance instance{};
+		instance.pVertices = staticMesh.vertices.data();
+		instance.numVertices = static_cast<uint32_t>(staticMesh.vertices.size());
+		instance.pIndices = staticMesh.indices.data();
+		instance.numIndices = static_cast<uint32_t>(staticMesh.indices.size());
+		instance.pMeshlets = staticMesh.meshlets.data();
+		instance.numMeshlets = static_cast<uint32_t>(staticMesh.meshlets.size());
+		instance.world = Matrix::CreateTransform(staticMesh.position, staticMesh.rotation, staticMesh.scale);
+
+		batches[staticMesh.material].emplace_back(instance);
+	}
+
+	for (const auto& [material, instances] : batches)
+	{
+		StaticBatching::Batch batch{};
+		StaticBatching::Merge(instances.data(), static_cast<uint32_t>(instances.size()), batch);
+
+		Mesh* pMesh = new Mesh(pDevice, material.effectFile, batch.vertices, batch.indices);
+		pMesh->SetMeshlets(batch.meshlets.data(), static_cast<uint32_t>(batch.meshlets.size()));
+		const auto atlas = atlases.find(material);
+		ApplyMaterial(pDevice, pMesh, material, atlas != atlases.end() ? &atlas->second : nullptr);
+
+		AddMesh(pMesh);
+	}
+	m_StaticMeshes.clear();
+}
+
 
 //-----------------------------------------------------------------
 // Private Member Functions
 //-----------------------------------------------------------------
+void Scene::ApplyMaterial(ID3D11Device* pDevice, Mesh* pMesh, const Material& material, const std::vector<TextureLoader::LoadedTexture>* pAtlases) const
+{
+	pMesh->SetBackfaceCulling(material.cullBackfaces);
+
+	const std::vector<TextureLoader::Request> requests = GetTextureRequests(material);
+	if (requests.empty())
+		return;
 
+	std::vector<Texture*> textures{};
+	if (pAtlases)
+	{
+		for (const TextureLoader::LoadedTexture& atlas : *pAtlases)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			textures.push_back(new Texture(pDevice, atlas));
+			TextureLoader::Report(atlas, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+	}
+	else
+		textures = TextureLoader::CreateTextures(pDevice, requests);
+
+	const bool isGlossPacked = !material.specularMap.empty() && !material.glossMap.empty();
+	size_t index{};
+	if (!material.diffuseMap.empty())
+		pMesh->SetDiffuseTexture(textures[index++]);
+	if (!material.normalMap.empty())
+		pMesh->SetNormalTexture(textures[index++]);
+	if (!material.specularMap.empty())
+		pMesh->SetSpecularTexture(textures[index++]);
+	if (!material.glossMap.empty() && !isGlossPacked)
+		pMesh->SetGlossinessTexture(textures[index++]);
+
+	//A gloss map that couldn't be packed, like one of another size than the specular map, is loaded as a map of its own
+	if (isGlossPacked && !textures[index - 1]->HasPackedAlpha())
+		pMesh->SetGlossinessTexture(TextureLoader::CreateTextures(pDevice, { { material.glossMap, TextureUsage::Data } })[0]);
+}
+
+void Scene::BuildTextureAtlases(std::map<Material, std::vector<TextureLoader::LoadedTexture>>& atlases)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	//Uvs outside [0, 1] repeat the texture, a material with a mesh like that keeps its own maps
+	std::map<Material, bool> isPlaceable{};
+	for (const StaticMesh& staticMesh : m_StaticMeshes)
+	{
+		const bool hasUnitUVs = TextureAtlas::HasUnitUVs(staticMesh.vertices.data(), static_cast<uint32_t>(staticMesh.vertices.size()));
+		const auto [it, isInserted] = isPlaceable.try_emplace(staticMesh.material, hasUnitUVs);
+		it->second = it->second && hasUnitUVs;
+	}
+
+	//Only groups of several materials gain anything from an atlas
+	std::map<Material, std::vector<Material>> groups{};
+	for (const auto& [material, isMaterialPlaceable] : isPlaceable)
+	{
+		if (isMaterialPlaceable && !GetTextureRequests(material).empty())
+			groups[GetAtlasKey(material, "Atlas")].push_back(material);
+	}
+	std::erase_if(groups, [](const auto& group) { return group.second.size() < 2; });
+	if (groups.empty())
+		return;
+
+	uint32_t numMaterials{}, numAtlases{};
+	uint64_t numTileTexels{}, numAtlasTexels{};
+	for (const auto& [key, materials] : groups)
+	{
+		//Every map of every material of the group, decoded to RGBA8 with their mips
+		std::vector<TextureLoader::Request> requests{};
+		for (const Material& material : materials)
+		{
+			const std::vector<TextureLoader::Request> materialRequests = GetTextureRequests(material);
+			requests.insert(requests.end(), materialRequests.begin(), materialRequests.end());
+		}
+		const size_t numMaps = requests.size() / materials.size();
+
+		std::vector<TextureData> images(requests.size());
+		std::vector<char> isDecoded(requests.size());
+		TextureLoader::Initialize();	//Before any of the workers decodes an image
+		ParallelFor(requests.size(), [&](size_t begin, size_t end, uint32_t)
+			{
+				for (size_t request = begin; request < end; ++request)
+				{
+					isDecoded[request] = TextureLoader::DecodeImage(requests[request], images[request], 1);
+				}
+			});
+
+		//A tile per material, at the first level of its maps that is small enough, all of its maps need the same size
+		std::vector<TextureAtlas::Tile> tiles(materials.size());
+		for (size_t material = 0; material < materials.size(); ++material)
+		{
+			const TextureData& first = images[material * numMaps];
+			if (!isDecoded[material * numMaps])
+				continue;
+
+			uint32_t level{};
+			while (level + 1 < first.levels.size() && std::max(first.levels[level].width, first.levels[level].height) > MaxTileSize)
+			{
+				++level;
+			}
+
+			bool isTileable{ true };
+			for (size_t map = 0; map < numMaps; ++map)
+			{
+				const TextureData& image = images[material * numMaps + map];
+				isTileable = isTileable && isDecoded[material * numMaps + map] && TextureAtlas::CanPlace(image, level, AtlasLevels)
+					&& image.levels[0].width == first.levels[0].width && image.levels[0].height == first.levels[0].height;
+			}
+			if (isTileable)
+			{
+				tiles[material].width = first.levels[level].width;
+				tiles[material].height = first.levels[level].height;
+			}
+		}
+
+		//The smallest atlas that takes every tile, up to the largest size, which may take several
+		//Its size doesn't need to be a power of two, only its tiles need to be aligned
+		uint32_t atlasSize{ AtlasSize };
+		uint32_t numGroupAtlases{};
+		for (uint32_t size = MaxTileSize; size <= AtlasSize; size += MaxTileSize / 2)
+		{
+			atlasSize = size;
+			numGroupAtlases = TextureAtlas::Pack(tiles.data(), static_cast<uint32_t>(tiles.size()), atlasSize, AtlasPadding, AtlasLevels);
+			const bool isEverythingPacked = std::none_of(tiles.begin(), tiles.end(), [](const TextureAtlas::Tile& tile)
+				{
+					return tile.width > 0 && tile.atlas == TextureAtlas::NotPacked;
+				});
+			if (numGroupAtlases <= 1 && isEverythingPacked)
+				break;
+		}
+
+		//Every map gets an atlas of its own with the same layout, so one set of uvs fits all of them
+		std::vector<Material> atlasMaterials{};
+		std::vector<const TextureData*> pImages(materials.size());
+		for (uint32_t atlas = 0; atlas < numGroupAtlases; ++atlas)
+		{
+			const std::string atlasName = "Atlas " + std::to_string(numAtlases + atlas);
+			const size_t numAtlasTiles = std::count_if(tiles.begin(), tiles.end(), [&](const TextureAtlas::Tile& tile) { return tile.atlas == atlas; });
+			atlasMaterials.push_back(GetAtlasKey(key, atlasName));
+
+			std::vector<TextureLoader::LoadedTexture>& atlasTextures = atlases[atlasMaterials.back()];
+			for (size_t map = 0; map < numMaps; ++map)
+			{
+				for (size_t material = 0; material < materials.size(); ++material)
+				{
+					pImages[material] = &images[material * numMaps + map];
+				}
+
+				TextureLoader::LoadedTexture& atlasTexture = atlasTextures.emplace_back();
+				atlasTexture.source = atlasName + " of " + std::to_string(numAtlasTiles) + " materials like " + requests[map].path + " (built)";
+				atlasTexture.hasPackedAlpha = !requests[map].alphaPath.empty();
+				TextureAtlas::Build(pImages.data(), tiles.data(), static_cast<uint32_t>(tiles.size()), atlas, atlasSize, AtlasPadding, AtlasLevels, atlasTexture.image);
+			}
+		}
+
+		for (StaticMesh& staticMesh : m_StaticMeshes)
+		{
+			const auto material = std::find(materials.begin(), materials.end(), staticMesh.material);
+			if (material == materials.end() || tiles[material - materials.begin()].atlas == TextureAtlas::NotPacked)
+				continue;
+
+			const TextureAtlas::Tile& tile = tiles[material - materials.begin()];
+			TextureAtlas::RemapUVs(staticMesh.vertices.data(), static_cast<uint32_t>(staticMesh.vertices.size()), tile, atlasSize);
+			staticMesh.material = atlasMaterials[tile.atlas];
+		}
+
+		for (const TextureAtlas::Tile& tile : tiles)
+		{
+			if (tile.atlas == TextureAtlas::NotPacked)
+				continue;
+
+			numTileTexels += static_cast<uint64_t>(tile.width) * tile.height;
+			++numMaterials;
+		}
+		numAtlases += numGroupAtlases;
+		numAtlasTexels += static_cast<uint64_t>(atlasSize) * atlasSize * numGroupAtlases;
+	}
+
+	const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	const std::streamsize precision = std::cout.precision();
+	std::cout << "Texture atlases: " << numMaterials << " materials in " << numAtlases << " atlases, " << std::fixed << std::setprecision(1)
+		<< (numAtlasTexels > 0 ? 100.0 * numTileTexels / numAtlasTexels : 0.0) << "% covered by tiles, built in " << std::setprecision(2) << time << " ms\n";
+	std::cout.unsetf(std::ios::fixed);
+	std::cout.precision(precision);
+}
+
+void Scene::StreamTextures()
+{
+	if (!m_pTextureStreamer || m_ScreenHeight <= 0.f)
+		return;
+
+	//Every texture is asked for at the size of the largest mesh drawing it, meshes out of view don't ask
+	const Vector3 cameraPosition = m_pCamera->GetInverseViewMatrix().GetTranslation();
+	const Matrix projection = m_pCamera->GetProjectionMatrix();
+	std::vector<Texture*> textures{};
+	for (Mesh* pMesh : m_Meshes)
+	{
+		const float screenSize = pMesh->GetScreenSize(cameraPosition, projection, m_ScreenHeight);
+		if (screenSize <= 0.f)
+			continue;
+
+		textures.clear();
+		pMesh->GetTextures(textures);
+		for (Texture* pTexture : textures)
+		{
+			if (!pTexture->IsStreamed())
+				continue;
+
+			const uint32_t id = pTexture->GetStreamingId();
+			if (id >= m_pStreamedTextures.size())
+				m_pStreamedTextures.resize(id + 1);
+			m_pStreamedTextures[id] = pTexture;
+			m_pTextureStreamer->RequestTexture(id, screenSize);
+		}
+	}
+
+	std::vector<TextureStreamer::Change> changes{};
+	m_pTextureStreamer->Update(changes);
+	if (changes.empty())
+		return;
+
+	//Only textures that were requested can change, so all of them are known
+	for (const TextureStreamer::Change& change : changes)
+	{
+		m_pStreamedTextures[change.texture]->SetFirstLevel(m_pDevice, change.firstLevel);
+	}
+	for (Mesh* pMesh : m_Meshes)
+	{
+		pMesh->RebindTextures();
+	}
+}
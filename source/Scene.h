@@ -1,12 +1,17 @@
 #pragma once
 // Includes
 #include "DataTypes.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "TextureLoader.h"
+#include <map>
 
 namespace dae
 {
 	// Forward Declarations
 	class Camera;
-	class Mesh;
+	class MeshCache;
+	class TextureStreamer;
 	
 	// Class Declaration
 	class Scene final
@@ -27,22 +32,63 @@ namespace dae
 		// Public Member Functions
 		//---------------------------
 		void Update(const Timer* pTimer);
+		void UpdateMeshes(); //Without moving the camera
 		void Render(ID3D11DeviceContext* pDeviceContext);
 
 		void ToggleSamplerState() const;
 
 		void AddMesh(Mesh* pMesh);
+		void SetScreenHeight(float screenHeight) { m_ScreenHeight = screenHeight; }
+
+		//Static meshes never move, their first level of detail is copied until BuildStaticMeshes turns them into meshes
+		void AddStaticMesh(const MeshCache& meshCache, const Material& material, const Vector3& position, const Vector3& rotation = {}, const Vector3& scale = { 1.f, 1.f, 1.f });
+
+		//With batching all static meshes with the same material are merged into one mesh with pre-transformed vertices
+		//Their meshlets are kept so every object can still be culled on its own, without batching each gets a mesh of its own
+		//With atlases the small maps of materials that only differ in their maps are packed together first, so those meshes batch as one
+		void BuildStaticMeshes(ID3D11Device* pDevice, bool useBatching = true, bool useAtlases = false);
+
+		const RenderStatistics& GetRenderStatistics() const { return m_RenderStatistics; }
+
+		//Textures created with the streamer from then on only keep the mips their meshes cover on screen, within budget bytes
+		//Needs the screen height, the streamer is updated with the meshes
+		void EnableTextureStreaming(ID3D11Device* pDevice, size_t budget);
+		TextureStreamer* GetTextureStreamer() const { return m_pTextureStreamer; }
 	
 	
 	private:
 		// Member variables
 		Camera* m_pCamera{};
+		float m_ScreenHeight{}; //Levels of detail are only picked once this is known
 
 		std::vector<Mesh*> m_Meshes{};
+		RenderStatistics m_RenderStatistics{};
+
+		struct StaticMesh
+		{
+			Material material{};
+			std::vector<Vertex_PosTex> vertices{};
+			std::vector<uint32_t> indices{};
+			std::vector<Meshlet> meshlets{};
+			Vector3 position{};
+			Vector3 rotation{};
+			Vector3 scale{};
+		};
+		std::vector<StaticMesh> m_StaticMeshes{};
+
+		ID3D11Device* m_pDevice{};
+		TextureStreamer* m_pTextureStreamer{};
+		std::vector<Texture*> m_pStreamedTextures{}; //By streaming id, filled in as the meshes request them
 	
 		//---------------------------
 		// Private Member Functions
 		//---------------------------
+		//The atlases replace the maps of the material when given, in the order of its texture requests
+		void ApplyMaterial(ID3D11Device* pDevice, Mesh* pMesh, const Material& material, const std::vector<TextureLoader::LoadedTexture>* pAtlases = nullptr) const;
+
+		//Moves the static meshes whose maps went into an atlas over to the material of that atlas and remaps their uvs
+		void BuildTextureAtlases(std::map<Material, std::vector<TextureLoader::LoadedTexture>>& atlases);
+		void StreamTextures();
 	
 	};
 }
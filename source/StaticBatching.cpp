@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "StaticBatching.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//Meshlet bounds of a whole instance, the cone is left open so it's never culled as back facing
+	Meshlet CreateInstanceMeshlet(const StaticBatching::Instance& instance)
+	{
+		Meshlet meshlet{};
+		meshlet.numIndices = instance.numIndices;
+		meshlet.numVertices = instance.numVertices;
+		Meshlets::ComputeBounds(meshlet, instance.pIndices, instance.pVertices);
+		meshlet.coneCutoff = 1.f;
+		return meshlet;
+	}
+
+	void AppendVertices(const StaticBatching::Instance& instance, const Matrix& normalMatrix, float bitangentSign, std::vector<Vertex_PosTex>& vertices)
+	{
+		for (uint32_t index = 0; index < instance.numVertices; ++index)
+		{
+			const Vertex_PosTex& vertex = instance.pVertices[index];
+
+			Vertex_PosTex transformed{ vertex };
+			transformed.position = instance.world.TransformPoint(vertex.position);
+			transformed.normal = normalMatrix.TransformVector(vertex.normal).Normalized();
+			transformed.tangent = Vector4{ instance.world.TransformVector(vertex.tangent.GetXYZ()).Normalized(), vertex.tangent.w * bitangentSign };
+			vertices.emplace_back(transformed);
+		}
+	}
+
+	void AppendMeshlets(const StaticBatching::Instance& instance, bool isUniformScale, uint32_t indexOffset, std::vector<Meshlet>& meshlets)
+	{
+		const float scale = std::max({ instance.world.GetAxisX().Magnitude(), instance.world.GetAxisY().Magnitude(), instance.world.GetAxisZ().Magnitude() });
+
+		const auto append = [&](const Meshlet& local)
+		{
+			Meshlet meshlet{ local };
+			meshlet.indexOffset += indexOffset;
+			meshlet.center = instance.world.TransformPoint(local.center);
+			meshlet.radius = local.radius * scale;
+			meshlet.coneApex = instance.world.TransformPoint(local.coneApex);
+			meshlet.coneAxis = instance.world.TransformVector(local.coneAxis).Normalized();
+			if (!isUniformScale)
+				meshlet.coneCutoff = 1.f;
+
+			meshlets.emplace_back(meshlet);
+		};
+
+		if (instance.numMeshlets == 0)
+		{
+			append(CreateInstanceMeshlet(instance));
+			return;
+		}
+
+		for (uint32_t index = 0; index < instance.numMeshlets; ++index)
+		{
+			append(instance.pMeshlets[index]);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+void StaticBatching::Merge(const Instance* pInstances, uint32_t numInstances, Batch& batch)
+{
+	size_t numVertices{ batch.vertices.size() };
+	size_t numIndices{ batch.indices.size() };
+	for (uint32_t index = 0; index < numInstances; ++index)
+	{
+		numVertices += pInstances[index].numVertices;
+		numIndices += pInstances[index].numIndices;
+	}
+	batch.vertices.reserve(numVertices);
+	batch.indices.reserve(numIndices);
+
+	for (uint32_t index = 0; index < numInstances; ++index)
+	{
+		const Instance& instance = pInstances[index];
+		const Vector3 axisX = instance.world.GetAxisX();
+		const Vector3 axisY = instance.world.GetAxisY();
+		const Vector3 axisZ = instance.world.GetAxisZ();
+
+		//A negative determinant mirrors the mesh, which turns the winding and the bitangents around
+		const bool isMirrored = Vector3::Dot(Vector3::Cross(axisX, axisY), axisZ) < 0.f;
+
+		//Axes of equal length within a rounding error
+		const float lengthX = axisX.Magnitude();
+		const bool isUniformScale = abs(axisY.Magnitude() - lengthX) <= lengthX * 1e-4f && abs(axisZ.Magnitude() - lengthX) <= lengthX * 1e-4f;
+
+		//Normals go through the inverse transpose so they stay perpendicular to non-uniformly scaled surfaces
+		const Matrix normalMatrix = Matrix::Transpose(Matrix::Inverse(instance.world));
+
+		const uint32_t baseVertex = static_cast<uint32_t>(batch.vertices.size());
+		const uint32_t indexOffset = static_cast<uint32_t>(batch.indices.size());
+		AppendVertices(instance, normalMatrix, isMirrored ? -1.f : 1.f, batch.vertices);
+
+		for (uint32_t triangle = 0; triangle < instance.numIndices; triangle += 3)
+		{
+			const uint32_t* pTriangle = instance.pIndices + triangle;
+			batch.indices.emplace_back(baseVertex + pTriangle[0]);
+			batch.indices.emplace_back(baseVertex + pTriangle[isMirrored ? 2 : 1]);
+			batch.indices.emplace_back(baseVertex + pTriangle[isMirrored ? 1 : 2]);
+		}
+
+		AppendMeshlets(instance, isUniformScale, indexOffset, batch.meshlets);
+		batch.instanceRanges.emplace_back(DrawRange{ indexOffset, instance.numIndices });
+	}
+}
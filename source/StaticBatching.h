@@ -0,0 +1,42 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+#include "Meshlets.h"
+
+namespace dae
+{
+	//Merging static meshes that are drawn with the same material into one vertex and index buffer
+	namespace StaticBatching
+	{
+		//A mesh placed in the world, the geometry stays owned by the caller
+		struct Instance
+		{
+			const Vertex_PosTex* pVertices{};
+			uint32_t numVertices{};
+			const uint32_t* pIndices{};
+			uint32_t numIndices{};
+
+			//Without meshlets the whole instance is culled as one
+			const Meshlet* pMeshlets{};
+			uint32_t numMeshlets{};
+
+			Matrix world{};
+		};
+
+		struct Batch
+		{
+			std::vector<Vertex_PosTex> vertices{};
+			std::vector<uint32_t> indices{};
+
+			//The meshlets of every instance in world space, they never span two instances
+			std::vector<Meshlet> meshlets{};
+
+			//Index range of every instance, in the order they were passed in
+			std::vector<DrawRange> instanceRanges{};
+		};
+
+		//Appends the instances with their vertices pre-transformed, so the batch is drawn with an identity world matrix
+		//Mirroring transforms get their triangles flipped, non-uniform scales lose the normal cones of their meshlets
+		void Merge(const Instance* pInstances, uint32_t numInstances, Batch& batch);
+	}
+}
@@ -0,0 +1,295 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "TangentGenerator.h"
+#include "Parallel.h"
+#include <immintrin.h>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//One float per triangle, 8 wide when the build targets AVX and 4 wide (SSE2 is always there on x64) otherwise
+#if defined(__AVX__)
+	struct Lanes
+	{
+		static constexpr uint32_t Width{ 8 };
+		__m256 value;
+
+		static Lanes Load(const float* pData) { return { _mm256_loadu_ps(pData) }; }
+		static Lanes Set(float scalar) { return { _mm256_set1_ps(scalar) }; }
+		void Store(float* pData) const { _mm256_storeu_ps(pData, value); }
+
+		friend Lanes operator+(Lanes a, Lanes b) { return { _mm256_add_ps(a.value, b.value) }; }
+		friend Lanes operator-(Lanes a, Lanes b) { return { _mm256_sub_ps(a.value, b.value) }; }
+		friend Lanes operator*(Lanes a, Lanes b) { return { _mm256_mul_ps(a.value, b.value) }; }
+		friend Lanes operator/(Lanes a, Lanes b) { return { _mm256_div_ps(a.value, b.value) }; }
+		friend Lanes operator&(Lanes a, Lanes b) { return { _mm256_and_ps(a.value, b.value) }; }
+		friend Lanes operator|(Lanes a, Lanes b) { return { _mm256_or_ps(a.value, b.value) }; }
+		friend Lanes operator>(Lanes a, Lanes b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ) }; }
+
+		static Lanes AndNot(Lanes mask, Lanes a) { return { _mm256_andnot_ps(mask.value, a.value) }; }
+		static Lanes Min(Lanes a, Lanes b) { return { _mm256_min_ps(a.value, b.value) }; }
+		static Lanes Max(Lanes a, Lanes b) { return { _mm256_max_ps(a.value, b.value) }; }
+		static Lanes Sqrt(Lanes a) { return { _mm256_sqrt_ps(a.value) }; }
+	};
+#else
+	struct Lanes
+	{
+		static constexpr uint32_t Width{ 4 };
+		__m128 value;
+
+		static Lanes Load(const float* pData) { return { _mm_loadu_ps(pData) }; }
+		static Lanes Set(float scalar) { return { _mm_set1_ps(scalar) }; }
+		void Store(float* pData) const { _mm_storeu_ps(pData, value); }
+
+		friend Lanes operator+(Lanes a, Lanes b) { return { _mm_add_ps(a.value, b.value) }; }
+		friend Lanes operator-(Lanes a, Lanes b) { return { _mm_sub_ps(a.value, b.value) }; }
+		friend Lanes operator*(Lanes a, Lanes b) { return { _mm_mul_ps(a.value, b.value) }; }
+		friend Lanes operator/(Lanes a, Lanes b) { return { _mm_div_ps(a.value, b.value) }; }
+		friend Lanes operator&(Lanes a, Lanes b) { return { _mm_and_ps(a.value, b.value) }; }
+		friend Lanes operator|(Lanes a, Lanes b) { return { _mm_or_ps(a.value, b.value) }; }
+		friend Lanes operator>(Lanes a, Lanes b) { return { _mm_cmpgt_ps(a.value, b.value) }; }
+
+		static Lanes AndNot(Lanes mask, Lanes a) { return { _mm_andnot_ps(mask.value, a.value) }; }
+		static Lanes Min(Lanes a, Lanes b) { return { _mm_min_ps(a.value, b.value) }; }
+		static Lanes Max(Lanes a, Lanes b) { return { _mm_max_ps(a.value, b.value) }; }
+		static Lanes Sqrt(Lanes a) { return { _mm_sqrt_ps(a.value) }; }
+	};
+#endif
+
+	Lanes Select(Lanes mask, Lanes a, Lanes b)
+	{
+		return (mask & a) | Lanes::AndNot(mask, b);
+	}
+
+	Lanes Abs(Lanes a)
+	{
+		return Lanes::AndNot(Lanes::Set(-0.f), a);
+	}
+
+	struct Lanes3
+	{
+		Lanes x, y, z;
+
+		friend Lanes3 operator+(const Lanes3& a, const Lanes3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		friend Lanes3 operator-(const Lanes3& a, const Lanes3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		friend Lanes3 operator*(const Lanes3& a, Lanes scale) { return { a.x * scale, a.y * scale, a.z * scale }; }
+	};
+
+	Lanes Dot(const Lanes3& a, const Lanes3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//Zero stays zero instead of turning into a NaN
+	Lanes3 Normalized(const Lanes3& a)
+	{
+		const Lanes sqrMagnitude = Dot(a, a);
+		const Lanes isValid = sqrMagnitude > Lanes::Set(FLT_MIN);
+		const Lanes inverse = Lanes::Set(1.f) / Lanes::Sqrt(Lanes::Max(sqrMagnitude, Lanes::Set(FLT_MIN)));
+		return a * (inverse & isValid);
+	}
+
+	//Removes the part along the (unit) normal and normalizes the rest
+	Lanes3 ProjectOnPlane(const Lanes3& a, const Lanes3& normal)
+	{
+		return Normalized(a - normal * Dot(normal, a));
+	}
+
+	//Abramowitz and Stegun 4.4.45, off by at most 7e-5 radians which is plenty for a weight
+	Lanes Acos(Lanes x)
+	{
+		const Lanes absX = Abs(x);
+		Lanes result = Lanes::Set(-0.0187293f);
+		result = result * absX + Lanes::Set(0.0742610f);
+		result = result * absX - Lanes::Set(0.2121144f);
+		result = result * absX + Lanes::Set(1.5707288f);
+		result = result * Lanes::Sqrt(Lanes::Max(Lanes::Set(1.f) - absX, Lanes::Set(0.f)));
+		return Select(Lanes::Set(0.f) > x, Lanes::Set(PI) - result, result);
+	}
+
+	//Sums of what the corners of one vertex add, in fixed point so the order of the additions can't change the result
+	//The bitangent always lies along cross(normal, tangent), so only the side it is on is kept
+	struct FrameSum
+	{
+		int64_t tangent[3];
+		int64_t orientation;
+	};
+
+	//Every corner adds at most pi, so a vertex would need millions of corners to overflow
+	constexpr float FixedPointScale{ float(1 << 24) };
+
+	//Gathers Lanes::Width triangles starting at firstTriangle, the lanes past the last triangle repeat it and are skipped when adding
+	void ProcessTriangles(const TangentGenerator::VertexStreams& vertices, const uint32_t* pIndices, size_t firstTriangle, size_t numRemaining, FrameSum* pSums)
+	{
+		constexpr uint32_t Width{ Lanes::Width };
+		const size_t stride = vertices.stride;
+		alignas(32) float gathered[3][8][Width]; //Per corner: position xyz, normal xyz, uv
+		for (uint32_t lane = 0; lane < Width; ++lane)
+		{
+			const size_t triangle = firstTriangle + std::min<size_t>(lane, numRemaining - 1);
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				const size_t offset = pIndices[triangle * 3 + corner] * stride;
+				for (uint32_t component = 0; component < 3; ++component)
+				{
+					gathered[corner][component][lane] = vertices.pPositions[component][offset];
+					gathered[corner][3 + component][lane] = vertices.pNormals[component][offset];
+				}
+				gathered[corner][6][lane] = vertices.pUVs[0][offset];
+				gathered[corner][7][lane] = vertices.pUVs[1][offset];
+			}
+		}
+
+		Lanes3 positions[3]{};
+		Lanes3 normals[3]{};
+		Lanes u[3]{};
+		Lanes v[3]{};
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			positions[corner] = { Lanes::Load(gathered[corner][0]), Lanes::Load(gathered[corner][1]), Lanes::Load(gathered[corner][2]) };
+			normals[corner] = { Lanes::Load(gathered[corner][3]), Lanes::Load(gathered[corner][4]), Lanes::Load(gathered[corner][5]) };
+			u[corner] = Lanes::Load(gathered[corner][6]);
+			v[corner] = Lanes::Load(gathered[corner][7]);
+		}
+
+		//Direction of increasing u over the triangle, the uv winding tells on which side the bitangent is
+		const Lanes3 edge1 = positions[1] - positions[0];
+		const Lanes3 edge2 = positions[2] - positions[0];
+		const Lanes u21 = u[1] - u[0];
+		const Lanes v21 = v[1] - v[0];
+		const Lanes u31 = u[2] - u[0];
+		const Lanes v31 = v[2] - v[0];
+		const Lanes signedArea = u21 * v31 - v21 * u31;
+		const Lanes isValid = Abs(signedArea) > Lanes::Set(FLT_MIN);
+		const Lanes orientation = Select(signedArea > Lanes::Set(0.f), Lanes::Set(1.f), Lanes::Set(-1.f)) & isValid;
+		const Lanes3 triangleTangent = (edge1 * v31 - edge2 * v21) * orientation;
+
+		const size_t numAdded = std::min<size_t>(Width, numRemaining);
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			//Weight by the angle of the corner as seen along its normal
+			const Lanes3& normal = normals[corner];
+			const Lanes3 toNext = positions[(corner + 1) % 3] - positions[corner];
+			const Lanes3 toPrevious = positions[(corner + 2) % 3] - positions[corner];
+			const Lanes3 projectedNext = toNext - normal * Dot(normal, toNext);
+			const Lanes3 projectedPrevious = toPrevious - normal * Dot(normal, toPrevious);
+			const Lanes lengths = Lanes::Sqrt(Dot(projectedNext, projectedNext) * Dot(projectedPrevious, projectedPrevious));
+			const Lanes cosAngle = (Dot(projectedNext, projectedPrevious) / Lanes::Max(lengths, Lanes::Set(FLT_MIN))) & (lengths > Lanes::Set(FLT_MIN));
+			const Lanes angle = Acos(Lanes::Min(Lanes::Max(cosAngle, Lanes::Set(-1.f)), Lanes::Set(1.f))) * Lanes::Set(FixedPointScale);
+
+			const Lanes3 tangent = ProjectOnPlane(triangleTangent, normal) * angle;
+			const Lanes weightedOrientation = orientation * angle;
+
+			alignas(32) float added[4][Width];
+			tangent.x.Store(added[0]);
+			tangent.y.Store(added[1]);
+			tangent.z.Store(added[2]);
+			weightedOrientation.Store(added[3]);
+			for (size_t lane = 0; lane < numAdded; ++lane)
+			{
+				FrameSum& sum = pSums[pIndices[(firstTriangle + lane) * 3 + corner]];
+				sum.tangent[0] += static_cast<int64_t>(added[0][lane]);
+				sum.tangent[1] += static_cast<int64_t>(added[1][lane]);
+				sum.tangent[2] += static_cast<int64_t>(added[2][lane]);
+				sum.orientation += static_cast<int64_t>(added[3][lane]);
+			}
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+void TangentGenerator::Generate(const VertexStreams& vertices, const uint32_t* pIndices, size_t numIndices, const TangentStreams& tangents, uint32_t numThreads)
+{
+	const size_t numVertices = vertices.numVertices;
+	const size_t numTriangles = numIndices / 3;
+	if (numThreads == 0)
+		numThreads = GetNumWorkers(numTriangles / MinTrianglesPerThread);
+
+	//Every worker adds its triangles into its own sums, so no two threads ever write to the same place
+	const size_t numBlocks = (numTriangles + Lanes::Width - 1) / Lanes::Width;
+	const uint32_t numWorkers = GetNumWorkers(numBlocks, numThreads);
+	std::vector<FrameSum> sums(numVertices * numWorkers, FrameSum{});
+
+	ParallelFor(numBlocks, [&](size_t begin, size_t end, uint32_t worker)
+		{
+			FrameSum* pSums = sums.data() + numVertices * worker;
+			for (size_t block = begin; block < end; ++block)
+			{
+				const size_t firstTriangle = block * Lanes::Width;
+				ProcessTriangles(vertices, pIndices, firstTriangle, numTriangles - firstTriangle, pSums);
+			}
+		}, numWorkers);
+
+	//Every vertex merges the sums of all workers, then makes the tangent perpendicular to its normal
+	ParallelFor(numVertices, [&](size_t begin, size_t end, uint32_t)
+		{
+			for (size_t vertex = begin; vertex < end; ++vertex)
+			{
+				FrameSum total{};
+				for (uint32_t worker = 0; worker < numWorkers; ++worker)
+				{
+					const FrameSum& sum = sums[numVertices * worker + vertex];
+					total.tangent[0] += sum.tangent[0];
+					total.tangent[1] += sum.tangent[1];
+					total.tangent[2] += sum.tangent[2];
+					total.orientation += sum.orientation;
+				}
+
+				const size_t inputOffset = vertex * vertices.stride;
+				const Vector3 normal{ vertices.pNormals[0][inputOffset], vertices.pNormals[1][inputOffset], vertices.pNormals[2][inputOffset] };
+				Vector3 tangent = Vector3::Reject(Vector3{ float(total.tangent[0]), float(total.tangent[1]), float(total.tangent[2]) }, normal);
+				if (tangent.Normalize() <= 0.f)
+				{
+					//No usable uvs around this vertex, any direction in the normal plane will do
+					tangent = Vector3::Reject(fabsf(normal.x) < 0.9f ? Vector3::UnitX : Vector3::UnitY, normal).Normalized();
+				}
+
+				const size_t outputOffset = vertex * tangents.stride;
+				tangents.pTangents[0][outputOffset] = tangent.x;
+				tangents.pTangents[1][outputOffset] = tangent.y;
+				tangents.pTangents[2][outputOffset] = tangent.z;
+				tangents.pTangents[3][outputOffset] = total.orientation < 0 ? -1.f : 1.f;
+			}
+		}, numThreads);
+}
+
+void TangentGenerator::Generate(std::vector<Vertex_PosTex>& vertices, const std::vector<uint32_t>& indices, uint32_t numThreads)
+{
+	if (vertices.empty())
+		return;
+
+	//The interleaved vertices are read and written in place as strided streams
+	constexpr size_t stride{ sizeof(Vertex_PosTex) / sizeof(float) };
+	Vertex_PosTex& first = vertices[0];
+
+	VertexStreams vertexStreams{};
+	vertexStreams.pPositions[0] = &first.position.x;
+	vertexStreams.pPositions[1] = &first.position.y;
+	vertexStreams.pPositions[2] = &first.position.z;
+	vertexStreams.pNormals[0] = &first.normal.x;
+	vertexStreams.pNormals[1] = &first.normal.y;
+	vertexStreams.pNormals[2] = &first.normal.z;
+	vertexStreams.pUVs[0] = &first.uv.x;
+	vertexStreams.pUVs[1] = &first.uv.y;
+	vertexStreams.stride = stride;
+	vertexStreams.numVertices = vertices.size();
+
+	TangentStreams tangentStreams{};
+	tangentStreams.pTangents[0] = &first.tangent.x;
+	tangentStreams.pTangents[1] = &first.tangent.y;
+	tangentStreams.pTangents[2] = &first.tangent.z;
+	tangentStreams.pTangents[3] = &first.tangent.w;
+	tangentStreams.stride = stride;
+
+	Generate(vertexStreams, indices.data(), indices.size(), tangentStreams, numThreads);
+}
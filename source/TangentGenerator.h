@@ -0,0 +1,39 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Per-vertex tangent frames following the MikkTSpace conventions
+	//Every corner adds its triangle's uv directions, projected onto the vertex normal and weighted by the corner angle
+	//The bitangent is rebuilt in the shader as cross(normal, tangent.xyz) * tangent.w
+	namespace TangentGenerator
+	{
+		//Structure of arrays view of the attributes the tangents depend on, one stream per component
+		//stride is the distance between two vertices in floats, 1 for tightly packed streams
+		struct VertexStreams
+		{
+			const float* pPositions[3]{};
+			const float* pNormals[3]{};
+			const float* pUVs[2]{};
+			size_t stride{ 1 };
+			size_t numVertices{};
+		};
+
+		//x, y, z and the bitangent sign
+		struct TangentStreams
+		{
+			float* pTangents[4]{};
+			size_t stride{ 1 };
+		};
+
+		//Triangles are only split over multiple threads when every thread gets at least this many
+		constexpr size_t MinTrianglesPerThread{ 16384 };
+
+		//numThreads = 0 picks a thread count based on the triangle count, the result is identical for any thread count
+		void Generate(const VertexStreams& vertices, const uint32_t* pIndices, size_t numIndices, const TangentStreams& tangents, uint32_t numThreads = 0);
+
+		//Reads the interleaved vertices as strided streams and writes the tangents in place
+		void Generate(std::vector<Vertex_PosTex>& vertices, const std::vector<uint32_t>& indices, uint32_t numThreads = 0);
+	}
+}
@@ -3,27 +3,127 @@
 //-----------------------------------------------------------------
 #include "pch.h"
 #include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
 #include <cassert>
+#include <chrono>
 
 using namespace dae;
 
 
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	//The sRGB variants aren't used, the shaders treat every texel as is
+	DXGI_FORMAT ToDXGIFormat(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			return DXGI_FORMAT_BC1_UNORM;
+		case TextureFormat::BC3:
+			return DXGI_FORMAT_BC3_UNORM;
+		case TextureFormat::BC4:
+			return DXGI_FORMAT_BC4_UNORM;
+		case TextureFormat::BC5:
+			return DXGI_FORMAT_BC5_UNORM;
+		case TextureFormat::BC7:
+			return DXGI_FORMAT_BC7_UNORM;
+		case TextureFormat::RGBA8:
+		default:
+			return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+}
+
+
 //-----------------------------------------------------------------
 // Constructors
 //-----------------------------------------------------------------
-Texture::Texture(ID3D11Device* pDevice, const std::string& path)
+Texture::Texture(ID3D11Device* pDevice, const std::string& path, TextureUsage usage)
 {
-	//Load SDL_Surface using IMG_LOAD
-	SDL_Surface* pSurface = IMG_Load(path.c_str());
-	assert(pSurface && "Image failed to load!");
+	const TextureLoader::LoadedTexture texture = TextureLoader::Load({ path, usage });
 
+	const auto start = std::chrono::high_resolution_clock::now();
+	CreateResource(pDevice, texture);
+	TextureLoader::Report(texture, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+Texture::Texture(ID3D11Device* pDevice, const TextureLoader::LoadedTexture& texture)
+{
+	CreateResource(pDevice, texture);
+}
+
+Texture::Texture(ID3D11Device* pDevice, TextureLoader::LoadedTexture&& texture, TextureStreamer& streamer)
+	: m_pSource(new TextureLoader::LoadedTexture(std::move(texture)))
+{
+	if (m_pSource->IsValid())
+	{
+		const TextureData::Level& level = m_pSource->GetLevels()[0];
+		m_pStreamer = &streamer;
+		m_StreamingId = streamer.AddTexture(m_pSource->GetFormat(), level.width, level.height, m_pSource->GetNumLevels());
+		m_FirstLevel = streamer.GetFirstLevel(m_StreamingId);
+	}
+
+	CreateResource(pDevice, *m_pSource, m_FirstLevel);
+}
+
+
+//-----------------------------------------------------------------
+// Destructor
+//-----------------------------------------------------------------
+Texture::~Texture()
+{
+	if (m_pSRV) m_pSRV->Release();
+	if (m_pResource) m_pResource->Release();
+
+	if (m_pStreamer) m_pStreamer->RemoveTexture(m_StreamingId);
+	delete m_pSource;
+}
+
+
+//-----------------------------------------------------------------
+// Public Member Functions
+//-----------------------------------------------------------------
+void Texture::SetFirstLevel(ID3D11Device* pDevice, uint32_t firstLevel)
+{
+	if (!m_pSource || firstLevel == m_FirstLevel || firstLevel >= m_pSource->GetNumLevels())
+		return;
+
+	//The coarser levels are uploaded again with the new one, together they're a third of its size
+	if (m_pSRV) m_pSRV->Release();
+	if (m_pResource) m_pResource->Release();
+	m_pSRV = nullptr;
+	m_pResource = nullptr;
+
+	m_FirstLevel = firstLevel;
+	CreateResource(pDevice, *m_pSource, m_FirstLevel);
+}
+
+
+//-----------------------------------------------------------------
+// Private Member Functions
+//-----------------------------------------------------------------
+void Texture::CreateResource(ID3D11Device* pDevice, const TextureLoader::LoadedTexture& texture, uint32_t firstLevel)
+{
+	assert(texture.IsValid() && "Image failed to load!");
+	if (!texture.IsValid())
+		return;
+
+	m_HasPackedAlpha = texture.hasPackedAlpha;
+	const TextureFormat textureFormat = texture.GetFormat();
+	const TextureData::Level* pLevels = texture.GetLevels() + firstLevel;
+	const uint32_t numLevels = texture.GetNumLevels() - firstLevel;
+	const uint8_t* pData = texture.GetData();
 
 	//Create Resource
-	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	DXGI_FORMAT format = ToDXGIFormat(textureFormat);
 	D3D11_TEXTURE2D_DESC desc{};
-	desc.Width = pSurface->w;
-	desc.Height = pSurface->h;
-	desc.MipLevels = 1;
+	desc.Width = pLevels[0].width;
+	desc.Height = pLevels[0].height;
+	desc.MipLevels = numLevels;
 	desc.ArraySize = 1;
 	desc.Format = format;
 	desc.SampleDesc.Count = 1;
@@ -33,13 +133,16 @@ Texture::Texture(ID3D11Device* pDevice, const std::string& path)
 	desc.CPUAccessFlags = 0;
 	desc.MiscFlags = 0;
 
-	D3D11_SUBRESOURCE_DATA initData;
-	initData.pSysMem = pSurface->pixels;
-	initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-	initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
+	//One subresource per level, the offsets are relative to pData
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(numLevels);
+	for (uint32_t level = 0; level < numLevels; ++level)
+	{
+		initData[level].pSysMem = pData + pLevels[level].offset;
+		initData[level].SysMemPitch = GetRowPitch(textureFormat, pLevels[level].width);
+		initData[level].SysMemSlicePitch = GetLevelSize(textureFormat, pLevels[level].width, pLevels[level].height);
+	}
 
-	HRESULT result = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
-	SDL_FreeSurface(pSurface);
+	HRESULT result = pDevice->CreateTexture2D(&desc, initData.data(), &m_pResource);
 	if (FAILED(result))
 		return;
 
@@ -48,30 +151,9 @@ Texture::Texture(ID3D11Device* pDevice, const std::string& path)
 	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
 	SRVDesc.Format = format;
 	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	SRVDesc.Texture1D.MipLevels = 1;
+	SRVDesc.Texture2D.MipLevels = desc.MipLevels;
 
 	result = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pSRV);
 	if (FAILED(result))
 		return;
 }
-
-
-//-----------------------------------------------------------------
-// Destructor
-//-----------------------------------------------------------------
-Texture::~Texture()
-{
-	if (m_pSRV) m_pSRV->Release();
-	if (m_pResource) m_pResource->Release();
-}
-
-
-//-----------------------------------------------------------------
-// Public Member Functions
-//-----------------------------------------------------------------
-
-
-//-----------------------------------------------------------------
-// Private Member Functions
-//-----------------------------------------------------------------
-
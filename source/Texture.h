@@ -1,16 +1,25 @@
 #pragma once
 // Includes
+#include "TextureData.h"
 
 namespace dae
 {
 	// Class Forward Declarations
-	
+	class TextureStreamer;
+	namespace TextureLoader { struct LoadedTexture; }
+
 	// Class Declaration
 	class Texture final
 	{
 	public:
 		// Constructors and Destructor
-		explicit Texture(ID3D11Device* pDevice, const std::string& path);
+		//Uploads the full mip chain, a DDS or KTX2 file as it is stored and an image with mips built by the usage
+		//A cooked DDS next to an image (TextureFile::GetCookedPath) is loaded instead of the image while it's up to date
+		explicit Texture(ID3D11Device* pDevice, const std::string& path, TextureUsage usage = TextureUsage::Color);
+		//Only uploads, the texture was read beforehand by TextureLoader, possibly on another thread
+		explicit Texture(ID3D11Device* pDevice, const TextureLoader::LoadedTexture& texture);
+		//Streamed, keeps the texture around and only uploads the levels the streamer has made resident
+		explicit Texture(ID3D11Device* pDevice, TextureLoader::LoadedTexture&& texture, TextureStreamer& streamer);
 		~Texture();
 		
 		// Copy and Move semantics
@@ -24,15 +33,34 @@ namespace dae
 		//---------------------------
 		ID3D11ShaderResourceView* GetResourceView() const { return m_pSRV; }
 
+		//The alpha holds a second map packed into it (TextureLoader::Request::alphaPath), for a specular map that's the gloss
+		bool HasPackedAlpha() const { return m_HasPackedAlpha; }
+
+		//Recreates the resource with the levels from firstLevel on, which also replaces the resource view
+		void SetFirstLevel(ID3D11Device* pDevice, uint32_t firstLevel);
+
+		bool IsStreamed() const { return m_pStreamer != nullptr; }
+		uint32_t GetStreamingId() const { return m_StreamingId; }
+		uint32_t GetFirstLevel() const { return m_FirstLevel; }
+		const TextureLoader::LoadedTexture* GetSource() const { return m_pSource; } //Only kept while streamed
+
 		
 	private:
 		// Member variables
 		ID3D11Texture2D* m_pResource{};
 		ID3D11ShaderResourceView* m_pSRV{};
+
+		bool m_HasPackedAlpha{};
+
+		TextureLoader::LoadedTexture* m_pSource{};
+		TextureStreamer* m_pStreamer{};
+		uint32_t m_StreamingId{};
+		uint32_t m_FirstLevel{};
 	
 		//---------------------------
 		// Private Member Functions
 		//---------------------------
+		void CreateResource(ID3D11Device* pDevice, const TextureLoader::LoadedTexture& texture, uint32_t firstLevel = 0);
 	
 	};
 }
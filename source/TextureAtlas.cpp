@@ -0,0 +1,243 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	uint32_t GetAlignment(uint32_t numLevels)
+	{
+		return 1u << (std::max(numLevels, 1u) - 1);
+	}
+
+	//The top edge of the packed area, every segment spans from x to x + width at height y
+	//Sizes are in cells of the alignment, so every position the skyline hands out is aligned
+	struct Segment
+	{
+		uint32_t x{};
+		uint32_t y{};
+		uint32_t width{};
+	};
+	using Skyline = std::vector<Segment>;
+
+	//Lowest top edge for a rect starting at any of the segments, the leftmost among equals
+	bool FindPosition(const Skyline& skyline, uint32_t width, uint32_t height, uint32_t size, size_t& bestSegment, uint32_t& bestY)
+	{
+		uint32_t bestTop{ UINT32_MAX };
+		for (size_t segment = 0; segment < skyline.size(); ++segment)
+		{
+			const uint32_t x = skyline[segment].x;
+			if (x + width > size)
+				break;
+
+			//The rect rests on the highest segment below it
+			uint32_t y{};
+			for (size_t next = segment; next < skyline.size() && skyline[next].x < x + width; ++next)
+			{
+				y = std::max(y, skyline[next].y);
+			}
+
+			if (y + height <= size && y + height < bestTop)
+			{
+				bestTop = y + height;
+				bestSegment = segment;
+				bestY = y;
+			}
+		}
+		return bestTop != UINT32_MAX;
+	}
+
+	void AddRect(Skyline& skyline, size_t segment, uint32_t width, uint32_t top)
+	{
+		const uint32_t x = skyline[segment].x;
+		skyline.insert(skyline.begin() + segment, Segment{ x, top, width });
+
+		//Cut the segments the rect covers
+		const size_t next = segment + 1;
+		while (next < skyline.size() && skyline[next].x < x + width)
+		{
+			Segment& covered = skyline[next];
+			if (covered.x + covered.width <= x + width)
+			{
+				skyline.erase(skyline.begin() + next);
+				continue;
+			}
+
+			covered.width -= x + width - covered.x;
+			covered.x = x + width;
+			break;
+		}
+
+		//Neighbours at the same height become one
+		for (size_t index = 1; index < skyline.size();)
+		{
+			if (skyline[index - 1].y == skyline[index].y)
+			{
+				skyline[index - 1].width += skyline[index].width;
+				skyline.erase(skyline.begin() + index);
+			}
+			else
+				++index;
+		}
+	}
+
+	//One level of a tile with its edge texels repeated gutter times on every side
+	void CopyTile(const uint32_t* pSource, uint32_t width, uint32_t height, uint32_t* pDestination, uint32_t atlasWidth, uint32_t x, uint32_t y, uint32_t gutter)
+	{
+		for (uint32_t row = 0; row < height + 2 * gutter; ++row)
+		{
+			const uint32_t sourceRow = std::clamp(static_cast<int>(row) - static_cast<int>(gutter), 0, static_cast<int>(height) - 1);
+			const uint32_t* pSourceRow = pSource + static_cast<size_t>(sourceRow) * width;
+			uint32_t* pDestinationRow = pDestination + static_cast<size_t>(y - gutter + row) * atlasWidth + x - gutter;
+
+			std::fill_n(pDestinationRow, gutter, pSourceRow[0]);
+			std::copy_n(pSourceRow, width, pDestinationRow + gutter);
+			std::fill_n(pDestinationRow + gutter + width, gutter, pSourceRow[width - 1]);
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+uint32_t TextureAtlas::GetGutter(uint32_t padding, uint32_t numLevels)
+{
+	//At least a texel at the last level, which is a texel of the alignment in the first
+	const uint32_t alignment = GetAlignment(numLevels);
+	return (std::max(padding, 1u) + alignment - 1) / alignment * alignment;
+}
+
+bool TextureAtlas::CanPlace(const TextureData& texture, uint32_t level, uint32_t numLevels)
+{
+	if (texture.format != TextureFormat::RGBA8 || level + std::max(numLevels, 1u) > texture.levels.size())
+		return false;
+
+	const uint32_t alignment = GetAlignment(numLevels);
+	const TextureData::Level& first = texture.levels[level];
+	return first.width > 0 && first.height > 0 && first.width % alignment == 0 && first.height % alignment == 0;
+}
+
+uint32_t TextureAtlas::Pack(Tile* pTiles, uint32_t numTiles, uint32_t atlasSize, uint32_t padding, uint32_t numLevels)
+{
+	const uint32_t alignment = GetAlignment(numLevels);
+	const uint32_t gutterCells = GetGutter(padding, numLevels) / alignment;
+	const uint32_t size = atlasSize / alignment;
+
+	//Tallest first, then widest, every tile takes up its own cells and the gutter on both sides
+	const auto getWidth = [&](const Tile& tile) { return (tile.width + alignment - 1) / alignment + 2 * gutterCells; };
+	const auto getHeight = [&](const Tile& tile) { return (tile.height + alignment - 1) / alignment + 2 * gutterCells; };
+
+	std::vector<uint32_t> order(numTiles);
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+		{
+			if (getHeight(pTiles[a]) != getHeight(pTiles[b]))
+				return getHeight(pTiles[a]) > getHeight(pTiles[b]);
+			return getWidth(pTiles[a]) > getWidth(pTiles[b]);
+		});
+
+	//The first atlas the tile fits in takes it, a new one is started when none does
+	std::vector<Skyline> atlases{};
+	for (uint32_t index : order)
+	{
+		Tile& tile = pTiles[index];
+		tile.atlas = NotPacked;
+
+		const uint32_t width = getWidth(tile);
+		const uint32_t height = getHeight(tile);
+		if (tile.width == 0 || tile.height == 0 || width > size || height > size)
+			continue;
+
+		size_t segment{};
+		uint32_t y{};
+		uint32_t atlas{};
+		while (atlas < atlases.size() && !FindPosition(atlases[atlas], width, height, size, segment, y))
+		{
+			++atlas;
+		}
+		if (atlas == atlases.size())
+		{
+			atlases.push_back(Skyline{ Segment{ 0, 0, size } });
+			FindPosition(atlases[atlas], width, height, size, segment, y);
+		}
+
+		tile.atlas = atlas;
+		tile.x = (atlases[atlas][segment].x + gutterCells) * alignment;
+		tile.y = (y + gutterCells) * alignment;
+		AddRect(atlases[atlas], segment, width, y + height);
+	}
+
+	return static_cast<uint32_t>(atlases.size());
+}
+
+void TextureAtlas::Build(const TextureData* const* ppTextures, const Tile* pTiles, uint32_t numTiles, uint32_t atlas, uint32_t atlasSize, uint32_t padding, uint32_t numLevels, TextureData& result)
+{
+	numLevels = std::max(numLevels, 1u);
+	const uint32_t gutter = GetGutter(padding, numLevels);
+
+	result = TextureData{};
+	result.format = TextureFormat::RGBA8;
+	size_t size{};
+	for (uint32_t level = 0; level < numLevels; ++level)
+	{
+		const uint32_t levelSize = std::max(atlasSize >> level, 1u);
+		result.levels.push_back(TextureData::Level{ levelSize, levelSize, size });
+		size += GetLevelSize(TextureFormat::RGBA8, levelSize, levelSize);
+	}
+	result.data.assign(size, 0);
+
+	for (uint32_t index = 0; index < numTiles; ++index)
+	{
+		const Tile& tile = pTiles[index];
+		if (tile.atlas != atlas)
+			continue;
+
+		//The level of the texture the tile was sized after, the levels below it follow along
+		const TextureData& texture = *ppTextures[index];
+		const auto first = std::find_if(texture.levels.begin(), texture.levels.end(), [&](const TextureData::Level& level)
+			{
+				return level.width == tile.width && level.height == tile.height;
+			});
+		const size_t firstLevel = first - texture.levels.begin();
+		if (!CanPlace(texture, static_cast<uint32_t>(firstLevel), numLevels))
+			continue;
+
+		//Aligned tiles and gutters halve exactly, so each level lines up with the one above it
+		for (uint32_t level = 0; level < numLevels; ++level)
+		{
+			const TextureData::Level& source = texture.levels[firstLevel + level];
+			CopyTile(reinterpret_cast<const uint32_t*>(texture.GetLevelData(firstLevel + level)), source.width, source.height,
+				reinterpret_cast<uint32_t*>(result.data.data() + result.levels[level].offset), result.levels[level].width,
+				tile.x >> level, tile.y >> level, gutter >> level);
+		}
+	}
+}
+
+bool TextureAtlas::HasUnitUVs(const Vertex_PosTex* pVertices, uint32_t numVertices)
+{
+	return std::all_of(pVertices, pVertices + numVertices, [](const Vertex_PosTex& vertex)
+		{
+			return vertex.uv.x >= 0.f && vertex.uv.x <= 1.f && vertex.uv.y >= 0.f && vertex.uv.y <= 1.f;
+		});
+}
+
+void TextureAtlas::RemapUVs(Vertex_PosTex* pVertices, uint32_t numVertices, const Tile& tile, uint32_t atlasSize)
+{
+	const float inverseSize = 1.f / atlasSize;
+	for (uint32_t vertex = 0; vertex < numVertices; ++vertex)
+	{
+		Vector2& uv = pVertices[vertex].uv;
+		uv.x = (tile.x + uv.x * tile.width) * inverseSize;
+		uv.y = (tile.y + uv.y * tile.height) * inverseSize;
+	}
+}
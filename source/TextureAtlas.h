@@ -0,0 +1,44 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+#include "TextureData.h"
+
+namespace dae
+{
+	//Packs small textures into shared RGBA8 atlases, so meshes that sampled their own textures can be drawn with the same ones
+	//Every tile starts on a multiple of 2^(numLevels - 1) texels, so each level of the atlas is built from the levels of its tiles without bleeding
+	//The gutter around a tile repeats its edge texels, at every level
+	namespace TextureAtlas
+	{
+		constexpr uint32_t NotPacked{ UINT32_MAX };
+
+		struct Tile
+		{
+			uint32_t width{};	//Texels in the first level of the atlas
+			uint32_t height{};
+
+			//Set by Pack, where the texels of the tile start, the gutter lies around them
+			uint32_t atlas{ NotPacked };
+			uint32_t x{};
+			uint32_t y{};
+		};
+
+		//Texels between the edge of a tile and its neighbours in the first level, the padding rounded up to the alignment
+		uint32_t GetGutter(uint32_t padding, uint32_t numLevels);
+
+		//Whether the level of the texture can go into an atlas with numLevels levels, both sides have to be a multiple of the alignment
+		bool CanPlace(const TextureData& texture, uint32_t level, uint32_t numLevels);
+
+		//Skyline packing of the tiles with their gutters into as many square atlases as needed, the tallest tiles go first
+		//Returns the number of atlases, tiles that don't fit an empty atlas stay NotPacked
+		uint32_t Pack(Tile* pTiles, uint32_t numTiles, uint32_t atlasSize, uint32_t padding, uint32_t numLevels);
+
+		//Copies the tiles packed into atlas from the level of their texture with the size of the tile and down, and fills their gutters
+		//The textures are RGBA8 with a level of the size of their tile, texels no tile covers are 0
+		void Build(const TextureData* const* ppTextures, const Tile* pTiles, uint32_t numTiles, uint32_t atlas, uint32_t atlasSize, uint32_t padding, uint32_t numLevels, TextureData& result);
+
+		//Uvs can only be remapped while they stay within [0, 1], a repeating texture can't be repeated inside an atlas
+		bool HasUnitUVs(const Vertex_PosTex* pVertices, uint32_t numVertices);
+		void RemapUVs(Vertex_PosTex* pVertices, uint32_t numVertices, const Tile& tile, uint32_t atlasSize);
+	}
+}
@@ -0,0 +1,44 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "TextureCooker.h"
+#include "TextureFile.h"
+#include <chrono>
+#include <iomanip>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+bool TextureCooker::Cook(const TextureLoader::Request& request, BlockCompressor::Quality quality)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	const std::string imageFile = request.alphaPath.empty() ? request.path : request.path + " + " + request.alphaPath;
+
+	TextureData texture{};
+	if (!TextureLoader::DecodeImage(request, texture))
+	{
+		std::cout << "Cook: " << imageFile << " not found\n";
+		return false;
+	}
+
+	const TextureFormat format = BlockCompressor::ChooseFormat(texture, request.usage, quality);
+	TextureData compressed{};
+	BlockCompressor::Compress(texture, format, quality, compressed);
+
+	const std::string cookedFile = TextureFile::GetCookedPath(request.path, request.alphaPath);
+	const bool isWritten = TextureFile::Write(cookedFile, compressed);
+	const double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	const std::streamsize precision = std::cout.precision();
+	std::cout << "Cook: " << imageFile << " -> " << cookedFile << ", " << GetFormatName(format) << ", "
+		<< texture.data.size() / 1024 << " KB -> " << compressed.data.size() / 1024 << " KB, PSNR " << std::fixed << std::setprecision(2)
+		<< BlockCompressor::ComputePSNR(texture, compressed) << " dB, " << time << " ms" << (isWritten ? "" : ", WRITE FAILED") << '\n';
+	std::cout.unsetf(std::ios::fixed);
+	std::cout.precision(precision);
+
+	return isWritten;
+}
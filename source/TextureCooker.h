@@ -0,0 +1,16 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+#include "BlockCompressor.h"
+#include "TextureLoader.h"
+
+namespace dae
+{
+	//Turns images into block compressed DDS files ahead of time, Texture loads those instead of the image once they exist
+	namespace TextureCooker
+	{
+		//Writes TextureFile::GetCookedPath in the format BlockCompressor::ChooseFormat picks and reports the quality loss
+		//A request with an alpha image cooks the packed texture, which comes out as BC3 or BC7 since it carries alpha
+		bool Cook(const TextureLoader::Request& request, BlockCompressor::Quality quality);
+	}
+}
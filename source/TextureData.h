@@ -0,0 +1,99 @@
+#pragma once
+// Includes
+
+namespace dae
+{
+	//Layout of the texels of every level of a texture
+	enum class TextureFormat
+	{
+		RGBA8,
+		BC1,	//Opaque rgb, 4 bits per texel
+		BC3,	//BC1 rgb with BC4 alpha, 8 bits per texel
+		BC4,	//A single channel, 4 bits per texel
+		BC5,	//Two BC4 channels, red and green
+		BC7		//rgba, 8 bits per texel
+	};
+
+	inline const char* GetFormatName(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+			return "BC1";
+		case TextureFormat::BC3:
+			return "BC3";
+		case TextureFormat::BC4:
+			return "BC4";
+		case TextureFormat::BC5:
+			return "BC5";
+		case TextureFormat::BC7:
+			return "BC7";
+		case TextureFormat::RGBA8:
+		default:
+			return "RGBA8";
+		}
+	}
+
+	//What the texels stand for, decides how they get filtered
+	enum class TextureUsage
+	{
+		Color,	//sRGB encoded rgb, filtered in linear space
+		Data,	//Linear values like specular and gloss
+		Normal	//Tangent space normal in rgb, renormalized after filtering
+	};
+
+	//Bytes per block of 4x4 texels, 0 if the format isn't block compressed
+	inline uint32_t GetBlockSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::BC1:
+		case TextureFormat::BC4:
+			return 8;
+		case TextureFormat::BC3:
+		case TextureFormat::BC5:
+		case TextureFormat::BC7:
+			return 16;
+		case TextureFormat::RGBA8:
+		default:
+			return 0;
+		}
+	}
+
+	//Bytes per row and per level, levels are tightly packed
+	//A row of a compressed format is a row of blocks, levels that aren't a multiple of 4 are padded to whole blocks
+	inline uint32_t GetRowPitch(TextureFormat format, uint32_t width)
+	{
+		const uint32_t blockSize = GetBlockSize(format);
+		return blockSize > 0 ? (width + 3) / 4 * blockSize : width * 4;
+	}
+
+	inline uint32_t GetNumRows(TextureFormat format, uint32_t height)
+	{
+		return GetBlockSize(format) > 0 ? (height + 3) / 4 : height;
+	}
+
+	inline uint32_t GetLevelSize(TextureFormat format, uint32_t width, uint32_t height)
+	{
+		return GetRowPitch(format, width) * GetNumRows(format, height);
+	}
+
+	//A texture on the CPU, every level down to 1x1 in one buffer
+	struct TextureData
+	{
+		struct Level
+		{
+			uint32_t width{};
+			uint32_t height{};
+			size_t offset{}; //In bytes from the start of data
+		};
+
+		TextureFormat format{ TextureFormat::RGBA8 };
+		std::vector<Level> levels{};
+		std::vector<uint8_t> data{};
+
+		const uint8_t* GetLevelData(size_t level) const { return data.data() + levels[level].offset; }
+		uint32_t GetRowPitch(size_t level) const { return dae::GetRowPitch(format, levels[level].width); }
+		uint32_t GetLevelSize(size_t level) const { return dae::GetLevelSize(format, levels[level].width, levels[level].height); }
+	};
+}
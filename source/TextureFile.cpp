@@ -0,0 +1,379 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "TextureFile.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// File Format
+//-----------------------------------------------------------------
+namespace
+{
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+	}
+
+	//DDS: the magic, the header, the DX10 header when the four cc says so, then every level back to back
+	constexpr uint32_t DDSMagic{ MakeFourCC('D', 'D', 'S', ' ') };
+
+	constexpr uint32_t DDSFlagCaps{ 0x1 };
+	constexpr uint32_t DDSFlagHeight{ 0x2 };
+	constexpr uint32_t DDSFlagWidth{ 0x4 };
+	constexpr uint32_t DDSFlagPixelFormat{ 0x1000 };
+	constexpr uint32_t DDSFlagMipMapCount{ 0x20000 };
+	constexpr uint32_t DDSFlagLinearSize{ 0x80000 };
+	constexpr uint32_t DDSFlagDepth{ 0x800000 };
+
+	constexpr uint32_t DDSPixelFormatFourCC{ 0x4 };
+	constexpr uint32_t DDSPixelFormatRGB{ 0x40 };
+
+	constexpr uint32_t DDSCapsComplex{ 0x8 };
+	constexpr uint32_t DDSCapsTexture{ 0x1000 };
+	constexpr uint32_t DDSCapsMipMap{ 0x400000 };
+	constexpr uint32_t DDSCaps2CubeMap{ 0x200 };
+	constexpr uint32_t DDSCaps2Volume{ 0x200000 };
+
+	constexpr uint32_t DDSDimensionTexture2D{ 3 };
+
+	struct DDSPixelFormat
+	{
+		uint32_t size{ sizeof(DDSPixelFormat) };
+		uint32_t flags{};
+		uint32_t fourCC{};
+		uint32_t rgbBitCount{};
+		uint32_t redMask{};
+		uint32_t greenMask{};
+		uint32_t blueMask{};
+		uint32_t alphaMask{};
+	};
+
+	struct DDSHeader
+	{
+		uint32_t size{ sizeof(DDSHeader) };
+		uint32_t flags{};
+		uint32_t height{};
+		uint32_t width{};
+		uint32_t pitchOrLinearSize{};
+		uint32_t depth{};
+		uint32_t mipMapCount{};
+		uint32_t reserved1[11]{};
+		DDSPixelFormat pixelFormat{};
+		uint32_t caps{};
+		uint32_t caps2{};
+		uint32_t caps3{};
+		uint32_t caps4{};
+		uint32_t reserved2{};
+	};
+
+	struct DDSHeaderDX10
+	{
+		uint32_t dxgiFormat{};
+		uint32_t resourceDimension{};
+		uint32_t miscFlag{};
+		uint32_t arraySize{};
+		uint32_t miscFlags2{};
+	};
+
+	//KTX2: the identifier, the header, the index, one entry per level, then the data descriptor, key/values and the levels
+	constexpr uint8_t KTX2Identifier[12]{ 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct KTX2Header
+	{
+		uint8_t identifier[12]{};
+		uint32_t vkFormat{};
+		uint32_t typeSize{};
+		uint32_t pixelWidth{};
+		uint32_t pixelHeight{};
+		uint32_t pixelDepth{};
+		uint32_t layerCount{};
+		uint32_t faceCount{};
+		uint32_t levelCount{};
+		uint32_t supercompressionScheme{};
+
+		uint32_t dfdByteOffset{};
+		uint32_t dfdByteLength{};
+		uint32_t kvdByteOffset{};
+		uint32_t kvdByteLength{};
+		uint64_t sgdByteOffset{};
+		uint64_t sgdByteLength{};
+	};
+
+	struct KTX2Level
+	{
+		uint64_t byteOffset{};
+		uint64_t byteLength{};
+		uint64_t uncompressedByteLength{};
+	};
+
+	//The codes of every format in both file formats, 0 where there's no sRGB variant
+	struct FormatCodes
+	{
+		TextureFormat format;
+		uint32_t dxgiFormat;
+		uint32_t dxgiSRGBFormat;
+		uint32_t vkFormat;
+		uint32_t vkSRGBFormat;
+	};
+
+	constexpr FormatCodes Formats[]
+	{
+		{ TextureFormat::RGBA8, 28, 29, 37, 43 },
+		{ TextureFormat::BC1, 71, 72, 131, 132 },
+		{ TextureFormat::BC1, 71, 72, 133, 134 }, //BC1 with 1 bit alpha, decodes the same for the opaque blocks we write
+		{ TextureFormat::BC3, 77, 78, 137, 138 },
+		{ TextureFormat::BC4, 80, 0, 139, 0 },
+		{ TextureFormat::BC5, 83, 0, 141, 0 },
+		{ TextureFormat::BC7, 98, 99, 145, 146 }
+	};
+
+	const FormatCodes* FindDXGIFormat(uint32_t dxgiFormat)
+	{
+		for (const FormatCodes& codes : Formats)
+		{
+			if (codes.dxgiFormat == dxgiFormat || (codes.dxgiSRGBFormat != 0 && codes.dxgiSRGBFormat == dxgiFormat))
+				return &codes;
+		}
+		return nullptr;
+	}
+
+	const FormatCodes* FindVkFormat(uint32_t vkFormat)
+	{
+		for (const FormatCodes& codes : Formats)
+		{
+			if (codes.vkFormat == vkFormat || (codes.vkSRGBFormat != 0 && codes.vkSRGBFormat == vkFormat))
+				return &codes;
+		}
+		return nullptr;
+	}
+
+	//Pre DX10 files only name their format through a four cc or the channel masks
+	bool GetLegacyFormat(const DDSPixelFormat& pixelFormat, TextureFormat& format)
+	{
+		if (pixelFormat.flags & DDSPixelFormatFourCC)
+		{
+			switch (pixelFormat.fourCC)
+			{
+			case MakeFourCC('D', 'X', 'T', '1'):
+				format = TextureFormat::BC1;
+				return true;
+			case MakeFourCC('D', 'X', 'T', '5'):
+				format = TextureFormat::BC3;
+				return true;
+			case MakeFourCC('A', 'T', 'I', '1'):
+			case MakeFourCC('B', 'C', '4', 'U'):
+				format = TextureFormat::BC4;
+				return true;
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'):
+				format = TextureFormat::BC5;
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		const bool isRGBA8 = (pixelFormat.flags & DDSPixelFormatRGB) && pixelFormat.rgbBitCount == 32
+			&& pixelFormat.redMask == 0x000000FF && pixelFormat.greenMask == 0x0000FF00 && pixelFormat.blueMask == 0x00FF0000;
+		format = TextureFormat::RGBA8;
+		return isRGBA8;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Constructors
+//-----------------------------------------------------------------
+TextureFile::TextureFile(const std::string& path)
+	: m_pFile{ new MappedFile(path) }
+{
+	const std::string extension = std::filesystem::path(path).extension().string();
+	const bool isValid = extension == ".ktx2" ? ParseKTX2() : ParseDDS();
+	if (!isValid)
+		m_Levels.clear();
+}
+
+
+//-----------------------------------------------------------------
+// Destructor
+//-----------------------------------------------------------------
+TextureFile::~TextureFile()
+{
+	delete m_pFile;
+}
+
+
+//-----------------------------------------------------------------
+// Public Member Functions
+//-----------------------------------------------------------------
+std::string TextureFile::GetCookedPath(const std::string& imageFile, const std::string& alphaFile)
+{
+	std::filesystem::path path{ imageFile };
+	if (!alphaFile.empty())
+		path.replace_filename(path.stem().string() + "+" + std::filesystem::path(alphaFile).stem().string());
+
+	return path.replace_extension(".dds").string();
+}
+
+bool TextureFile::IsTextureFile(const std::string& path)
+{
+	const std::string extension = std::filesystem::path(path).extension().string();
+	return extension == ".dds" || extension == ".ktx2";
+}
+
+bool TextureFile::Write(const std::string& ddsFile, const TextureData& texture)
+{
+	const FormatCodes* pCodes = std::find_if(std::begin(Formats), std::end(Formats), [&](const FormatCodes& codes) { return codes.format == texture.format; });
+	if (texture.levels.empty() || pCodes == std::end(Formats))
+		return false;
+
+	DDSHeader header{};
+	header.flags = DDSFlagCaps | DDSFlagHeight | DDSFlagWidth | DDSFlagPixelFormat | DDSFlagMipMapCount | DDSFlagLinearSize;
+	header.height = texture.levels[0].height;
+	header.width = texture.levels[0].width;
+	header.pitchOrLinearSize = texture.GetLevelSize(0);
+	header.mipMapCount = static_cast<uint32_t>(texture.levels.size());
+	header.pixelFormat.flags = DDSPixelFormatFourCC;
+	header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+	header.caps = DDSCapsTexture | (texture.levels.size() > 1 ? DDSCapsMipMap | DDSCapsComplex : 0);
+
+	DDSHeaderDX10 headerDX10{};
+	headerDX10.dxgiFormat = pCodes->dxgiFormat;
+	headerDX10.resourceDimension = DDSDimensionTexture2D;
+	headerDX10.arraySize = 1;
+
+	std::ofstream file(ddsFile, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	file.write(reinterpret_cast<const char*>(&DDSMagic), sizeof(DDSMagic));
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(&headerDX10), sizeof(headerDX10));
+	file.write(reinterpret_cast<const char*>(texture.data.data()), texture.data.size());
+
+	return file.good();
+}
+
+const uint8_t* TextureFile::GetData() const
+{
+	return reinterpret_cast<const uint8_t*>(m_pFile->GetData());
+}
+
+size_t TextureFile::GetSize() const
+{
+	return m_pFile->GetSize();
+}
+
+
+//-----------------------------------------------------------------
+// Private Member Functions
+//-----------------------------------------------------------------
+bool TextureFile::ParseDDS()
+{
+	const size_t fileSize = m_pFile->GetSize();
+	if (fileSize < sizeof(DDSMagic) + sizeof(DDSHeader))
+		return false;
+
+	uint32_t magic{};
+	DDSHeader header{};
+	memcpy(&magic, m_pFile->GetData(), sizeof(magic));
+	memcpy(&header, m_pFile->GetData() + sizeof(magic), sizeof(header));
+	if (magic != DDSMagic || header.size != sizeof(DDSHeader) || header.pixelFormat.size != sizeof(DDSPixelFormat))
+		return false;
+
+	//Cube maps and volumes have more than one image per level
+	if ((header.caps2 & (DDSCaps2CubeMap | DDSCaps2Volume)) || ((header.flags & DDSFlagDepth) && header.depth > 1))
+		return false;
+
+	size_t offset = sizeof(magic) + sizeof(header);
+	if ((header.pixelFormat.flags & DDSPixelFormatFourCC) && header.pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0'))
+	{
+		DDSHeaderDX10 headerDX10{};
+		if (fileSize < offset + sizeof(headerDX10))
+			return false;
+
+		memcpy(&headerDX10, m_pFile->GetData() + offset, sizeof(headerDX10));
+		offset += sizeof(headerDX10);
+
+		const FormatCodes* pCodes = FindDXGIFormat(headerDX10.dxgiFormat);
+		if (!pCodes || headerDX10.resourceDimension != DDSDimensionTexture2D || headerDX10.arraySize > 1)
+			return false;
+
+		m_Format = pCodes->format;
+	}
+	else if (!GetLegacyFormat(header.pixelFormat, m_Format))
+	{
+		return false;
+	}
+
+	const uint32_t numLevels = (header.flags & DDSFlagMipMapCount) ? std::max(header.mipMapCount, 1u) : 1;
+	return AddLevels(header.width, header.height, numLevels, offset);
+}
+
+bool TextureFile::ParseKTX2()
+{
+	const size_t fileSize = m_pFile->GetSize();
+	KTX2Header header{};
+	if (fileSize < sizeof(header))
+		return false;
+
+	memcpy(&header, m_pFile->GetData(), sizeof(header));
+	if (memcmp(header.identifier, KTX2Identifier, sizeof(KTX2Identifier)) != 0)
+		return false;
+
+	//Basis and zstd supercompression would have to be transcoded on the CPU, which is what this path avoids
+	const FormatCodes* pCodes = FindVkFormat(header.vkFormat);
+	if (!pCodes || header.supercompressionScheme != 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1)
+		return false;
+
+	m_Format = pCodes->format;
+
+	//A level count of 0 asks the loader to generate the mips, only the base level is stored then
+	//A header claiming more levels than the chain has is broken, the sizes past 1x1 would be shifted out of range
+	const uint32_t numLevels = std::max(header.levelCount, 1u);
+	if (numLevels > MipGenerator::GetNumLevels(header.pixelWidth, header.pixelHeight))
+		return false;
+	if (fileSize < sizeof(header) + numLevels * sizeof(KTX2Level))
+		return false;
+
+	for (uint32_t level = 0; level < numLevels; ++level)
+	{
+		KTX2Level index{};
+		memcpy(&index, m_pFile->GetData() + sizeof(header) + level * sizeof(KTX2Level), sizeof(index));
+
+		const uint32_t width = std::max(header.pixelWidth >> level, 1u);
+		const uint32_t height = std::max(header.pixelHeight >> level, 1u);
+		if (index.byteLength < GetLevelSize(m_Format, width, height) || index.byteOffset + index.byteLength > fileSize)
+			return false;
+
+		m_Levels.push_back(TextureData::Level{ width, height, static_cast<size_t>(index.byteOffset) });
+	}
+	return true;
+}
+
+//Levels that follow each other from offset on, every one half the size of the previous and no more than the chain down to 1x1 has
+bool TextureFile::AddLevels(uint32_t width, uint32_t height, uint32_t numLevels, size_t offset)
+{
+	if (width == 0 || height == 0 || numLevels > MipGenerator::GetNumLevels(width, height))
+		return false;
+
+	for (uint32_t level = 0; level < numLevels; ++level)
+	{
+		const uint32_t levelWidth = std::max(width >> level, 1u);
+		const uint32_t levelHeight = std::max(height >> level, 1u);
+		const size_t size = GetLevelSize(m_Format, levelWidth, levelHeight);
+		if (offset + size > m_pFile->GetSize())
+			return false;
+
+		m_Levels.push_back(TextureData::Level{ levelWidth, levelHeight, offset });
+		offset += size;
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+
+namespace dae
+{
+	// Class Forward Declarations
+	class MappedFile;
+
+	// Class Declaration
+	//A DDS or KTX2 file mapped into memory, the levels are read straight from the mapping
+	//Only 2D textures without supercompression in the formats of TextureFormat, sRGB variants load as their linear counterpart
+	class TextureFile final
+	{
+	public:
+		// Constructors and Destructor
+		explicit TextureFile(const std::string& path);
+		~TextureFile();
+
+		// Copy and Move semantics
+		TextureFile(const TextureFile& other)					= delete;
+		TextureFile& operator=(const TextureFile& other)		= delete;
+		TextureFile(TextureFile&& other) noexcept				= delete;
+		TextureFile& operator=(TextureFile&& other) noexcept	= delete;
+
+		//---------------------------
+		// Public Member Functions
+		//---------------------------
+		//Where a cooked version of an image goes, next to it with the dds extension
+		//With an alpha file the name of both is used, "a.png" with "b.png" packed into its alpha becomes "a+b.dds"
+		static std::string GetCookedPath(const std::string& imageFile, const std::string& alphaFile = {});
+		static bool IsTextureFile(const std::string& path);
+
+		//Writes a DDS file with the DX10 header, so every format can be stored
+		static bool Write(const std::string& ddsFile, const TextureData& texture);
+
+		bool IsValid() const { return !m_Levels.empty(); }
+
+		TextureFormat GetFormat() const { return m_Format; }
+		uint32_t GetNumLevels() const { return static_cast<uint32_t>(m_Levels.size()); }
+		const TextureData::Level* GetLevels() const { return m_Levels.data(); }
+
+		//Start of the mapping, the offsets of the levels are relative to it
+		const uint8_t* GetData() const;
+		size_t GetSize() const;
+
+
+	private:
+		// Member variables
+		MappedFile* m_pFile{};
+
+		TextureFormat m_Format{};
+		std::vector<TextureData::Level> m_Levels{};
+
+		//---------------------------
+		// Private Member Functions
+		//---------------------------
+		bool ParseDDS();
+		bool ParseKTX2();
+		bool AddLevels(uint32_t width, uint32_t height, uint32_t numLevels, size_t offset);
+
+	};
+}
@@ -0,0 +1,322 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+#include "Parallel.h"
+#include "PixelConversion.h"
+#include "Texture.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <numeric>
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	double GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	//A DDS or KTX2 file as is, or the cooked file next to the images as long as it isn't older than any of them
+	std::string FindTextureFile(const TextureLoader::Request& request)
+	{
+		if (TextureFile::IsTextureFile(request.path))
+			return request.path;
+
+		std::error_code error{};
+		const std::string cookedPath = TextureFile::GetCookedPath(request.path, request.alphaPath);
+		const auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+		if (error)
+			return {};
+
+		for (const std::string* pImageFile : { &request.path, &request.alphaPath })
+		{
+			if (pImageFile->empty())
+				continue;
+
+			const auto imageTime = std::filesystem::last_write_time(*pImageFile, error);
+			if (!error && cookedTime < imageTime)
+				return {};
+		}
+		return cookedPath;
+	}
+
+	//Layouts without a kernel of their own are converted to RGBA8 by SDL first
+	SDL_Surface* LoadSurface(const std::string& imageFile)
+	{
+		SDL_Surface* pSurface = IMG_Load(imageFile.c_str());
+		if (pSurface && !PixelConversion::CanConvert(pSurface))
+		{
+			SDL_Surface* pConverted = SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0);
+			SDL_FreeSurface(pSurface);
+			pSurface = pConverted;
+		}
+		return pSurface;
+	}
+
+	bool Decode(const TextureLoader::Request& request, TextureData& texture, uint32_t numThreads, double& decodeTime, double& mipTime)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		SDL_Surface* pSurface = LoadSurface(request.path);
+		if (!pSurface)
+			return false;
+
+		//The image is converted straight into level 0 of the upload data, the mips are filtered from there
+		MipGenerator::Allocate(pSurface->w, pSurface->h, texture);
+		const bool isConverted = PixelConversion::ConvertSurface(pSurface, texture.data.data(), numThreads);
+		SDL_FreeSurface(pSurface);
+		if (!isConverted)
+		{
+			texture = TextureData{};
+			return false;
+		}
+
+		//The red channel of the alpha image goes into the alpha of every texel
+		if (!request.alphaPath.empty())
+		{
+			const TextureData::Level& first = texture.levels[0];
+			SDL_Surface* pAlpha = LoadSurface(request.alphaPath);
+			bool isPackable = pAlpha && static_cast<uint32_t>(pAlpha->w) == first.width && static_cast<uint32_t>(pAlpha->h) == first.height;
+			if (isPackable)
+			{
+				std::vector<uint8_t> alpha(size_t(first.width) * first.height * 4);
+				isPackable = PixelConversion::ConvertSurface(pAlpha, alpha.data(), numThreads);
+				for (size_t texel = 0; isPackable && texel < size_t(first.width) * first.height; ++texel)
+				{
+					texture.data[texel * 4 + 3] = alpha[texel * 4];
+				}
+			}
+
+			if (pAlpha)
+				SDL_FreeSurface(pAlpha);
+			if (!isPackable)
+			{
+				texture = TextureData{};
+				return false;
+			}
+		}
+
+		decodeTime = GetMilliseconds(start);
+		start = std::chrono::high_resolution_clock::now();
+
+		MipGenerator::Generate(request.usage, MipGenerator::Filter::Kaiser, texture, numThreads);
+
+		mipTime = GetMilliseconds(start);
+		return true;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Member Functions
+//-----------------------------------------------------------------
+bool TextureLoader::LoadedTexture::IsValid() const
+{
+	return pFile ? pFile->IsValid() : !image.levels.empty();
+}
+
+TextureFormat TextureLoader::LoadedTexture::GetFormat() const
+{
+	return pFile ? pFile->GetFormat() : image.format;
+}
+
+uint32_t TextureLoader::LoadedTexture::GetNumLevels() const
+{
+	return pFile ? pFile->GetNumLevels() : static_cast<uint32_t>(image.levels.size());
+}
+
+const TextureData::Level* TextureLoader::LoadedTexture::GetLevels() const
+{
+	return pFile ? pFile->GetLevels() : image.levels.data();
+}
+
+const uint8_t* TextureLoader::LoadedTexture::GetData() const
+{
+	return pFile ? pFile->GetData() : image.data.data();
+}
+
+size_t TextureLoader::LoadedTexture::GetSize() const
+{
+	const TextureFormat format = GetFormat();
+	const TextureData::Level* pLevels = GetLevels();
+
+	size_t size{};
+	for (uint32_t level = 0; level < GetNumLevels(); ++level)
+	{
+		size += GetLevelSize(format, pLevels[level].width, pLevels[level].height);
+	}
+	return size;
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+bool TextureLoader::Initialize()
+{
+	//SDL_image loads its decoders on first use without any locking, so that can't happen on a worker
+	static const bool isInitialized = []()
+		{
+			if (IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)
+				return true;
+
+			std::cout << "IMG_Init failed: " << IMG_GetError() << '\n';
+			return false;
+		}();
+	return isInitialized;
+}
+
+bool TextureLoader::DecodeImage(const Request& request, TextureData& texture, uint32_t numThreads)
+{
+	double decodeTime{}, mipTime{};
+	return Decode(request, texture, numThreads, decodeTime, mipTime);
+}
+
+TextureLoader::LoadedTexture TextureLoader::Load(const Request& request, uint32_t numThreads)
+{
+	LoadedTexture texture{};
+	texture.hasPackedAlpha = !request.alphaPath.empty();
+
+	//Pre-built files go to the GPU straight from the mapping, without decoding or building mips
+	const std::string filePath = FindTextureFile(request);
+	if (!filePath.empty())
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		texture.pFile = std::make_unique<TextureFile>(filePath);
+		texture.readTime = GetMilliseconds(start);
+
+		if (texture.pFile->IsValid())
+		{
+			texture.source = filePath + " (mapped)";
+			return texture;
+		}
+		texture.pFile.reset();
+	}
+
+	//Otherwise decode the image and build the mip chain
+	texture.source = request.path + (texture.hasPackedAlpha ? " + " + request.alphaPath + " in alpha" : "") + " (decoded)";
+	if (!Decode(request, texture.image, numThreads, texture.readTime, texture.mipTime))
+	{
+		texture.image = TextureData{};
+	}
+
+	//An alpha image that can't be packed, like one of another size, leaves the image on its own with its alpha as is
+	if (texture.image.levels.empty() && texture.hasPackedAlpha && Decode({ request.path, request.usage }, texture.image, numThreads, texture.readTime, texture.mipTime))
+	{
+		texture.hasPackedAlpha = false;
+		texture.source = request.path + " (decoded, " + request.alphaPath + " not packed)";
+	}
+	return texture;
+}
+
+std::vector<TextureLoader::LoadedTexture> TextureLoader::LoadAll(const Request* pRequests, uint32_t numRequests, uint32_t numThreads)
+{
+	//Before any of the workers decodes an image
+	Initialize();
+	std::vector<LoadedTexture> textures(numRequests);
+
+	//Largest first, a big image picked up last would keep one worker busy while the others are idle
+	std::vector<uint64_t> fileSizes(numRequests);
+	for (uint32_t request = 0; request < numRequests; ++request)
+	{
+		for (const std::string* pFile : { &pRequests[request].path, &pRequests[request].alphaPath })
+		{
+			std::error_code error{};
+			const uintmax_t fileSize = pFile->empty() ? 0 : std::filesystem::file_size(*pFile, error);
+			fileSizes[request] += error ? 0 : static_cast<uint64_t>(fileSize);
+		}
+	}
+
+	std::vector<uint32_t> order(numRequests);
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return fileSizes[a] > fileSizes[b]; });
+
+	//One texture per worker at a time, the threads that don't get a texture of their own help with the mips
+	const uint32_t numWorkers = GetNumWorkers(numRequests, numThreads);
+	const uint32_t numMipThreads = std::max(GetNumWorkers(SIZE_MAX, numThreads) / numWorkers, 1u);
+
+	std::atomic<uint32_t> next{};
+	ParallelFor(numWorkers, [&](size_t, size_t, uint32_t)
+		{
+			for (uint32_t index = next++; index < numRequests; index = next++)
+			{
+				textures[order[index]] = Load(pRequests[order[index]], numMipThreads);
+			}
+		}, numWorkers);
+
+	return textures;
+}
+
+std::vector<Texture*> TextureLoader::CreateTextures(ID3D11Device* pDevice, const std::vector<Request>& requests, TextureStreamer* pStreamer, uint32_t numThreads)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	const uint32_t numRequests = static_cast<uint32_t>(requests.size());
+
+	std::vector<LoadedTexture> textures = LoadAll(requests.data(), numRequests, numThreads);
+	const double loadTime = GetMilliseconds(start);
+
+	//The device is only touched from here, one texture at a time
+	std::vector<Texture*> pTextures{};
+	std::vector<double> uploadTimes{};
+	pTextures.reserve(numRequests);
+	uploadTimes.reserve(numRequests);
+	for (LoadedTexture& texture : textures)
+	{
+		const auto uploadStart = std::chrono::high_resolution_clock::now();
+		pTextures.push_back(pStreamer ? new Texture(pDevice, std::move(texture), *pStreamer) : new Texture(pDevice, texture));
+		uploadTimes.push_back(GetMilliseconds(uploadStart));
+	}
+	const double totalTime = GetMilliseconds(start);
+
+	double readTime{}, mipTime{}, uploadTime{};
+	for (uint32_t index = 0; index < numRequests; ++index)
+	{
+		//Streamed textures took theirs along
+		const Texture* pTexture = pTextures[index];
+		const LoadedTexture& texture = pTexture->GetSource() ? *pTexture->GetSource() : textures[index];
+		Report(texture, uploadTimes[index], pTexture->GetFirstLevel());
+		readTime += texture.readTime;
+		mipTime += texture.mipTime;
+		uploadTime += uploadTimes[index];
+	}
+
+	const std::streamsize precision = std::cout.precision();
+	std::cout << "Textures: " << numRequests << " in " << std::fixed << std::setprecision(2) << totalTime << " ms on "
+		<< GetNumWorkers(numRequests, numThreads) << " workers (loading " << loadTime << " ms, uploading " << totalTime - loadTime
+		<< " ms), summed over the textures: read " << readTime << " ms, mips " << mipTime << " ms, upload " << uploadTime << " ms\n";
+	std::cout.unsetf(std::ios::fixed);
+	std::cout.precision(precision);
+
+	return pTextures;
+}
+
+void TextureLoader::Report(const LoadedTexture& texture, double uploadTime, uint32_t firstLevel)
+{
+	if (!texture.IsValid())
+	{
+		std::cout << "Texture: " << texture.source << " failed to load\n";
+		return;
+	}
+
+	const TextureData::Level& level = texture.GetLevels()[0];
+	const std::streamsize precision = std::cout.precision();
+	std::cout << "Texture: " << texture.source << ", " << GetFormatName(texture.GetFormat()) << ", " << level.width << "x" << level.height << ", "
+		<< texture.GetNumLevels() << " levels, " << texture.GetSize() / 1024 << " KB, " << std::fixed << std::setprecision(2)
+		<< "read " << texture.readTime << " ms, mips " << texture.mipTime << " ms, upload " << uploadTime << " ms";
+	if (firstLevel > 0)
+		std::cout << ", streamed from level " << firstLevel;
+	std::cout << '\n';
+	std::cout.unsetf(std::ios::fixed);
+	std::cout.precision(precision);
+}
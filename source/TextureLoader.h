@@ -0,0 +1,66 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+#include "TextureFile.h"
+#include <memory>
+
+namespace dae
+{
+	// Class Forward Declarations
+	class Texture;
+	class TextureStreamer;
+
+	//Reads the textures of a scene on a pool of worker threads, only the upload to the device stays on the calling thread
+	namespace TextureLoader
+	{
+		struct Request
+		{
+			std::string path{};
+			TextureUsage usage{ TextureUsage::Color };
+			std::string alphaPath{};	//Optional, the red channel of this image replaces the alpha of path, for single channel maps like gloss
+		};
+
+		//A texture ready to upload, either a mapped DDS or KTX2 file or a decoded image with its mips
+		struct LoadedTexture
+		{
+			std::string source{};					//The file that was read, the cooked file when there is one
+			std::unique_ptr<TextureFile> pFile{};	//Set when a texture file was mapped
+			TextureData image{};					//The decoded image otherwise
+
+			bool hasPackedAlpha{};	//The alpha holds the image of Request::alphaPath
+
+			double readTime{};	//Mapping the file or decoding the image, in ms
+			double mipTime{};	//Building the mip chain of a decoded image, in ms
+
+			bool IsValid() const;
+			TextureFormat GetFormat() const;
+			uint32_t GetNumLevels() const;
+			const TextureData::Level* GetLevels() const;
+			const uint8_t* GetData() const;	//The offsets of the levels are relative to it
+			size_t GetSize() const;			//Bytes of every level together
+		};
+
+		//Sets up the PNG decoder of SDL_image on the calling thread, it has to be before images are decoded on several threads at once
+		//Only initializes once, returns false when the decoder isn't available
+		bool Initialize();
+
+		//Decodes the image to RGBA8, packs the alpha image into it if there is one and builds the mip chain over numThreads
+		//Both images need the same size
+		bool DecodeImage(const Request& request, TextureData& texture, uint32_t numThreads = 0);
+
+		//A DDS or KTX2 file as is, the cooked file next to the images (TextureFile::GetCookedPath) while it's up to date, or else the decoded image
+		//When the alpha image can't be packed the image is loaded without it and hasPackedAlpha is false, the alpha image is then for the caller to load on its own
+		LoadedTexture Load(const Request& request, uint32_t numThreads = 0);
+
+		//Loads every request on its own worker, the largest files are picked up first so the batch takes about as long as the largest one
+		//The threads left over are spread over the mip chains, the results are in the order of the requests and don't depend on numThreads
+		std::vector<LoadedTexture> LoadAll(const Request* pRequests, uint32_t numRequests, uint32_t numThreads = 0);
+
+		//LoadAll followed by the uploads one at a time, then logs the breakdown of every texture and of the batch
+		//With a streamer the textures are streamed and only their mip tail is uploaded up front
+		std::vector<Texture*> CreateTextures(ID3D11Device* pDevice, const std::vector<Request>& requests, TextureStreamer* pStreamer = nullptr, uint32_t numThreads = 0);
+
+		//Prints where a texture came from, its layout and the time spent reading, building mips and uploading
+		void Report(const LoadedTexture& texture, double uploadTime, uint32_t firstLevel = 0);
+	}
+}
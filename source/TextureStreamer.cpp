@@ -0,0 +1,176 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "TextureStreamer.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Constructors
+//-----------------------------------------------------------------
+TextureStreamer::TextureStreamer(size_t budget, uint32_t tailSize)
+	: m_Budget(budget)
+	, m_TailSize(std::max(tailSize, 1u))
+{
+}
+
+
+//-----------------------------------------------------------------
+// Public Member Functions
+//-----------------------------------------------------------------
+float TextureStreamer::GetScreenSize(float radius, float distance, float projectionScale, float screenHeight)
+{
+	return radius * projectionScale * screenHeight / std::max(distance, FLT_EPSILON);
+}
+
+uint32_t TextureStreamer::AddTexture(TextureFormat format, uint32_t width, uint32_t height, uint32_t numLevels)
+{
+	Entry entry{};
+	entry.format = format;
+	entry.width = width;
+	entry.height = height;
+	entry.numLevels = std::max(numLevels, 1u);
+
+	//Everything up to the tail size stays resident, it costs about as much as keeping track of it would
+	while (entry.tailLevel + 1 < entry.numLevels && std::max(width >> entry.tailLevel, height >> entry.tailLevel) > m_TailSize)
+	{
+		++entry.tailLevel;
+	}
+	entry.firstLevel = entry.tailLevel;
+	entry.wantedLevel = entry.tailLevel;
+
+	for (uint32_t level = entry.tailLevel; level < entry.numLevels; ++level)
+	{
+		m_ResidentSize += GetLevelSize(entry, level);
+	}
+	m_Statistics.peakSize = std::max(m_Statistics.peakSize, m_ResidentSize);
+
+	m_Textures.push_back(entry);
+	return static_cast<uint32_t>(m_Textures.size() - 1);
+}
+
+void TextureStreamer::RemoveTexture(uint32_t texture)
+{
+	Entry& entry = m_Textures[texture];
+	if (entry.isRemoved)
+		return;
+
+	for (uint32_t level = entry.firstLevel; level < entry.numLevels; ++level)
+	{
+		m_ResidentSize -= GetLevelSize(entry, level);
+	}
+	entry.isRemoved = true;
+}
+
+void TextureStreamer::RequestTexture(uint32_t texture, float screenSize)
+{
+	Entry& entry = m_Textures[texture];
+	entry.requestedSize = std::max(entry.requestedSize, std::max(screenSize, FLT_MIN));
+}
+
+void TextureStreamer::Update(std::vector<Change>& changes)
+{
+	changes.clear();
+	++m_Frame;
+
+	std::vector<uint32_t> firstLevels(m_Textures.size());
+	std::vector<uint32_t> candidates{};
+	for (uint32_t texture = 0; texture < m_Textures.size(); ++texture)
+	{
+		Entry& entry = m_Textures[texture];
+		firstLevels[texture] = entry.firstLevel;
+		if (entry.isRemoved || entry.requestedSize <= 0.f)
+			continue;
+
+		//One texel per pixel across the object, the texture is assumed to be spread over it once
+		const float texelsPerPixel = std::max(entry.width, entry.height) / entry.requestedSize;
+		const uint32_t level = texelsPerPixel > 1.f ? static_cast<uint32_t>(std::log2(texelsPerPixel)) : 0;
+		entry.wantedLevel = std::min(level, entry.tailLevel);
+		entry.lastUsedFrame = m_Frame;
+		entry.requestedSize = 0.f;
+
+		if (entry.firstLevel > entry.wantedLevel)
+			candidates.push_back(texture);
+	}
+
+	//The textures missing the most detail go first, a level per texture per frame so the coarse mips of everything show up before the fine ones
+	std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b)
+		{
+			return m_Textures[a].firstLevel - m_Textures[a].wantedLevel > m_Textures[b].firstLevel - m_Textures[b].wantedLevel;
+		});
+
+	for (uint32_t texture : candidates)
+	{
+		Entry& entry = m_Textures[texture];
+		const size_t size = GetLevelSize(entry, entry.firstLevel - 1);
+		if (m_ResidentSize + size > m_Budget && !Evict(m_ResidentSize + size - m_Budget))
+		{
+			++m_Statistics.numDenied;
+			continue;
+		}
+
+		--entry.firstLevel;
+		m_ResidentSize += size;
+		++m_Statistics.numPromotions;
+	}
+	m_Statistics.peakSize = std::max(m_Statistics.peakSize, m_ResidentSize);
+
+	for (uint32_t texture = 0; texture < m_Textures.size(); ++texture)
+	{
+		if (m_Textures[texture].firstLevel != firstLevels[texture])
+			changes.push_back(Change{ texture, m_Textures[texture].firstLevel });
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Private Member Functions
+//-----------------------------------------------------------------
+size_t TextureStreamer::GetLevelSize(const Entry& entry, uint32_t level) const
+{
+	return dae::GetLevelSize(entry.format, std::max(entry.width >> level, 1u), std::max(entry.height >> level, 1u));
+}
+
+uint32_t TextureStreamer::GetEvictableLevel(const Entry& entry) const
+{
+	//Textures drawn this frame keep what they need, the others can go back to their tail
+	if (entry.isRemoved)
+		return entry.firstLevel;
+	return entry.lastUsedFrame == m_Frame ? std::min(entry.wantedLevel, entry.tailLevel) : entry.tailLevel;
+}
+
+bool TextureStreamer::Evict(size_t size)
+{
+	//Nothing is dropped unless enough can be dropped
+	size_t evictableSize{};
+	for (const Entry& entry : m_Textures)
+	{
+		for (uint32_t level = entry.firstLevel; level < GetEvictableLevel(entry); ++level)
+		{
+			evictableSize += GetLevelSize(entry, level);
+		}
+	}
+	if (evictableSize < size)
+		return false;
+
+	//Least recently used first, a level at a time starting from the finest
+	size_t evictedSize{};
+	while (evictedSize < size)
+	{
+		Entry* pVictim{};
+		for (Entry& entry : m_Textures)
+		{
+			if (entry.firstLevel < GetEvictableLevel(entry) && (!pVictim || entry.lastUsedFrame < pVictim->lastUsedFrame))
+				pVictim = &entry;
+		}
+
+		const size_t levelSize = GetLevelSize(*pVictim, pVictim->firstLevel);
+		++pVictim->firstLevel;
+		m_ResidentSize -= levelSize;
+		evictedSize += levelSize;
+		++m_Statistics.numEvictions;
+	}
+	return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+// Includes
+#include "TextureData.h"
+
+namespace dae
+{
+	// Class Declaration
+	//Decides which mips of every texture are resident on the GPU, without touching the GPU itself
+	//Textures start out with only their mip tail, finer levels are promoted one per frame while the meshes using them ask for more detail
+	//Once the budget is reached the least recently used textures lose their finest levels first, the tails are never evicted
+	class TextureStreamer final
+	{
+	public:
+		// Constructors and Destructor
+		explicit TextureStreamer(size_t budget, uint32_t tailSize = 64);
+		~TextureStreamer() = default;
+
+		// Copy and Move semantics
+		TextureStreamer(const TextureStreamer& other)					= delete;
+		TextureStreamer& operator=(const TextureStreamer& other)		= delete;
+		TextureStreamer(TextureStreamer&& other) noexcept				= delete;
+		TextureStreamer& operator=(TextureStreamer&& other) noexcept	= delete;
+
+		//---------------------------
+		// Public Member Functions
+		//---------------------------
+		//A texture whose first resident level changed in the last Update
+		struct Change
+		{
+			uint32_t texture{};
+			uint32_t firstLevel{};
+		};
+
+		struct Statistics
+		{
+			uint32_t numPromotions{};	//Levels made resident, over the lifetime of the streamer
+			uint32_t numEvictions{};	//Levels dropped to stay within the budget
+			uint32_t numDenied{};		//Promotions that didn't fit, even after evicting everything that could go
+			size_t peakSize{};			//Most bytes resident after an Update
+		};
+
+		//Pixels a bounding sphere of the radius covers on screen, its diameter
+		static float GetScreenSize(float radius, float distance, float projectionScale, float screenHeight);
+
+		//Returns the handle of the texture, only its mip tail is resident until it gets requested
+		uint32_t AddTexture(TextureFormat format, uint32_t width, uint32_t height, uint32_t numLevels);
+		void RemoveTexture(uint32_t texture);
+
+		//The texture is drawn this frame by something that covers screenSize pixels, the largest request of a frame counts
+		void RequestTexture(uint32_t texture, float screenSize);
+
+		//Promotes the textures requested since the last Update by one level and evicts to make room, changes lists every texture that moved
+		void Update(std::vector<Change>& changes);
+
+		void SetBudget(size_t budget) { m_Budget = budget; }
+		size_t GetBudget() const { return m_Budget; }
+		size_t GetResidentSize() const { return m_ResidentSize; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+
+		uint32_t GetFirstLevel(uint32_t texture) const { return m_Textures[texture].firstLevel; }
+		uint32_t GetWantedLevel(uint32_t texture) const { return m_Textures[texture].wantedLevel; }
+		uint32_t GetTailLevel(uint32_t texture) const { return m_Textures[texture].tailLevel; }
+
+
+	private:
+		// Member variables
+		struct Entry
+		{
+			TextureFormat format{};
+			uint32_t width{};
+			uint32_t height{};
+			uint32_t numLevels{};
+			uint32_t tailLevel{};	//First level of the mip tail, it and every smaller level are always resident
+			uint32_t firstLevel{};	//Finest level resident
+			uint32_t wantedLevel{};	//Finest level the last request needed
+			float requestedSize{};	//Largest screen size asked for since the last Update, 0 if none
+			uint64_t lastUsedFrame{};
+			bool isRemoved{};
+		};
+		std::vector<Entry> m_Textures{};
+
+		size_t m_Budget{};
+		uint32_t m_TailSize{};
+		size_t m_ResidentSize{};
+		uint64_t m_Frame{};
+		Statistics m_Statistics{};
+
+		//---------------------------
+		// Private Member Functions
+		//---------------------------
+		size_t GetLevelSize(const Entry& entry, uint32_t level) const;
+		uint32_t GetEvictableLevel(const Entry& entry) const; //Coarsest level the entry can be evicted down to
+		bool Evict(size_t size);
+
+	};
+}
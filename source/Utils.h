@@ -1,163 +1,575 @@
 #pragma once
-#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
 #include "DataTypes.h"
+#include "Material.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "TangentGenerator.h"
 
 namespace dae
 {
 	namespace Utils
 	{
-		//Just parses vertices and indices
-#pragma warning(push)
-#pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true)
+		//Key used to weld face corners that reference the same position/uv/normal triple (0 = not specified)
+		struct ObjVertexKey
 		{
-			std::ifstream file(filename);
-			if (!file)
-				return false;
+			uint32_t position{};
+			uint32_t uv{};
+			uint32_t normal{};
+
+			bool operator==(const ObjVertexKey& other) const
+			{
+				return position == other.position && uv == other.uv && normal == other.normal;
+			}
+		};
+
+		struct ObjVertexKeyHash
+		{
+			size_t operator()(const ObjVertexKey& key) const
+			{
+				uint64_t hash = key.position * 0x9E3779B97F4A7C15ull;
+				hash ^= (key.uv + 0x7F4A7C15ull + (hash << 6) + (hash >> 2)) * 0xC2B2AE3D27D4EB4Full;
+				hash ^= (key.normal + 0x165667B1ull + (hash << 6) + (hash >> 2)) * 0x27D4EB2F165667C5ull;
+				return static_cast<size_t>(hash ^ (hash >> 32));
+			}
+		};
+
+		//Relative (negative) indices are resolved against the elements of the text block they were read in
+		//They get this flag until the block's offset in the whole file is known
+		constexpr uint32_t ObjLocalIndexFlag{ 0x80000000u };
+
+		//Files are only split over multiple threads when every thread gets at least this much text
+		constexpr size_t ObjMinBytesPerThread{ 1 << 20 };
 
+		//Faces before the first usemtl of a text block keep the material of the block before it
+		constexpr uint32_t ObjInheritedMaterial{ UINT32_MAX };
+
+		//Raw OBJ elements, faces are stored as triangulated corners (3 keys per triangle)
+		struct ObjData
+		{
 			std::vector<Vector3> positions{};
 			std::vector<Vector3> normals{};
 			std::vector<Vector2> UVs{};
+			std::vector<ObjVertexKey> corners{};
+
+			//One entry per triangle into materialNames, in the order the names were first used
+			std::vector<uint32_t> triangleMaterials{};
+			std::vector<std::string> materialNames{};
+			uint32_t currentMaterial{ ObjInheritedMaterial };
+			std::string materialLibrary{};
+		};
+
+		//The usemtl groups of a parsed OBJ, the triangles of every material are a contiguous range of the indices
+		//Without any usemtl there are no names and no submeshes, faces before the first usemtl get a material without a name
+		struct ObjMaterials
+		{
+			std::string library{}; //The first mtllib, relative to the OBJ file
+			std::vector<std::string> names{};
+			std::vector<Submesh> submeshes{}; //One per name
+		};
+
+#pragma warning(push)
+#pragma warning(disable : 4505) //Warning unreferenced local function
+		static const char* SkipSpaces(const char* pCurrent, const char* pEnd)
+		{
+			while (pCurrent < pEnd && (*pCurrent == ' ' || *pCurrent == '\t' || *pCurrent == '\r'))
+				++pCurrent;
+			return pCurrent;
+		}
+
+		static const char* ParseFloat(const char* pCurrent, const char* pEnd, float& value)
+		{
+			pCurrent = SkipSpaces(pCurrent, pEnd);
+			if (pCurrent < pEnd && *pCurrent == '+')
+				++pCurrent;
 
+			//std::from_chars is locale independent and never allocates
+			value = 0.f;
+			return std::from_chars(pCurrent, pEnd, value).ptr;
+		}
+
+		//Returns the 1-based index, relative (negative) indices are resolved against the elements read so far
+		static const char* ParseIndex(const char* pCurrent, const char* pEnd, size_t count, uint32_t& index)
+		{
+			int64_t value{};
+			const std::from_chars_result result = std::from_chars(pCurrent, pEnd, value);
+
+			index = 0;
+			if (result.ec != std::errc{})
+				return result.ptr;
+
+			if (value > 0)
+			{
+				index = static_cast<uint32_t>(value);
+			}
+			else if (value < 0)
+			{
+				//Stored as a 31-bit signed index local to the block, it can point to elements of earlier blocks
+				const int64_t localIndex = static_cast<int64_t>(count) + value + 1;
+				index = (static_cast<uint32_t>(localIndex) & ~ObjLocalIndexFlag) | ObjLocalIndexFlag;
+			}
+			return result.ptr;
+		}
+
+		//Rest of the line without the surrounding spaces, names and paths may contain spaces
+		static std::string ParseName(const char* pCurrent, const char* pEnd)
+		{
+			pCurrent = SkipSpaces(pCurrent, pEnd);
+			while (pEnd > pCurrent && (pEnd[-1] == ' ' || pEnd[-1] == '\t' || pEnd[-1] == '\r'))
+				--pEnd;
+			return std::string(pCurrent, pEnd);
+		}
+
+		static bool IsCommand(const char* pCurrent, const char* pLineEnd, const char* command)
+		{
+			const size_t length = strlen(command);
+			return size_t(pLineEnd - pCurrent) > length && memcmp(pCurrent, command, length) == 0 && (pCurrent[length] == ' ' || pCurrent[length] == '\t');
+		}
+
+		static uint32_t ResolveIndex(uint32_t index, uint32_t offset)
+		{
+			if (!(index & ObjLocalIndexFlag))
+				return index;
+
+			//Sign extend the 31-bit local index, anything before the start of the file is invalid
+			const int64_t localIndex = static_cast<int32_t>(index << 1) >> 1;
+			const int64_t resolved = localIndex + offset;
+			return resolved > 0 ? static_cast<uint32_t>(resolved) : 0;
+		}
+
+		//Scans a block of OBJ text, only full lines are expected
+		static void ParseOBJText(const char* pBegin, const char* pEnd, ObjData& data)
+		{
+			const char* pCurrent = pBegin;
+			while (pCurrent < pEnd)
+			{
+				const char* pLineEnd = static_cast<const char*>(memchr(pCurrent, '\n', pEnd - pCurrent));
+				if (!pLineEnd)
+					pLineEnd = pEnd;
+
+				pCurrent = SkipSpaces(pCurrent, pLineEnd);
+				if (pLineEnd - pCurrent >= 2)
+				{
+					const char command0 = pCurrent[0];
+					const char command1 = pCurrent[1];
+
+					if (command0 == 'v' && (command1 == ' ' || command1 == '\t'))
+					{
+						//Vertex
+						Vector3& position = data.positions.emplace_back();
+						pCurrent = ParseFloat(pCurrent + 1, pLineEnd, position.x);
+						pCurrent = ParseFloat(pCurrent, pLineEnd, position.y);
+						ParseFloat(pCurrent, pLineEnd, position.z);
+					}
+					else if (command0 == 'v' && command1 == 't')
+					{
+						// Vertex TexCoord
+						float u, v;
+						pCurrent = ParseFloat(pCurrent + 2, pLineEnd, u);
+						ParseFloat(pCurrent, pLineEnd, v);
+						data.UVs.emplace_back(u, 1 - v);
+					}
+					else if (command0 == 'v' && command1 == 'n')
+					{
+						// Vertex Normal
+						Vector3& normal = data.normals.emplace_back();
+						pCurrent = ParseFloat(pCurrent + 2, pLineEnd, normal.x);
+						pCurrent = ParseFloat(pCurrent, pLineEnd, normal.y);
+						ParseFloat(pCurrent, pLineEnd, normal.z);
+					}
+					else if (command0 == 'f' && (command1 == ' ' || command1 == '\t'))
+					{
+						// Faces, polygons are triangulated as a fan around the first corner
+						ObjVertexKey first{}, previous{};
+						uint32_t numCorners{};
+
+						pCurrent += 1;
+						while (true)
+						{
+							pCurrent = SkipSpaces(pCurrent, pLineEnd);
+							if (pCurrent >= pLineEnd || (*pCurrent != '-' && (*pCurrent < '0' || *pCurrent > '9')))
+								break;
+
+							// OBJ format uses 1-based arrays
+							ObjVertexKey key{};
+							pCurrent = ParseIndex(pCurrent, pLineEnd, data.positions.size(), key.position);
+							if (pCurrent < pLineEnd && *pCurrent == '/')
+							{
+								++pCurrent;
+
+								// Optional texture coordinate
+								if (pCurrent < pLineEnd && *pCurrent != '/')
+									pCurrent = ParseIndex(pCurrent, pLineEnd, data.UVs.size(), key.uv);
+
+								// Optional vertex normal
+								if (pCurrent < pLineEnd && *pCurrent == '/')
+									pCurrent = ParseIndex(pCurrent + 1, pLineEnd, data.normals.size(), key.normal);
+							}
+
+							//Skip anything we don't understand up to the next corner
+							while (pCurrent < pLineEnd && *pCurrent != ' ' && *pCurrent != '\t')
+								++pCurrent;
+
+							if (numCorners == 0)
+							{
+								first = key;
+							}
+							else if (numCorners >= 2)
+							{
+								data.corners.push_back(first);
+								data.corners.push_back(previous);
+								data.corners.push_back(key);
+								data.triangleMaterials.push_back(data.currentMaterial);
+							}
+							previous = key;
+							++numCorners;
+						}
+					}
+					else if (IsCommand(pCurrent, pLineEnd, "usemtl"))
+					{
+						//Material names are few, a linear search is enough
+						const std::string name = ParseName(pCurrent + 6, pLineEnd);
+						const auto it = std::find(data.materialNames.begin(), data.materialNames.end(), name);
+						data.currentMaterial = static_cast<uint32_t>(it - data.materialNames.begin());
+						if (it == data.materialNames.end())
+							data.materialNames.push_back(name);
+					}
+					else if (IsCommand(pCurrent, pLineEnd, "mtllib") && data.materialLibrary.empty())
+					{
+						data.materialLibrary = ParseName(pCurrent + 6, pLineEnd);
+					}
+				}
+
+				//Comments and unsupported commands are skipped along with the rest of the line
+				pCurrent = pLineEnd + 1;
+			}
+		}
+
+		//Welds the corners into shared vertices and generates the tangents
+		//The triangles are grouped by material, keeping the file order within every material
+		static bool BuildOBJMesh(const ObjData& data, std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, ObjMaterials& materials, bool flipAxisAndWinding)
+		{
 			vertices.clear();
 			indices.clear();
+			indices.reserve(data.corners.size());
 
-			std::string sCommand;
-			// start a while iteration ending when the end of file is reached (ios::eof)
-			while (!file.eof())
+			//Counting sort of the triangles on their material, a single material keeps the file order as is
+			const size_t numTriangles = data.corners.size() / 3;
+			materials.names = data.materialNames;
+			materials.submeshes.assign(data.materialNames.size(), Submesh{});
+			std::vector<uint32_t> triangleOrder{};
+			if (materials.names.size() > 1)
 			{
-				//read the first word of the string, use the >> operator (istream::operator>>) 
-				file >> sCommand;
-				//use conditional statements to process the different commands	
-				if (sCommand == "#")
+				for (const uint32_t material : data.triangleMaterials)
 				{
-					// Ignore Comment
+					materials.submeshes[material].numIndices += 3;
 				}
-				else if (sCommand == "v")
+				for (size_t material = 1; material < materials.submeshes.size(); ++material)
 				{
-					//Vertex
-					float x, y, z;
-					file >> x >> y >> z;
-
-					positions.emplace_back(x, y, z);
+					materials.submeshes[material].indexOffset = materials.submeshes[material - 1].indexOffset + materials.submeshes[material - 1].numIndices;
 				}
-				else if (sCommand == "vt")
+
+				triangleOrder.resize(numTriangles);
+				std::vector<uint32_t> next(materials.submeshes.size());
+				for (size_t material = 0; material < next.size(); ++material)
 				{
-					// Vertex TexCoord
-					float u, v;
-					file >> u >> v;
-					UVs.emplace_back(u, 1 - v);
+					next[material] = materials.submeshes[material].indexOffset / 3;
 				}
-				else if (sCommand == "vn")
+				for (size_t triangle = 0; triangle < numTriangles; ++triangle)
 				{
-					// Vertex Normal
-					float x, y, z;
-					file >> x >> y >> z;
-
-					normals.emplace_back(x, y, z);
+					triangleOrder[next[data.triangleMaterials[triangle]]++] = static_cast<uint32_t>(triangle);
 				}
-				else if (sCommand == "f")
+			}
+			else if (!materials.names.empty())
+			{
+				materials.submeshes[0].numIndices = static_cast<uint32_t>(numTriangles * 3);
+			}
+
+			std::unordered_map<ObjVertexKey, uint32_t, ObjVertexKeyHash> vertexLookup{};
+			vertexLookup.reserve(data.corners.size() / 2);
+
+			for (size_t triangle = 0; triangle < numTriangles; ++triangle)
+			{
+				const size_t i = (triangleOrder.empty() ? triangle : triangleOrder[triangle]) * 3;
+				uint32_t tempIndices[3];
+				for (size_t iFace = 0; iFace < 3; iFace++)
 				{
-					//if a face is read:
-					//construct the 3 vertices, add them to the vertex array
-					//add three indices to the index array
-					//add the material index as attibute to the attribute array
-					//
-					// Faces or triangles
-					Vertex_PosTex vertex{};
-					size_t iPosition, iTexCoord, iNormal;
+					const ObjVertexKey& key = data.corners[i + iFace];
+					if (key.position == 0 || key.position > data.positions.size())
+						return false;
 
-					uint32_t tempIndices[3];
-					for (size_t iFace = 0; iFace < 3; iFace++)
+					//Reuse the vertex if this exact corner was seen before
+					const auto it = vertexLookup.find(key);
+					if (it != vertexLookup.end())
 					{
-						// OBJ format uses 1-based arrays
-						file >> iPosition;
-						vertex.position = positions[iPosition - 1];
+						tempIndices[iFace] = it->second;
+						continue;
+					}
 
-						if ('/' == file.peek())//is next in buffer ==  '/' ?
-						{
-							file.ignore();//read and ignore one element ('/')
+					Vertex_PosTex vertex{};
+					vertex.position = data.positions[key.position - 1];
+					if (key.uv && key.uv <= data.UVs.size()) vertex.uv = data.UVs[key.uv - 1];
+					if (key.normal && key.normal <= data.normals.size()) vertex.normal = data.normals[key.normal - 1];
 
-							if ('/' != file.peek())
-							{
-								// Optional texture coordinate
-								file >> iTexCoord;
-								vertex.uv = UVs[iTexCoord - 1];
-							}
+					vertices.push_back(vertex);
+					tempIndices[iFace] = uint32_t(vertices.size()) - 1;
+					vertexLookup.emplace(key, tempIndices[iFace]);
+				}
 
-							if ('/' == file.peek())
-							{
-								file.ignore();
+				indices.push_back(tempIndices[0]);
+				if (flipAxisAndWinding)
+				{
+					indices.push_back(tempIndices[2]);
+					indices.push_back(tempIndices[1]);
+				}
+				else
+				{
+					indices.push_back(tempIndices[1]);
+					indices.push_back(tempIndices[2]);
+				}
+			}
 
-								// Optional vertex normal
-								file >> iNormal;
-								vertex.normal = normals[iNormal - 1];
-							}
-						}
+			if (flipAxisAndWinding)
+			{
+				for (Vertex_PosTex& vertex : vertices)
+				{
+					vertex.position.z *= -1.f;
+					vertex.normal.z *= -1.f;
+				}
+			}
 
-						vertices.push_back(vertex);
-						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
-						//indices.push_back(uint32_t(vertices.size()) - 1);
-					}
+			TangentGenerator::Generate(vertices, indices);
+
+			return true;
+		}
+
+		//Parses the text in numChunks blocks split at line boundaries, each on its own thread, and merges them in file order
+		static void ParseOBJChunks(const char* pBegin, const char* pEnd, uint32_t numChunks, ObjData& data)
+		{
+			const size_t size = static_cast<size_t>(pEnd - pBegin);
+
+			std::vector<const char*> boundaries(numChunks + 1, pEnd);
+			boundaries[0] = pBegin;
+			for (uint32_t i = 1; i < numChunks; ++i)
+			{
+				const char* pSplit = std::max(pBegin + size * i / numChunks, boundaries[i - 1]);
+				const char* pLineEnd = static_cast<const char*>(memchr(pSplit, '\n', pEnd - pSplit));
+				boundaries[i] = pLineEnd ? pLineEnd + 1 : pEnd;
+			}
 
-					indices.push_back(tempIndices[0]);
-					if (flipAxisAndWinding) 
+			//Parse every chunk into its own local arrays
+			std::vector<ObjData> chunks(numChunks);
+			ParallelFor(numChunks, [&](size_t begin, size_t end, uint32_t)
+				{
+					for (size_t i = begin; i < end; ++i)
 					{
-						indices.push_back(tempIndices[2]);
-						indices.push_back(tempIndices[1]);
+						ParseOBJText(boundaries[i], boundaries[i + 1], chunks[i]);
 					}
-					else
+				}, numChunks);
+
+			//Prefix sum the element counts so every chunk knows where its elements land
+			std::vector<ObjVertexKey> offsets(numChunks + 1);
+			std::vector<size_t> cornerOffsets(numChunks + 1);
+			for (uint32_t i = 0; i < numChunks; ++i)
+			{
+				offsets[i + 1].position = offsets[i].position + static_cast<uint32_t>(chunks[i].positions.size());
+				offsets[i + 1].uv = offsets[i].uv + static_cast<uint32_t>(chunks[i].UVs.size());
+				offsets[i + 1].normal = offsets[i].normal + static_cast<uint32_t>(chunks[i].normals.size());
+				cornerOffsets[i + 1] = cornerOffsets[i] + chunks[i].corners.size();
+			}
+
+			data.positions.resize(offsets[numChunks].position);
+			data.UVs.resize(offsets[numChunks].uv);
+			data.normals.resize(offsets[numChunks].normal);
+			data.corners.resize(cornerOffsets[numChunks]);
+			data.triangleMaterials.resize(cornerOffsets[numChunks] / 3);
+
+			//Map every chunk's material names onto the names of the whole file, in file order
+			//A chunk's first faces keep the material that was current at the end of the chunks before it
+			std::vector<std::vector<uint32_t>> materialRemaps(numChunks);
+			std::vector<uint32_t> inheritedMaterials(numChunks);
+			uint32_t currentMaterial{ ObjInheritedMaterial };
+			for (uint32_t i = 0; i < numChunks; ++i)
+			{
+				for (const std::string& name : chunks[i].materialNames)
+				{
+					const auto it = std::find(data.materialNames.begin(), data.materialNames.end(), name);
+					materialRemaps[i].push_back(static_cast<uint32_t>(it - data.materialNames.begin()));
+					if (it == data.materialNames.end())
+						data.materialNames.push_back(name);
+				}
+
+				inheritedMaterials[i] = currentMaterial;
+				if (chunks[i].currentMaterial != ObjInheritedMaterial)
+					currentMaterial = materialRemaps[i][chunks[i].currentMaterial];
+				if (data.materialLibrary.empty())
+					data.materialLibrary = chunks[i].materialLibrary;
+			}
+			data.currentMaterial = currentMaterial;
+
+			//Copy every chunk into place, resolving its relative indices on the way
+			ParallelFor(numChunks, [&](size_t begin, size_t end, uint32_t)
+				{
+					for (size_t i = begin; i < end; ++i)
 					{
-						indices.push_back(tempIndices[1]);
-						indices.push_back(tempIndices[2]);
+						const ObjData& chunk = chunks[i];
+						const ObjVertexKey& offset = offsets[i];
+
+						std::copy(chunk.positions.begin(), chunk.positions.end(), data.positions.begin() + offset.position);
+						std::copy(chunk.UVs.begin(), chunk.UVs.end(), data.UVs.begin() + offset.uv);
+						std::copy(chunk.normals.begin(), chunk.normals.end(), data.normals.begin() + offset.normal);
+
+						ObjVertexKey* pCorner = data.corners.data() + cornerOffsets[i];
+						for (const ObjVertexKey& key : chunk.corners)
+						{
+							pCorner->position = ResolveIndex(key.position, offset.position);
+							pCorner->uv = ResolveIndex(key.uv, offset.uv);
+							pCorner->normal = ResolveIndex(key.normal, offset.normal);
+							++pCorner;
+						}
+
+						uint32_t* pMaterial = data.triangleMaterials.data() + cornerOffsets[i] / 3;
+						for (const uint32_t material : chunk.triangleMaterials)
+						{
+							*pMaterial++ = material == ObjInheritedMaterial ? inheritedMaterials[i] : materialRemaps[i][material];
+						}
 					}
-				}
-				//read till end of line and ignore all remaining chars
-				file.ignore(1000, '\n');
+				}, numChunks);
+		}
+
+		//Faces before the first usemtl of the file get a material without a name, if there is a usemtl at all
+		static void ResolveStartMaterial(ObjData& data)
+		{
+			if (data.materialNames.empty())
+			{
+				data.triangleMaterials.clear();
+				return;
 			}
 
-			//Cheap Tangent Calculations
-			for (uint32_t i = 0; i < indices.size(); i += 3)
+			uint32_t startMaterial{ ObjInheritedMaterial };
+			for (uint32_t& material : data.triangleMaterials)
 			{
-				uint32_t index0 = indices[i];
-				uint32_t index1 = indices[size_t(i) + 1];
-				uint32_t index2 = indices[size_t(i) + 2];
+				if (material != ObjInheritedMaterial)
+					continue;
 
-				const Vector3& p0 = vertices[index0].position;
-				const Vector3& p1 = vertices[index1].position;
-				const Vector3& p2 = vertices[index2].position;
-				const Vector2& uv0 = vertices[index0].uv;
-				const Vector2& uv1 = vertices[index1].uv;
-				const Vector2& uv2 = vertices[index2].uv;
+				if (startMaterial == ObjInheritedMaterial)
+				{
+					const auto it = std::find(data.materialNames.begin(), data.materialNames.end(), std::string{});
+					startMaterial = static_cast<uint32_t>(it - data.materialNames.begin());
+					if (it == data.materialNames.end())
+						data.materialNames.emplace_back();
+				}
+				material = startMaterial;
+			}
+		}
+
+		//Parses vertices and indices, face corners sharing the same position/uv/normal are emitted as one vertex
+		//The triangles are grouped by usemtl material, see ObjMaterials
+		//numThreads = 0 picks a thread count based on the file size, the result is identical for any thread count
+		static bool ParseOBJ(const std::string& filename, std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, ObjMaterials& materials, bool flipAxisAndWinding = true, uint32_t numThreads = 0)
+		{
+			//The file is mapped and scanned in place, no per-token strings or stream extraction
+			const MappedFile file{ filename };
+			if (!file.IsOpen())
+				return false;
+
+			const char* pBegin = file.GetData();
+			const char* pEnd = pBegin + file.GetSize();
 
-				const Vector3 edge0 = p1 - p0;
-				const Vector3 edge1 = p2 - p0;
-				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
-				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-				float r = 1.f / Vector2::Cross(diffX, diffY);
+			if (numThreads == 0)
+				numThreads = GetNumWorkers(file.GetSize() / ObjMinBytesPerThread);
 
-				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
-				vertices[index0].tangent += tangent;
-				vertices[index1].tangent += tangent;
-				vertices[index2].tangent += tangent;
+			ObjData data{};
+			if (numThreads > 1)
+			{
+				ParseOBJChunks(pBegin, pEnd, numThreads, data);
 			}
+			else
+			{
+				ParseOBJText(pBegin, pEnd, data);
+				for (ObjVertexKey& key : data.corners)
+				{
+					key.position = ResolveIndex(key.position, 0);
+					key.uv = ResolveIndex(key.uv, 0);
+					key.normal = ResolveIndex(key.normal, 0);
+				}
+			}
+			ResolveStartMaterial(data);
+
+			materials.library = data.materialLibrary;
+			return BuildOBJMesh(data, vertices, indices, materials, flipAxisAndWinding);
+		}
+
+		static bool ParseOBJ(const std::string& filename, std::vector<Vertex_PosTex>& vertices, std::vector<uint32_t>& indices, bool flipAxisAndWinding = true, uint32_t numThreads = 0)
+		{
+			ObjMaterials materials{};
+			return ParseOBJ(filename, vertices, indices, materials, flipAxisAndWinding, numThreads);
+		}
+
+		//Reads the texture maps of every newmtl in a material library, the paths are made relative to the working directory
+		//Map options such as -bm or -o are skipped, the file name is the last thing on the line
+		static bool ParseMTL(const std::string& filename, std::unordered_map<std::string, Material>& materials)
+		{
+			const MappedFile file{ filename };
+			if (!file.IsOpen())
+				return false;
+
+			const size_t separator = filename.find_last_of("/\\");
+			const std::string directory = separator == std::string::npos ? std::string{} : filename.substr(0, separator + 1);
+
+			const auto parsePath = [&](const char* pCurrent, const char* pLineEnd)
+				{
+					//Only the last token is the path, unless the path itself has spaces and no options come before it
+					std::string path = ParseName(pCurrent, pLineEnd);
+					if (!path.empty() && path[0] == '-')
+					{
+						const size_t lastSpace = path.find_last_of(" \t");
+						path = path.substr(lastSpace + 1);
+					}
+					return directory + path;
+				};
 
-			//Create the Tangents (reject)
-			for (auto& v : vertices)
+			Material* pMaterial{};
+			const char* pCurrent = file.GetData();
+			const char* pEnd = pCurrent + file.GetSize();
+			while (pCurrent < pEnd)
 			{
-				v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+				const char* pLineEnd = static_cast<const char*>(memchr(pCurrent, '\n', pEnd - pCurrent));
+				if (!pLineEnd)
+					pLineEnd = pEnd;
 
-				if(flipAxisAndWinding)
+				pCurrent = SkipSpaces(pCurrent, pLineEnd);
+				if (IsCommand(pCurrent, pLineEnd, "newmtl"))
 				{
-					v.position.z *= -1.f;
-					v.normal.z *= -1.f;
-					v.tangent.z *= -1.f;
+					pMaterial = &materials[ParseName(pCurrent + 6, pLineEnd)];
+				}
+				else if (pMaterial && IsCommand(pCurrent, pLineEnd, "map_Kd"))
+				{
+					pMaterial->diffuseMap = parsePath(pCurrent + 6, pLineEnd);
+				}
+				else if (pMaterial && (IsCommand(pCurrent, pLineEnd, "map_Bump") || IsCommand(pCurrent, pLineEnd, "map_bump")))
+				{
+					pMaterial->normalMap = parsePath(pCurrent + 8, pLineEnd);
+				}
+				else if (pMaterial && (IsCommand(pCurrent, pLineEnd, "bump") || IsCommand(pCurrent, pLineEnd, "norm")))
+				{
+					pMaterial->normalMap = parsePath(pCurrent + 4, pLineEnd);
+				}
+				else if (pMaterial && IsCommand(pCurrent, pLineEnd, "map_Ks"))
+				{
+					pMaterial->specularMap = parsePath(pCurrent + 6, pLineEnd);
+				}
+				else if (pMaterial && IsCommand(pCurrent, pLineEnd, "map_Ns"))
+				{
+					pMaterial->glossMap = parsePath(pCurrent + 6, pLineEnd);
 				}
 
+				pCurrent = pLineEnd + 1;
 			}
-
 			return true;
 		}
 #pragma warning(pop)
 	}
-}
\ No newline at end of file
+}
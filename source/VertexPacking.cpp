@@ -0,0 +1,231 @@
+//-----------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------
+#include "pch.h"
+#include "VertexPacking.h"
+
+using namespace dae;
+
+
+//-----------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------
+namespace
+{
+	uint16_t ToUnorm16(float value)
+	{
+		return static_cast<uint16_t>(Saturate(value) * 65535.f + 0.5f);
+	}
+
+	int16_t ToSnorm16(float value)
+	{
+		return static_cast<int16_t>(roundf(Clamp(value, -1.f, 1.f) * 32767.f));
+	}
+
+	//Same rule the input assembler uses, -32768 and -32767 both map to -1
+	float FromSnorm16(int16_t value)
+	{
+		return std::max(value / 32767.f, -1.f);
+	}
+
+	//atan2 stays precise for tiny angles where acos of the dot product doesn't
+	float AngleDegrees(const Vector3& a, const Vector3& b)
+	{
+		return atan2f(Vector3::Cross(a, b).Magnitude(), Vector3::Dot(a, b)) * TO_DEGREES;
+	}
+}
+
+
+//-----------------------------------------------------------------
+// Public Functions
+//-----------------------------------------------------------------
+uint16_t VertexPacking::FloatToHalf(float value)
+{
+	uint32_t bits{};
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	const uint32_t exponent = (bits >> 23) & 0xFFu;
+	uint32_t mantissa = bits & 0x7FFFFFu;
+
+	//Inf and NaN
+	if (exponent == 0xFFu)
+		return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+
+	const int halfExponent = static_cast<int>(exponent) - 127 + 15;
+	if (halfExponent >= 0x1F)
+		return static_cast<uint16_t>(sign | 0x7C00u);
+
+	//Denormals and zero, shift in the implicit bit and round to nearest even
+	if (halfExponent <= 0)
+	{
+		if (halfExponent < -10)
+			return static_cast<uint16_t>(sign);
+
+		mantissa |= 0x800000u;
+		const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+		uint32_t half = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1u)))
+			++half;
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	//Normal numbers, a carry out of the mantissa correctly bumps the exponent
+	uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+	const uint32_t remainder = mantissa & 0x1FFFu;
+	if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+		++half;
+	return static_cast<uint16_t>(sign | half);
+}
+
+float VertexPacking::HalfToFloat(uint16_t value)
+{
+	const uint32_t sign = (value & 0x8000u) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1Fu;
+	uint32_t mantissa = value & 0x3FFu;
+
+	uint32_t bits{};
+	if (exponent == 0x1Fu)
+	{
+		bits = sign | 0x7F800000u | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+	else if (mantissa != 0)
+	{
+		//Normalize the denormal
+		int shift{};
+		while (!(mantissa & 0x400u))
+		{
+			mantissa <<= 1;
+			++shift;
+		}
+		bits = sign | (static_cast<uint32_t>(127 - 15 + 1 - shift) << 23) | ((mantissa & 0x3FFu) << 13);
+	}
+	else
+	{
+		bits = sign;
+	}
+
+	float result{};
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+void VertexPacking::EncodeOctahedral(const Vector3& direction, int16_t encoded[2])
+{
+	//Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the diagonals
+	const float length = fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z);
+	if (length <= FLT_EPSILON)
+	{
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+
+	float x = direction.x / length;
+	float y = direction.y / length;
+	if (direction.z < 0.f)
+	{
+		const float foldedX = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+		const float foldedY = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	encoded[0] = ToSnorm16(x);
+	encoded[1] = ToSnorm16(y);
+}
+
+Vector3 VertexPacking::DecodeOctahedral(const int16_t encoded[2])
+{
+	//Matches DecodeOctahedral in the shaders
+	Vector3 direction{ FromSnorm16(encoded[0]), FromSnorm16(encoded[1]), 0.f };
+	direction.z = 1.f - fabsf(direction.x) - fabsf(direction.y);
+
+	const float t = Saturate(-direction.z);
+	direction.x += direction.x >= 0.f ? -t : t;
+	direction.y += direction.y >= 0.f ? -t : t;
+
+	return direction.Normalized();
+}
+
+Vector3 VertexPacking::GetPositionScale(const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	return boundsMax - boundsMin;
+}
+
+Vertex_PosTexPacked VertexPacking::PackVertex(const Vertex_PosTex& vertex, const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	const Vector3 scale = GetPositionScale(boundsMin, boundsMax);
+	const Vector3 relative = vertex.position - boundsMin;
+
+	Vertex_PosTexPacked packed{};
+	packed.position[0] = ToUnorm16(scale.x > 0.f ? relative.x / scale.x : 0.f);
+	packed.position[1] = ToUnorm16(scale.y > 0.f ? relative.y / scale.y : 0.f);
+	packed.position[2] = ToUnorm16(scale.z > 0.f ? relative.z / scale.z : 0.f);
+	packed.position[3] = vertex.tangent.w < 0.f ? 0 : 65535;
+	EncodeOctahedral(vertex.normal, packed.normal);
+	EncodeOctahedral(vertex.tangent.GetXYZ(), packed.tangent);
+	packed.uv[0] = FloatToHalf(vertex.uv.x);
+	packed.uv[1] = FloatToHalf(vertex.uv.y);
+	return packed;
+}
+
+Vertex_PosTex VertexPacking::UnpackVertex(const Vertex_PosTexPacked& vertex, const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	const Vector3 scale = GetPositionScale(boundsMin, boundsMax);
+
+	Vertex_PosTex unpacked{};
+	unpacked.position.x = boundsMin.x + vertex.position[0] / 65535.f * scale.x;
+	unpacked.position.y = boundsMin.y + vertex.position[1] / 65535.f * scale.y;
+	unpacked.position.z = boundsMin.z + vertex.position[2] / 65535.f * scale.z;
+	unpacked.normal = DecodeOctahedral(vertex.normal);
+	unpacked.tangent = Vector4{ DecodeOctahedral(vertex.tangent), vertex.position[3] ? 1.f : -1.f };
+	unpacked.uv = Vector2{ HalfToFloat(vertex.uv[0]), HalfToFloat(vertex.uv[1]) };
+	return unpacked;
+}
+
+void VertexPacking::PackVertices(const Vertex_PosTex* pVertices, uint32_t numVertices, const Vector3& boundsMin, const Vector3& boundsMax, std::vector<Vertex_PosTexPacked>& packed)
+{
+	packed.resize(numVertices);
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		packed[i] = PackVertex(pVertices[i], boundsMin, boundsMax);
+	}
+}
+
+VertexPacking::PackingError VertexPacking::MeasureError(const Vertex_PosTex* pVertices, const Vertex_PosTexPacked* pPacked, uint32_t numVertices, const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	PackingError error{};
+	for (uint32_t i = 0; i < numVertices; ++i)
+	{
+		const Vertex_PosTex& original = pVertices[i];
+		const Vertex_PosTex unpacked = UnpackVertex(pPacked[i], boundsMin, boundsMax);
+
+		const Vector3 positionError = unpacked.position - original.position;
+		error.position = std::max({ error.position, fabsf(positionError.x), fabsf(positionError.y), fabsf(positionError.z) });
+		error.normalDegrees = std::max(error.normalDegrees, AngleDegrees(unpacked.normal, original.normal));
+		const float tangentDegrees = unpacked.tangent.w == original.tangent.w ? AngleDegrees(unpacked.tangent.GetXYZ(), original.tangent.GetXYZ()) : 180.f;
+		error.tangentDegrees = std::max(error.tangentDegrees, tangentDegrees);
+		error.uv = std::max({ error.uv, fabsf(unpacked.uv.x - original.uv.x), fabsf(unpacked.uv.y - original.uv.y) });
+	}
+	return error;
+}
+
+VertexPacking::PackingError VertexPacking::GetErrorBound(const Vector3& boundsMin, const Vector3& boundsMax)
+{
+	const Vector3 scale = GetPositionScale(boundsMin, boundsMax);
+
+	//A 16-bit octahedral map keeps the angular error below ~0.005 degrees
+	PackingError bound{};
+	const float magnitude = std::max({ fabsf(boundsMin.x), fabsf(boundsMin.y), fabsf(boundsMin.z), fabsf(boundsMax.x), fabsf(boundsMax.y), fabsf(boundsMax.z) });
+	bound.position = std::max({ scale.x, scale.y, scale.z }) / 65535.f * 0.5f + magnitude * FLT_EPSILON * 2.f;
+	bound.normalDegrees = 0.005f;
+	bound.tangentDegrees = 0.005f;
+	bound.uv = 1.f / 2048.f * 0.5f;
+	return bound;
+}
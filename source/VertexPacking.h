@@ -0,0 +1,38 @@
+#pragma once
+// Includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Conversion between Vertex_PosTex and the quantized Vertex_PosTexPacked
+	namespace VertexPacking
+	{
+		//Largest error of any vertex after a round trip
+		struct PackingError
+		{
+			float position{};		//World units
+			float normalDegrees{};
+			float tangentDegrees{};
+			float uv{};
+		};
+
+		uint16_t FloatToHalf(float value);
+		float HalfToFloat(uint16_t value);
+
+		void EncodeOctahedral(const Vector3& direction, int16_t encoded[2]);
+		Vector3 DecodeOctahedral(const int16_t encoded[2]);
+
+		//The shader rebuilds the position as unorm * scale + offset
+		Vector3 GetPositionScale(const Vector3& boundsMin, const Vector3& boundsMax);
+
+		Vertex_PosTexPacked PackVertex(const Vertex_PosTex& vertex, const Vector3& boundsMin, const Vector3& boundsMax);
+		Vertex_PosTex UnpackVertex(const Vertex_PosTexPacked& vertex, const Vector3& boundsMin, const Vector3& boundsMax);
+
+		void PackVertices(const Vertex_PosTex* pVertices, uint32_t numVertices, const Vector3& boundsMin, const Vector3& boundsMax, std::vector<Vertex_PosTexPacked>& packed);
+
+		PackingError MeasureError(const Vertex_PosTex* pVertices, const Vertex_PosTexPacked* pPacked, uint32_t numVertices, const Vector3& boundsMin, const Vector3& boundsMax);
+
+		//Worst case error of the encoding: half a quantization step for positions, half a half-float ulp for uvs in [-1, 1]
+		PackingError GetErrorBound(const Vector3& boundsMin, const Vector3& boundsMax);
+	}
+}
@@ -6,6 +6,8 @@
 
 #undef main
 #include "Renderer.h"
+#include "Benchmark.h"
+#include "TextureCooker.h"
 
 using namespace dae;
 
@@ -17,9 +19,33 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	//Run the CPU benchmarks instead of the renderer when asked for
+	if (argc > 1 && std::string(args[1]) == "--benchmark")
+	{
+		Benchmark::Run(argc > 2 ? args[2] : "Resources/vehicle.obj");
+		return 0;
+	}
+
+	//Cook the scene textures into DDS files next to them, "--cook fast" trades quality for cooking time
+	//The scenes sample the gloss map from the alpha of the specular map, so those two are cooked as one texture
+	if (argc > 1 && std::string(args[1]) == "--cook")
+	{
+		const BlockCompressor::Quality quality = argc > 2 && std::string(args[2]) == "fast" ? BlockCompressor::Quality::Fast : BlockCompressor::Quality::High;
+		TextureCooker::Cook({ "Resources/uv_grid_2.png", TextureUsage::Color }, quality);
+		TextureCooker::Cook({ "Resources/vehicle_diffuse.png", TextureUsage::Color }, quality);
+		TextureCooker::Cook({ "Resources/vehicle_normal.png", TextureUsage::Normal }, quality);
+		TextureCooker::Cook({ "Resources/vehicle_specular.png", TextureUsage::Data, "Resources/vehicle_gloss.png" }, quality);
+		TextureCooker::Cook({ "Resources/fireFX_diffuse.png", TextureUsage::Color }, quality);
+		return 0;
+	}
+
+	//Compare the static mesh scene with and without batching on a headless renderer
+	if (argc > 1 && std::string(args[1]) == "--batching")
+	{
+		Renderer renderer{ 640, 480 };
+		renderer.RunStaticBatchingTest();
+		return 0;
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
@@ -60,6 +86,8 @@ int main(int argc, char* args[])
 				//if (e.key.keysym.scancode == SDL_SCANCODE_X)
 				if (e.key.keysym.scancode == SDL_SCANCODE_F2)
 					pRenderer->ToggleSamplerStates();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F3)
+					pRenderer->ToggleVertexFormat();
 				break;
 			default: ;
 			}